@@ -3,7 +3,7 @@
 
 #include <stddef.h>
 
-enum { ACA_GDBSTUB_SUCCESS, ACA_GDBSTUB_ALLOC_FAILED };
+enum { ACA_GDBSTUB_SUCCESS, ACA_GDBSTUB_ALLOC_FAILED, ACA_GDBSTUB_DISCONNECTED };
 enum {
     ACA_GDBSTUB_SOFT_BREAKPOINT = (1 << 0),
     ACA_GDBSTUB_HARD_BREAKPOINT = (1 << 1),
@@ -31,6 +31,28 @@ typedef struct {
     unsigned int o_enableLogging : 1;
 } aca_gdbstub_opts;
 
+// Max packet size advertised to GDB in the qSupported reply (unless set in the context)
+#ifndef ACA_GDBSTUB_PACKET_SIZE
+#define ACA_GDBSTUB_PACKET_SIZE 4096
+#endif
+
+// Size of the receive buffer that block reads are parsed from
+#ifndef ACA_GDBSTUB_RECV_BUFFER_SIZE
+#define ACA_GDBSTUB_RECV_BUFFER_SIZE 1024
+#endif
+
+// Optional block callbacks - when set, these are used instead of the per-char/per-byte stubs so a
+// whole packet costs one driver/syscall (e.g. send()/recv() on a socket) and one memory access
+typedef struct {
+    void   (*write)(const char *buf, size_t len, void *usrData); // Write all len bytes to GDB
+    // Read 1..maxLen bytes (blocking) - 0 = GDB disconnected or the transport failed
+    size_t (*read)(char *buf, size_t maxLen, void *usrData);
+    // Read up to len bytes of target memory - returns bytes read (0 = unreadable)
+    size_t (*readMem)(size_t addr, unsigned char *buf, size_t len, void *usrData);
+    // Write len bytes of target memory - returns ACA_GDBSTUB_SUCCESS or a non-zero error
+    int    (*writeMem)(size_t addr, const unsigned char *buf, size_t len, void *usrData);
+} aca_gdbstub_block_ops;
+
 typedef struct {
     char            *regs;      // Pointer to register array
     size_t           regsSize;  // Size of register array in bytes
@@ -39,6 +61,13 @@ typedef struct {
     aca_gdbstub_opts opts;      // Options bitfield
     int              err;       // Return-error code
     void            *usrData;   // Optional handle to opaque user data
+
+    size_t                packetSize;                               // 0 = ACA_GDBSTUB_PACKET_SIZE
+    aca_gdbstub_block_ops blockOps;                                 // Optional block I/O callbacks
+    char                  recvBuffer[ACA_GDBSTUB_RECV_BUFFER_SIZE]; // Data from blockOps.read
+    size_t                recvUsed;                                 // Bytes in recvBuffer
+    size_t                recvOffset;                               // Next unparsed byte
+    int                   noAckMode;                                // Set by QStartNoAckMode
 } aca_gdbstub_context;
 
 // User-implemented functions for target-specific operations - these must be implemented by the user
@@ -63,6 +92,10 @@ void acaGdbstubSendRegs(aca_gdbstub_context *gdbstubObj);
 void acaGdbstubSendReg(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt);
 void acaGdbstubWriteMem(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt);
 void acaGdbstubReadMem(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt);
+void acaGdbstubWriteMemBinary(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt);
+void acaGdbstubReadMemBinary(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt);
+void acaGdbstubProcessQuery(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt);
+void acaGdbstubProcessSet(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt);
 void acaGdbstubSendSignal(aca_gdbstub_context *gdbstubObj);
 void acaGdbstubProcessBreakpoint(aca_gdbstub_context *gdbstubObj,
                                  aca_gdb_packet      *recvPkt,
@@ -99,6 +132,14 @@ void acaDynamicCharBufferFree(aca_dynamic_char_buffer *buf);
             return;                                                                                \
         }                                                                                          \
     } while (0)
+// Same as ACA_GDBSTUB_CHECK_RET, but jumps to a cleanup label instead of returning
+#define ACA_GDBSTUB_CHECK_GOTO(ret, gdbstubObj, label)                                             \
+    do {                                                                                           \
+        gdbstubObj->err = ret;                                                                     \
+        if (gdbstubObj->err != ACA_GDBSTUB_SUCCESS) {                                              \
+            goto label;                                                                            \
+        }                                                                                          \
+    } while (0)
 
 int acaDynamicCharBufferInit(aca_dynamic_char_buffer *buf, size_t startSize) {
     buf->buffer = (char *)malloc(startSize * sizeof(char));
@@ -143,23 +184,63 @@ void acaGdbstubComputeChecksum(char *buffer, size_t len, char *outBuf) {
     }
 }
 
+// Write to GDB - in one call w/ the block callback, otherwise char by char
+static void acaGdbstubWrite(aca_gdbstub_context *gdbstubObj, const char *data, size_t len) {
+    if (gdbstubObj->blockOps.write != NULL) {
+        gdbstubObj->blockOps.write(data, len, gdbstubObj->usrData);
+        return;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        acaGdbstubPutcharStub(data[i], gdbstubObj->usrData);
+    }
+}
+
+// Read the next char from GDB - block reads are buffered in the context and parsed from there. A
+// block read of 0 bytes sets err to ACA_GDBSTUB_DISCONNECTED (the returned char is meaningless)
+static char acaGdbstubGetchar(aca_gdbstub_context *gdbstubObj) {
+    if (gdbstubObj->blockOps.read == NULL) {
+        return acaGdbstubGetcharStub(gdbstubObj->usrData);
+    }
+    if (gdbstubObj->recvOffset >= gdbstubObj->recvUsed) {
+        gdbstubObj->recvUsed   = gdbstubObj->blockOps.read(gdbstubObj->recvBuffer,
+                                                         sizeof(gdbstubObj->recvBuffer),
+                                                         gdbstubObj->usrData);
+        gdbstubObj->recvOffset = 0;
+        if (gdbstubObj->recvUsed == 0) {
+            gdbstubObj->err = ACA_GDBSTUB_DISCONNECTED;
+            return 0;
+        }
+    }
+    return gdbstubObj->recvBuffer[gdbstubObj->recvOffset++];
+}
+
 void acaGdbstubSend(const char *data, aca_gdbstub_context *gdbstubObj) {
     size_t len = strlen(data);
     if (gdbstubObj->opts.o_enableLogging) {
         ACA_GDBSTUB_LOG(ACA_GDBSTUB_SEND " : packet = %s\n", data);
     }
-    for (size_t i = 0; i < len; ++i) {
-        acaGdbstubPutcharStub(data[i], gdbstubObj->usrData);
+    acaGdbstubWrite(gdbstubObj, data, len);
+}
+
+// Send an ack/nack for a received packet - there are none once GDB started no-ack mode
+static void acaGdbstubSendAck(aca_gdbstub_context *gdbstubObj, const char *ack) {
+    if (!gdbstubObj->noAckMode) {
+        acaGdbstubSend(ack, gdbstubObj);
     }
 }
 
+// Receive the next valid packet - err is set (and the packet incomplete) if GDB disconnects
 void acaGdbstubRecv(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *gdbPkt) {
     int  currentOffset = 0;
     char c;
+    gdbstubObj->err = ACA_GDBSTUB_SUCCESS;
     while (1) {
         // Get the beginning of the packet data '$'
         while (1) {
-            c = acaGdbstubGetcharStub(gdbstubObj->usrData);
+            c = acaGdbstubGetchar(gdbstubObj);
+            if (gdbstubObj->err != ACA_GDBSTUB_SUCCESS) {
+                return;
+            }
             if (c == '$') {
                 break;
             }
@@ -167,11 +248,17 @@ void acaGdbstubRecv(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *gdbPkt) {
 
         // Read packet data until the end '#' - then read the remaining 2 checksum digits
         while (1) {
-            c = acaGdbstubGetcharStub(gdbstubObj->usrData);
+            c = acaGdbstubGetchar(gdbstubObj);
+            if (gdbstubObj->err != ACA_GDBSTUB_SUCCESS) {
+                return;
+            }
             if (c == '#') {
-                gdbPkt->checksum[0] = acaGdbstubGetcharStub(gdbstubObj->usrData);
-                gdbPkt->checksum[1] = acaGdbstubGetcharStub(gdbstubObj->usrData);
+                gdbPkt->checksum[0] = acaGdbstubGetchar(gdbstubObj);
+                gdbPkt->checksum[1] = acaGdbstubGetchar(gdbstubObj);
                 gdbPkt->checksum[2] = 0;
+                if (gdbstubObj->err != ACA_GDBSTUB_SUCCESS) {
+                    return;
+                }
                 ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&gdbPkt->pktData, 0), gdbstubObj);
                 break;
             }
@@ -185,7 +272,8 @@ void acaGdbstubRecv(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *gdbPkt) {
         acaGdbstubComputeChecksum(gdbPkt->pktData.buffer, currentOffset, actualChecksum);
         if (strcmp(gdbPkt->checksum, actualChecksum) != 0) {
             gdbPkt->pktData.used = 0;
-            acaGdbstubSend(ACA_GDBSTUB_RESEND_PACKET, gdbstubObj);
+            currentOffset        = 0;
+            acaGdbstubSendAck(gdbstubObj, ACA_GDBSTUB_RESEND_PACKET);
             continue;
         }
 
@@ -194,7 +282,7 @@ void acaGdbstubRecv(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *gdbPkt) {
             ACA_GDBSTUB_LOG(
                 ACA_GDBSTUB_RECV " : packet = $%s#%s\n", gdbPkt->pktData.buffer, gdbPkt->checksum);
         }
-        acaGdbstubSend(ACA_GDBSTUB_ACK_PACKET, gdbstubObj);
+        acaGdbstubSendAck(gdbstubObj, ACA_GDBSTUB_ACK_PACKET);
         return;
     }
 }
@@ -286,6 +374,45 @@ void acaGdbstubSendReg(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt)
     }
 }
 
+// Call user write memory handler - once w/ the block callback, otherwise byte by byte - then reply
+// OK/error to GDB
+static void acaGdbstubWriteMemData(aca_gdbstub_context *gdbstubObj,
+                                   size_t               address,
+                                   const unsigned char *data,
+                                   size_t               length) {
+    int ret = ACA_GDBSTUB_SUCCESS;
+    if (gdbstubObj->blockOps.writeMem != NULL) {
+        ret = gdbstubObj->blockOps.writeMem(address, data, length, gdbstubObj->usrData);
+    } else {
+        for (size_t i = 0; i < length; ++i) {
+            acaGdbstubWriteMemStub(address + i, data[i], gdbstubObj->usrData);
+        }
+    }
+    acaGdbstubSend((ret == ACA_GDBSTUB_SUCCESS) ? ACA_GDBSTUB_OK_PACKET : ACA_GDBSTUB_ERROR_PACKET,
+                   gdbstubObj);
+}
+
+// Packet size advertised to GDB - replies are never built past it
+static size_t acaGdbstubPacketSize(aca_gdbstub_context *gdbstubObj) {
+    return (gdbstubObj->packetSize != 0) ? gdbstubObj->packetSize : ACA_GDBSTUB_PACKET_SIZE;
+}
+
+// Call user read memory handler - once w/ the block callback, otherwise byte by byte - returns the
+// number of bytes read into data
+static size_t acaGdbstubReadMemData(aca_gdbstub_context *gdbstubObj,
+                                    size_t               address,
+                                    unsigned char       *data,
+                                    size_t               length) {
+    if (gdbstubObj->blockOps.readMem != NULL) {
+        size_t readLen = gdbstubObj->blockOps.readMem(address, data, length, gdbstubObj->usrData);
+        return (readLen < length) ? readLen : length;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = acaGdbstubReadMemStub(address + i, gdbstubObj->usrData);
+    }
+    return length;
+}
+
 void acaGdbstubWriteMem(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt) {
     size_t address, length;
     int    lengthOffset = 0;
@@ -315,23 +442,26 @@ void acaGdbstubWriteMem(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt
     ACA_GDBSTUB_HEX_DECODE_ASCII(&recvPkt->pktData.buffer[1], address);
     ACA_GDBSTUB_HEX_DECODE_ASCII(&recvPkt->pktData.buffer[lengthOffset], length);
 
-    // Call user write memory handler
+    // Decode the data in place (each byte takes the spot of its first hex digit or earlier)
+    unsigned char *data = (unsigned char *)&recvPkt->pktData.buffer[valOffset];
     for (size_t i = 0; i < length; ++i) {
         int  decodedVal;
-        char atoiBuf[8];
-        atoiBuf[0] = recvPkt->pktData.buffer[valOffset + (i * 2)];
-        atoiBuf[1] = recvPkt->pktData.buffer[valOffset + (i * 2) + 1];
+        char atoiBuf[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        atoiBuf[0]      = recvPkt->pktData.buffer[valOffset + (i * 2)];
+        atoiBuf[1]      = recvPkt->pktData.buffer[valOffset + (i * 2) + 1];
         ACA_GDBSTUB_HEX_DECODE_ASCII(atoiBuf, decodedVal);
-        acaGdbstubWriteMemStub(address + i, (unsigned char)decodedVal, gdbstubObj->usrData);
+        data[i] = (unsigned char)decodedVal;
     }
 
-    // Send ACK to GDB
-    acaGdbstubSend(ACA_GDBSTUB_ACK_PACKET, gdbstubObj);
+    acaGdbstubWriteMemData(gdbstubObj, address, data, length);
 }
 
 void acaGdbstubReadMem(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt) {
-    size_t address, length;
-    int    valOffset = 0;
+    size_t                  address, length, readLen;
+    long                    lengthVal;
+    int                     valOffset = 0;
+    unsigned char          *data      = NULL;
+    aca_dynamic_char_buffer memBuf    = {0};
     for (int i = 0; recvPkt->pktData.buffer[i] != 0; ++i) {
         if ((recvPkt->pktData.buffer[i] == ',') || (recvPkt->pktData.buffer[i] == ';') ||
             (recvPkt->pktData.buffer[i] == ':')) {
@@ -342,17 +472,38 @@ void acaGdbstubReadMem(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt)
         ++valOffset;
     }
     ACA_GDBSTUB_HEX_DECODE_ASCII(&recvPkt->pktData.buffer[1], address);
-    ACA_GDBSTUB_HEX_DECODE_ASCII(&recvPkt->pktData.buffer[valOffset], length);
+    ACA_GDBSTUB_HEX_DECODE_ASCII(&recvPkt->pktData.buffer[valOffset], lengthVal);
+
+    // The hex reply ('$' + 2 chars per byte + '#xx') must fit in a packet - this also refuses a
+    // negative length before it wraps the allocation below
+    size_t packetSize = acaGdbstubPacketSize(gdbstubObj);
+    if ((lengthVal < 0) || (packetSize < 4) || ((size_t)lengthVal > (packetSize - 4) / 2)) {
+        acaGdbstubSend(ACA_GDBSTUB_ERROR_PACKET, gdbstubObj);
+        return;
+    }
+    length = (size_t)lengthVal;
+
+    data = (unsigned char *)malloc(length + 1);
+    if (data == NULL) {
+        ACA_GDBSTUB_LOG("Failed to alloc memory!\n");
+        ACA_GDBSTUB_CHECK_GOTO(ACA_GDBSTUB_ALLOC_FAILED, gdbstubObj, cleanup);
+    }
+    readLen = acaGdbstubReadMemData(gdbstubObj, address, data, length);
+
+    // Nothing readable - reply w/ an error, a partial read is sent as the shorter reply
+    if ((readLen == 0) && (length != 0)) {
+        acaGdbstubSend(ACA_GDBSTUB_ERROR_PACKET, gdbstubObj);
+        goto cleanup;
+    }
 
     // Alloc a packet w/ the requested data to send as a response to GDB
-    aca_dynamic_char_buffer memBuf;
-    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInit(&memBuf, length), gdbstubObj);
-    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&memBuf, '$'), gdbstubObj);
+    ACA_GDBSTUB_CHECK_GOTO(
+        acaDynamicCharBufferInit(&memBuf, (readLen * 2) + 8), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, '$'), gdbstubObj, cleanup);
 
-    // Call user read memory handler
-    for (size_t i = 0; i < length; ++i) {
+    for (size_t i = 0; i < readLen; ++i) {
         char          itoaBuff[8];
-        unsigned char c = acaGdbstubReadMemStub(address + i, gdbstubObj->usrData);
+        unsigned char c = data[i];
         ACA_GDBSTUB_HEX_ENCODE_ASCII(c, 3, itoaBuff);
 
         // Swap if single digit
@@ -361,21 +512,163 @@ void acaGdbstubReadMem(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt)
             itoaBuff[0] = '0';
         }
 
-        ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&memBuf, itoaBuff[0]), gdbstubObj);
-        ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&memBuf, itoaBuff[1]), gdbstubObj);
+        ACA_GDBSTUB_CHECK_GOTO(
+            acaDynamicCharBufferInsert(&memBuf, itoaBuff[0]), gdbstubObj, cleanup);
+        ACA_GDBSTUB_CHECK_GOTO(
+            acaDynamicCharBufferInsert(&memBuf, itoaBuff[1]), gdbstubObj, cleanup);
     }
 
     // Compute and append the checksum
-    char   checksum[8];
-    size_t len = memBuf.used - 1;
-    acaGdbstubComputeChecksum(&memBuf.buffer[1], len, checksum);
-    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&memBuf, '#'), gdbstubObj);
-    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&memBuf, checksum[0]), gdbstubObj);
-    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&memBuf, checksum[1]), gdbstubObj);
-    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&memBuf, 0), gdbstubObj);
+    char checksum[8];
+    acaGdbstubComputeChecksum(&memBuf.buffer[1], memBuf.used - 1, checksum);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, '#'), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, checksum[0]), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, checksum[1]), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, 0), gdbstubObj, cleanup);
 
     acaGdbstubSend((const char *)memBuf.buffer, gdbstubObj);
+
+cleanup:
     acaDynamicCharBufferFree(&memBuf);
+    free(data);
+}
+
+// Parse the 'addr,length' of a X/x packet - returns a pointer past the length (NULL if malformed)
+static char *acaGdbstubParseMemRange(aca_gdb_packet *recvPkt, size_t *address, size_t *length) {
+    char *end;
+    *address = (size_t)strtoull(&recvPkt->pktData.buffer[1], &end, 16);
+    if (*end != ',') {
+        return NULL;
+    }
+    *length = (size_t)strtoull(end + 1, &end, 16);
+    return end;
+}
+
+void acaGdbstubWriteMemBinary(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt) {
+    size_t address, length;
+    char  *data = acaGdbstubParseMemRange(recvPkt, &address, &length);
+    if ((data == NULL) || (*data != ':')) {
+        acaGdbstubSend(ACA_GDBSTUB_ERROR_PACKET, gdbstubObj);
+        return;
+    }
+
+    // Undo the '}' escapes in place - the packet ends before the NUL that Recv appended
+    unsigned char *in      = (unsigned char *)data + 1;
+    unsigned char *inEnd   = (unsigned char *)&recvPkt->pktData.buffer[recvPkt->pktData.used - 1];
+    unsigned char *out     = in;
+    size_t         decoded = 0;
+    while ((in < inEnd) && (decoded < length)) {
+        unsigned char c = *in++;
+        if ((c == '}') && (in < inEnd)) {
+            c = *in++ ^ 0x20;
+        }
+        out[decoded++] = c;
+    }
+    if (decoded != length) {
+        acaGdbstubSend(ACA_GDBSTUB_ERROR_PACKET, gdbstubObj);
+        return;
+    }
+
+    // A zero length write is GDB probing for 'X' support
+    acaGdbstubWriteMemData(gdbstubObj, address, out, length);
+}
+
+void acaGdbstubReadMemBinary(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt) {
+    size_t                  address, length, readLen;
+    unsigned char          *data   = NULL;
+    aca_dynamic_char_buffer memBuf = {0};
+    // The reply ('$b' + the data + '#xx') must fit in a packet, escapes aside - this also keeps a
+    // huge length from wrapping the allocation below
+    size_t packetSize = acaGdbstubPacketSize(gdbstubObj);
+    if ((acaGdbstubParseMemRange(recvPkt, &address, &length) == NULL) || (packetSize < 5) ||
+        (length > packetSize - 5)) {
+        acaGdbstubSend(ACA_GDBSTUB_ERROR_PACKET, gdbstubObj);
+        return;
+    }
+    data = (unsigned char *)malloc(length + 1);
+    if (data == NULL) {
+        ACA_GDBSTUB_LOG("Failed to alloc memory!\n");
+        ACA_GDBSTUB_CHECK_GOTO(ACA_GDBSTUB_ALLOC_FAILED, gdbstubObj, cleanup);
+    }
+    readLen = acaGdbstubReadMemData(gdbstubObj, address, data, length);
+    if ((readLen == 0) && (length != 0)) {
+        acaGdbstubSend(ACA_GDBSTUB_ERROR_PACKET, gdbstubObj);
+        goto cleanup;
+    }
+
+    // Reply is 'b' + the raw bytes w/ the packet framing chars escaped as '}' + (byte ^ 0x20)
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInit(&memBuf, readLen + 8), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, '$'), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, 'b'), gdbstubObj, cleanup);
+    for (size_t i = 0; i < readLen; ++i) {
+        char c = (char)data[i];
+        if ((c == '#') || (c == '$') || (c == '}') || (c == '*')) {
+            ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, '}'), gdbstubObj, cleanup);
+            c ^= 0x20;
+        }
+        ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, c), gdbstubObj, cleanup);
+    }
+
+    // Compute and append the checksum - the data may hold NULs, so send w/ an explicit length
+    char checksum[8];
+    acaGdbstubComputeChecksum(&memBuf.buffer[1], memBuf.used - 1, checksum);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, '#'), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, checksum[0]), gdbstubObj, cleanup);
+    ACA_GDBSTUB_CHECK_GOTO(acaDynamicCharBufferInsert(&memBuf, checksum[1]), gdbstubObj, cleanup);
+    if (gdbstubObj->opts.o_enableLogging) {
+        ACA_GDBSTUB_LOG(ACA_GDBSTUB_SEND " : binary packet = %zu bytes\n", readLen);
+    }
+    acaGdbstubWrite(gdbstubObj, memBuf.buffer, memBuf.used);
+
+cleanup:
+    acaDynamicCharBufferFree(&memBuf);
+    free(data);
+}
+
+// Frame and send a text reply
+static void acaGdbstubSendText(aca_gdbstub_context *gdbstubObj, const char *text) {
+    aca_dynamic_char_buffer sendPkt;
+    size_t                  len = strlen(text);
+    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInit(&sendPkt, len + 8), gdbstubObj);
+    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&sendPkt, '$'), gdbstubObj);
+    for (size_t i = 0; i < len; ++i) {
+        ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&sendPkt, text[i]), gdbstubObj);
+    }
+    char checksum[8];
+    acaGdbstubComputeChecksum(&sendPkt.buffer[1], len, checksum);
+    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&sendPkt, '#'), gdbstubObj);
+    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&sendPkt, checksum[0]), gdbstubObj);
+    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&sendPkt, checksum[1]), gdbstubObj);
+    ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInsert(&sendPkt, 0), gdbstubObj);
+
+    acaGdbstubSend((const char *)sendPkt.buffer, gdbstubObj);
+    acaDynamicCharBufferFree(&sendPkt);
+}
+
+void acaGdbstubProcessQuery(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt) {
+    // Features - 'x' reads are advertised here ('X' writes are probed by GDB w/ a zero length 'X')
+    if (strncmp(recvPkt->pktData.buffer, "qSupported", 10) == 0) {
+        char   features[96];
+        size_t packetSize = gdbstubObj->packetSize;
+        packetSize        = (packetSize != 0) ? packetSize : ACA_GDBSTUB_PACKET_SIZE;
+        snprintf(features,
+                 sizeof(features),
+                 "PacketSize=%lx;QStartNoAckMode+;binary-upload+",
+                 (unsigned long)packetSize);
+        acaGdbstubSendText(gdbstubObj, features);
+        return;
+    }
+    acaGdbstubSend(ACA_GDBSTUB_EMPTY_PACKET, gdbstubObj);
+}
+
+void acaGdbstubProcessSet(aca_gdbstub_context *gdbstubObj, aca_gdb_packet *recvPkt) {
+    // No more acks after the OK (GDB still acks the OK itself)
+    if (strcmp(recvPkt->pktData.buffer, "QStartNoAckMode") == 0) {
+        acaGdbstubSend(ACA_GDBSTUB_OK_PACKET, gdbstubObj);
+        gdbstubObj->noAckMode = 1;
+        return;
+    }
+    acaGdbstubSend(ACA_GDBSTUB_EMPTY_PACKET, gdbstubObj);
 }
 
 void acaGdbstubSendSignal(aca_gdbstub_context *gdbstubObj) {
@@ -443,7 +736,7 @@ void acaGdbstubProcessBreakpoint(aca_gdbstub_context *gdbstubObj,
     acaGdbstubProcessBreakpointStub(type, address, gdbstubObj->usrData);
 
     // Send ACK + OK to GDB
-    acaGdbstubSend(ACA_GDBSTUB_ACK_PACKET, gdbstubObj);
+    acaGdbstubSendAck(gdbstubObj, ACA_GDBSTUB_ACK_PACKET);
     acaGdbstubSend(ACA_GDBSTUB_OK_PACKET, gdbstubObj);
 }
 
@@ -452,11 +745,15 @@ void acaGdbstubProcess(aca_gdbstub_context *gdbstubObj) {
     if (gdbstubObj->opts.o_signalOnEntry) {
         acaGdbstubSendSignal(gdbstubObj);
     }
-    // Poll and reply to packets from GDB until exit-related command
+    // Poll and reply to packets from GDB until exit-related command (or GDB is gone)
     while (1) {
         aca_gdb_packet recvPkt;
         ACA_GDBSTUB_CHECK_RET(acaDynamicCharBufferInit(&recvPkt.pktData, 256), gdbstubObj);
         acaGdbstubRecv(gdbstubObj, &recvPkt);
+        if (gdbstubObj->err != ACA_GDBSTUB_SUCCESS) {
+            acaDynamicCharBufferFree(&recvPkt.pktData);
+            return;
+        }
 
         switch (recvPkt.commandType) {
             case 'g': { // Read registers
@@ -483,6 +780,22 @@ void acaGdbstubProcess(aca_gdbstub_context *gdbstubObj) {
                 acaGdbstubWriteMem(gdbstubObj, &recvPkt);
                 break;
             }
+            case 'x': { // Read mem (binary)
+                acaGdbstubReadMemBinary(gdbstubObj, &recvPkt);
+                break;
+            }
+            case 'X': { // Write mem (binary)
+                acaGdbstubWriteMemBinary(gdbstubObj, &recvPkt);
+                break;
+            }
+            case 'q': { // General query
+                acaGdbstubProcessQuery(gdbstubObj, &recvPkt);
+                break;
+            }
+            case 'Q': { // General set
+                acaGdbstubProcessSet(gdbstubObj, &recvPkt);
+                break;
+            }
             case 'c': { // Continue
                 acaGdbstubContinueStub(gdbstubObj->usrData);
                 return;
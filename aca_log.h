@@ -2,6 +2,8 @@
 #define ACA_LOG_H
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
 
 // color escape codes
 // usage: fprintf(stdout, "%sINFO%s: ...\n", ACA_LOG_COLOR_GREEN, ACA_LOG_COLOR_RESET);
@@ -29,8 +31,11 @@ typedef void(aca_log_handler)(
     aca_log_level level, const char *file, int line, const char *fmt, va_list args);
 
 void             acaLog(aca_log_level level, const char *file, int line, const char *fmt, ...);
-void             acaLogSetHandler(aca_log_handler *handler);
+void             acaLogSetHandler(aca_log_handler *handler); // NULL = use the default handler
 aca_log_handler *acaLogGetHandler(void);
+// process-wide handler for threads that never set their own (default: acaLogStandardHandler)
+void             acaLogSetDefaultHandler(aca_log_handler *handler);
+aca_log_handler *acaLogGetDefaultHandler(void);
 
 // provided log handlers
 ACA_LOG_HANDLER(acaLogStandardHandler);
@@ -38,22 +43,789 @@ ACA_LOG_HANDLER(acaLogBasicHandler);
 ACA_LOG_HANDLER(acaLogNullHandler);
 ACA_LOG_HANDLER(acaLogStandardFileHandler);
 
+// sparse time index - a sidecar file (<log>.idx) maps every ~N KiB block of a standard format log
+// to the time span and levels of its records, so a query only reads the blocks that can match.
+// acaLogStandardFileHandler keeps one when ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB is defined,
+// that index places records in unix time. a built one uses the log's own timestamps, as a scan does
+int  acaLogIndexBuild(FILE *log, FILE *index, size_t blockBytes); // indexes an existing log file
+long acaLogIndexQuery(FILE         *log,
+                      FILE         *index, // NULL = scan the whole log
+                      double        from,
+                      double        to,
+                      aca_log_level minLevel,
+                      FILE         *out,
+                      size_t       *scanned); // optional - log bytes read
+
+// async handler - records are captured on the calling thread and written by a background thread
+typedef enum aca_log_async_full_behavior {
+    ACA_LOG_ASYNC_DROP,   // drop new records while the queue is full
+    ACA_LOG_ASYNC_BLOCK,  // caller waits for the writer thread to free a slot
+    ACA_LOG_ASYNC_SAMPLE, // keep 1-in-sampleRate records once 3/4 full, drop when full
+} aca_log_async_full_behavior;
+
+typedef struct aca_log_async_config {
+    size_t                      capacity;     // record slots, rounded up to pow2 (default: 1024)
+    aca_log_async_full_behavior fullBehavior; // back-pressure policy when the queue fills up
+    unsigned int                sampleRate;   // only for ACA_LOG_ASYNC_SAMPLE (default: 8)
+    FILE                       *fp;           // writer thread output (default: stdout)
+} aca_log_async_config;
+
+int    acaLogAsyncStart(const aca_log_async_config *config);
+void   acaLogAsyncFlush(void);
+void   acaLogAsyncStop(void);
+size_t acaLogAsyncDropped(void);
+ACA_LOG_HANDLER(acaLogAsyncHandler);
+
+// buffered file handler - keeps the log file open behind a large user-space buffer and rotates it
+// (a flusher thread pushes the buffer out after flushInterval when no further record arrives)
+typedef struct aca_log_file_config {
+    const char   *path;           // log file path
+    size_t        bufferSize;     // user-space buffer bytes (flushes when full)
+    double        flushInterval;  // max seconds between flushes (0 = no interval flush)
+    aca_log_level flushLevel;     // records at/above this level flush immediately
+    size_t        rotateBytes;    // rotate once the file reaches this size (0 = never)
+    double        rotateInterval; // rotate after the file has been open N seconds (0 = never)
+    unsigned int  maxFiles;       // rotated files retained as path.1 (newest) ... path.N (oldest)
+} aca_log_file_config;
+
+#define ACA_LOG_FILE_CONFIG_INIT {"dump.log", 64 * 1024, 1.0, ACA_LOG_ERROR, 0, 0.0, 5}
+
+int  acaLogFileOpen(const aca_log_file_config *config);
+void acaLogFileFlush(void);
+void acaLogFileClose(void);
+ACA_LOG_HANDLER(acaLogBufferedFileHandler);
+
+// mmap segment handler - records are memcpy'd into a preallocated, memory-mapped segment file and
+// the kernel does the writeback, a new segment (path.000000, path.000001, ...) is rolled in when
+// one fills up (the next segment is preallocated ahead, so a roll is just a pointer swap). unused
+// segment space stays zeroed, so the first NUL byte marks the end of valid data (segments are
+// trimmed to their data when closed cleanly). POSIX only
+typedef struct aca_log_mmap_config {
+    const char *path;        // segment path prefix
+    size_t      segmentSize; // bytes preallocated per segment
+} aca_log_mmap_config;
+
+#define ACA_LOG_MMAP_CONFIG_INIT {"dump.log", 16 * 1024 * 1024}
+
+int  acaLogMmapOpen(const aca_log_mmap_config *config);
+void acaLogMmapSync(void);
+void acaLogMmapClose(void);
+ACA_LOG_HANDLER(acaLogMmapHandler);
+
+// compressed file handler - records are collected into blocks that get LZ-compressed and written as
+// self-contained frames, so a file can be decompressed (or tailed) from any frame on with
+// acaLogLzDecode or the aca_log_lzcat tool. one process-wide file guarded by a mutex (and a
+// flusher thread that writes idle blocks out after flushInterval)
+typedef struct aca_log_lz_config {
+    const char   *path;          // compressed log file path (appended to)
+    size_t        blockSize;     // uncompressed bytes per frame (max: 16 MiB, also the record max)
+    double        flushInterval; // max seconds a record waits in the block (0 = until it fills up)
+    aca_log_level flushLevel;    // records at/above this level are written out immediately
+} aca_log_lz_config;
+
+#define ACA_LOG_LZ_CONFIG_INIT {"dump.log.lz", 64 * 1024, 1.0, ACA_LOG_ERROR}
+
+int       acaLogLzOpen(const aca_log_lz_config *config);
+void      acaLogLzFlush(void);
+void      acaLogLzClose(void);
+ACA_LOG_HANDLER(acaLogLzHandler);
+size_t    acaLogLzCompress(const void *src, size_t srcLen, void *dst, size_t dstCap); // 0 = no fit
+int       acaLogLzDecompress(const void *src, size_t srcLen, void *dst, size_t dstLen);
+long long acaLogLzSync(FILE *in);              // seeks to the next intact frame (-1 = none)
+int       acaLogLzDecode(FILE *in, FILE *out); // frames as text, -1 if damaged data was skipped
+
+// datagram handler - standard lines are packed into datagrams (a line never spans two) for a
+// node-local collector on a Unix datagram socket or UDP, and a batch of datagrams goes out per
+// sendmmsg. sends never block: records the socket has no room for are dropped, counted and
+// reported in-band. a flusher thread sends a partial batch once it has waited flushInterval.
+// POSIX only (sendmmsg needs Linux and _GNU_SOURCE, else one send per datagram)
+typedef struct aca_log_net_config {
+    const char   *address;       // "unix:/path/to.sock" or "udp:host:port"
+    size_t        datagramSize;  // max bytes per datagram (max: 65507)
+    size_t        batch;         // datagrams gathered before a send (max: 64)
+    double        flushInterval; // max seconds between sends (0 = only when the batch fills up)
+    aca_log_level flushLevel;    // records at/above this level are sent immediately
+} aca_log_net_config;
+
+#define ACA_LOG_NET_CONFIG_INIT {"udp:127.0.0.1:5140", 8192, 16, 0.1, ACA_LOG_ERROR}
+
+int    acaLogNetOpen(const aca_log_net_config *config);
+void   acaLogNetFlush(void);
+void   acaLogNetClose(void);
+size_t acaLogNetDropped(void);              // records dropped because the socket was full
+int    acaLogNetBind(const char *address); // receiver side - bound datagram socket (-1 = failed)
+ACA_LOG_HANDLER(acaLogNetHandler);
+
+// shared-memory handler - records from any number of processes go into one ring of fixed-size
+// slots in a shared mapping (e.g. a file on /dev/shm), and a single collector drains them in claim
+// order to the real sink. writers only claim a slot and copy the record in, there is no lock and no
+// I/O on their side. a full ring drops (and counts) records. POSIX only
+typedef struct aca_log_shm_config {
+    const char *path;     // ring file, tmpfs keeps it in memory (e.g. /dev/shm/name)
+    size_t      capacity; // record slots, rounded up to pow2
+} aca_log_shm_config;
+
+#define ACA_LOG_SHM_CONFIG_INIT {"/dev/shm/aca_log.ring", 4096}
+
+int    acaLogShmCreate(const aca_log_shm_config *config); // collector side - creates a new ring
+int    acaLogShmAttach(const char *path);                 // writer side - maps an existing ring
+void   acaLogShmDetach(void);
+size_t acaLogShmDrain(FILE *fp); // collector only - writes out published records, returns count
+size_t acaLogShmDropped(void);   // records dropped because the ring was full
+ACA_LOG_HANDLER(acaLogShmHandler);
+
+// flight recorder - every record goes into a per-thread in-memory overwrite ring (nothing is
+// flushed), records at/above forwardLevel are also passed on to the forward handler. the rings are
+// dumped in merged timestamp order on FATAL, on SIGSEGV/SIGABRT/SIGBUS/SIGFPE/SIGILL or on request
+typedef struct aca_log_flight_config {
+    aca_log_handler *forward;       // handler for records at/above forwardLevel (NULL = none)
+    aca_log_level    forwardLevel;  // e.g. keep printing WARN+ while TRACE+ is recorded
+    int              fd;            // dump destination
+    int              signalHandler; // dump from fatal signal handlers (then re-raise)
+} aca_log_flight_config;
+
+#define ACA_LOG_FLIGHT_CONFIG_INIT {acaLogStandardHandler, ACA_LOG_WARN, 2, 1}
+
+void   acaLogFlightStart(const aca_log_flight_config *config);
+size_t acaLogFlightDump(int fd);
+ACA_LOG_HANDLER(acaLogFlightHandler);
+
+// dedup - a stage in front of another handler that coalesces repeats of the same message from the
+// same call site. the first occurrence is forwarded, later ones within the window are only counted
+// and reported as a single "<msg> [repeated N times over T s]" record once the window has passed
+typedef struct aca_log_dedup_config {
+    aca_log_handler *forward;     // handler records and summaries go to
+    double           window;      // seconds repeats are coalesced for (one summary per window)
+    int              consecutive; // only back-to-back repeats (any other record ends the run)
+    aca_log_level    passLevel;   // records at/above this level are never coalesced
+} aca_log_dedup_config;
+
+#define ACA_LOG_DEDUP_CONFIG_INIT {acaLogStandardHandler, 1.0, 0, ACA_LOG_FATAL}
+
+void   acaLogDedupStart(const aca_log_dedup_config *config);
+void   acaLogDedupFlush(void);      // forwards the pending summaries now
+size_t acaLogDedupSuppressed(void); // repeats coalesced so far
+ACA_LOG_HANDLER(acaLogDedupHandler);
+
+// dispatcher - a process-wide list of sinks, each with its own minimum level. records are formatted
+// once and the same aca_log_record is handed to every interested sink
+typedef struct aca_log_record {
+    aca_log_level level;
+    const char   *file;
+    int           line;
+    double        timestamp;
+    const char   *msg; // formatted message (not newline terminated)
+    size_t        msgLen;
+} aca_log_record;
+
+typedef void(aca_log_sink)(const aca_log_record *record, void *user);
+
+int  acaLogSinkAdd(aca_log_sink *sink, void *user, aca_log_level minLevel);
+int  acaLogSinkSetLevel(aca_log_sink *sink, void *user, aca_log_level minLevel);
+int  acaLogSinkRemove(aca_log_sink *sink, void *user);
+void acaLogStdoutSink(const aca_log_record *record, void *user); // standard line to stdout
+void acaLogFileSink(const aca_log_record *record, void *user);   // standard line to (FILE *)user
+ACA_LOG_HANDLER(acaLogDispatchHandler);
+
+// binary logging - each call site registers its format once, records only store the site id,
+// timestamp and raw argument bytes (rendered offline with acaLogBinaryDecode / aca_log_decode)
+typedef struct aca_log_binary_site aca_log_binary_site;
+
+int  acaLogBinaryOpen(const char *path);
+void acaLogBinaryFlush(void);
+void acaLogBinaryClose(void);
+void acaLogBinary(aca_log_binary_site **site,
+                  aca_log_level         level,
+                  const char           *file,
+                  int                   line,
+                  const char           *fmt,
+                  ...);
+int  acaLogBinaryDecode(FILE *in, FILE *out);
+
+// tracing - span begin/end pairs and counters are staged per thread as raw clock ticks and written
+// out as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev) when the thread's buffer
+// fills, on acaLogTraceFlush/acaLogTraceClose (every thread's buffer) or when the thread exits.
+// names are kept by pointer until then, so they must outlive the flush (string literals).
+// acaLogTraceHandler adds log records as instant events to the same trace
+extern volatile int gAcaLogTraceEnabled; // set while a trace file is open
+
+int  acaLogTraceOpen(const char *path); // NULL = trace.json
+void acaLogTraceFlush(void);
+void acaLogTraceClose(void);
+void acaLogTraceBegin(const char *name);
+void acaLogTraceEnd(const char *name);
+void acaLogTraceCounter(const char *name, double value);
+ACA_LOG_HANDLER(acaLogTraceHandler);
+
+// locale-free formatter used by the handlers - vsnprintf semantics (returns the full length, output
+// truncated and NUL terminated), falls back to vsnprintf for specifiers it doesn't handle itself
+int acaLogFormat(char *buf, size_t size, const char *fmt, va_list args);
+int acaLogFormatf(char *buf, size_t size, const char *fmt, ...);
+
+// level filtering - ACA_LOG_MIN_LEVEL (0 = TRACE ... 5 = FATAL) compiles lower level macros away,
+// the runtime level is checked by the macros before any of their arguments are evaluated
+#if !defined(ACA_LOG_MIN_LEVEL)
+#define ACA_LOG_MIN_LEVEL 0
+#endif
+extern volatile size_t gAcaLogLevel; // set through acaLogSetLevel
+void                   acaLogSetLevel(aca_log_level level);
+aca_log_level          acaLogGetLevel(void);
+#if defined(_MSC_VER)
+#define ACA_LOG_LEVEL_LOAD() ((int)gAcaLogLevel) // aligned volatile loads are atomic on MSVC
+#else
+#define ACA_LOG_LEVEL_LOAD() ((int)__atomic_load_n(&gAcaLogLevel, __ATOMIC_RELAXED))
+#endif // _MSC_VER
+#define ACA_LOG_LEVEL_ENABLED(level)                                                               \
+    (((int)(level) >= ACA_LOG_MIN_LEVEL) && ((int)(level) >= ACA_LOG_LEVEL_LOAD()))
+
+// timestamp source - the hot path keeps raw ticks, conversion to seconds happens when records are
+// formatted. ACA_LOG_CLOCK picks the source unless acaLogSetClock is called before the first
+// timestamp - the clock is set up once, later calls keep (and return) the source in use
+typedef enum aca_log_clock {
+    ACA_LOG_CLOCK_MONOTONIC, // clock_gettime(CLOCK_MONOTONIC) / QueryPerformanceCounter
+    ACA_LOG_CLOCK_COARSE,    // CLOCK_MONOTONIC_COARSE / GetTickCount64 - timer tick resolution
+    ACA_LOG_CLOCK_TSC,       // invariant rdtsc (x86) / cntvct_el0 (arm64), calibrated once
+} aca_log_clock;
+
+aca_log_clock acaLogSetClock(aca_log_clock clock); // returns the source in use
+aca_log_clock acaLogGetClock(void);
+double        acaLogTimestamp(void); // seconds since the clock was set up
+
+// clock behind interval decisions (EVERY_MS / TOKENS rate limits, buffered file flush interval and
+// rotation) - monotonic seconds, NULL (default) = acaLogTimestamp. lets tests step time by hand
+typedef double(aca_log_interval_clock)(void);
+void acaLogSetIntervalClock(aca_log_interval_clock *clock);
+
+// rate limiting - every limited call site owns a static aca_log_limit, the first record that gets
+// through after a suppressed stretch carries a "[suppressed N message(s)]" suffix
+typedef enum aca_log_limit_kind {
+    ACA_LOG_LIMIT_EVERY_N,  // 1st, (n+1)th, (2n+1)th, ... call
+    ACA_LOG_LIMIT_FIRST_N,  // the first n calls only
+    ACA_LOG_LIMIT_EVERY_MS, // at most one call per n milliseconds
+    ACA_LOG_LIMIT_TOKENS,   // token bucket - n records per second, bursts of up to burst records
+} aca_log_limit_kind;
+
+typedef struct aca_log_limit {
+    volatile size_t count;      // calls seen (EVERY_N / FIRST_N)
+    volatile size_t next;       // microsecond timestamp the site is allowed again (MS / TOKENS)
+    volatile size_t suppressed; // records skipped since the last one that got through
+} aca_log_limit;
+
+#define ACA_LOG_LIMIT_INIT {0, 0, 0}
+
+int acaLogLimit(
+    aca_log_limit *limit, aca_log_limit_kind kind, size_t n, size_t burst, size_t *suppressed);
+
+// structured logging - a message plus typed key/value fields, emitted as JSON Lines or logfmt by
+// the structured handlers (other handlers get the fields appended to the message as logfmt)
+typedef enum aca_log_kv_type {
+    ACA_LOG_KV_TYPE_INT,
+    ACA_LOG_KV_TYPE_UINT,
+    ACA_LOG_KV_TYPE_DOUBLE,
+    ACA_LOG_KV_TYPE_STR,
+    ACA_LOG_KV_TYPE_BOOL,
+} aca_log_kv_type;
+
+typedef struct aca_log_kv {
+    const char     *key;
+    aca_log_kv_type type;
+    long long       i; // INT, UINT (as bits) and BOOL values
+    double          d;
+    const char     *s;
+} aca_log_kv;
+
+// field initializers for ACA_LOG_KV, e.g. ACA_LOG_KV_INT("port", port)
+#define ACA_LOG_KV_INT(key, value) {key, ACA_LOG_KV_TYPE_INT, (long long)(value), 0.0, NULL}
+#define ACA_LOG_KV_UINT(key, value)                                                                \
+    {key, ACA_LOG_KV_TYPE_UINT, (long long)(unsigned long long)(value), 0.0, NULL}
+#define ACA_LOG_KV_DOUBLE(key, value) {key, ACA_LOG_KV_TYPE_DOUBLE, 0, (double)(value), NULL}
+#define ACA_LOG_KV_STR(key, value) {key, ACA_LOG_KV_TYPE_STR, 0, 0.0, (value)}
+#define ACA_LOG_KV_BOOL(key, value) {key, ACA_LOG_KV_TYPE_BOOL, (value) ? 1 : 0, 0.0, NULL}
+
+void acaLogKv(aca_log_level     level,
+              const char       *file,
+              int               line,
+              const char       *msg,
+              const aca_log_kv *fields,
+              size_t            count);
+ACA_LOG_HANDLER(acaLogJsonHandler);   // {"ts":..,"level":..,"file":..,"line":..,"msg":..,...}
+ACA_LOG_HANDLER(acaLogLogfmtHandler); // ts=.. level=.. file=.. line=.. msg=.. key=value ...
+
+// call sites - every ACA_LOG_[LEVEL] statement owns a static descriptor that registers itself on
+// first use, so individual statements can be switched on/off at runtime and the "file:line" text is
+// only formatted once per site
+typedef struct aca_log_site {
+    aca_log_level        level;
+    const char          *file;     // __FILE__
+    const char          *fileName; // file as logged - __FILE_NAME__ if available, else set when
+                                   // the site registers
+    int                  line;
+    const char          *fmt;      // set on registration
+    volatile size_t      enabled;
+    volatile size_t      state;    // 0 = new, 1 = registering, 2 = registered
+    struct aca_log_site *next;     // registry link
+    char                 fileLine[64];
+} aca_log_site;
+
+#if defined(__FILE_NAME__)
+#define ACA_LOG_FILE_NAME __FILE_NAME__
+#else
+#define ACA_LOG_FILE_NAME NULL
+#endif // __FILE_NAME__
+#define ACA_LOG_SITE_INIT(level)                                                                   \
+    {level, __FILE__, ACA_LOG_FILE_NAME, __LINE__, NULL, 1, 0, NULL, {0}}
+
+void          acaLogAt(aca_log_site *site, const char *fmt, ...);
+aca_log_site *acaLogSites(void); // registered sites, linked through site->next
+size_t        acaLogSiteEnable(const char *file, int line, int enabled); // (size_t)-1 = rules full
+
+// typed arguments for "{}" formats - "{}" picks a default for the argument type, "{:spec}" takes a
+// printf spec without the '%' (e.g. "{:08x}", "{:.3f}", "{:-10}"), "{{" and "}}" are literal
+// braces. normally filled in by the C++ front-end (aca::log::info, ACA_LOG_FMT) from static types
+typedef enum aca_log_arg_type {
+    ACA_LOG_ARG_TYPE_INT    = 'i',
+    ACA_LOG_ARG_TYPE_UINT   = 'u',
+    ACA_LOG_ARG_TYPE_DOUBLE = 'f',
+    ACA_LOG_ARG_TYPE_CHAR   = 'c',
+    ACA_LOG_ARG_TYPE_BOOL   = 'b',
+    ACA_LOG_ARG_TYPE_STR    = 's',
+    ACA_LOG_ARG_TYPE_PTR    = 'p',
+} aca_log_arg_type;
+
+typedef struct aca_log_arg {
+    aca_log_arg_type type;
+    long long        i; // INT, UINT (as bits), CHAR and BOOL values
+    double           d;
+    const void      *p;   // STR data or PTR value
+    size_t           len; // STR length
+} aca_log_arg;
+
+int  acaLogFormatArgs(
+     char *buf, size_t size, const char *fmt, const aca_log_arg *args, size_t count);
+void acaLogArgs(aca_log_level      level,
+                const char        *file,
+                int                line,
+                const char        *fmt,
+                const aca_log_arg *args,
+                size_t             count);
+void acaLogArgsAt(aca_log_site *site, const char *fmt, const aca_log_arg *args, size_t count);
+
 // wrapper-macro helpers
 #if !defined(ACA_LOG_STRIP_LOGGING_MACROS)
-#define ACA_LOG_INFO(fmt, ...) acaLog(ACA_LOG_INFO, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define ACA_LOG_WARN(fmt, ...) acaLog(ACA_LOG_WARN, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define ACA_LOG_ERROR(fmt, ...) acaLog(ACA_LOG_ERROR, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define ACA_LOG_FATAL(fmt, ...) acaLog(ACA_LOG_FATAL, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define ACA_LOG_DEBUG(fmt, ...) acaLog(ACA_LOG_DEBUG, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#define ACA_LOG_TRACE(fmt, ...) acaLog(ACA_LOG_TRACE, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#else
-#define ACA_LOG_INFO(fmt, ...)
-#define ACA_LOG_WARN(fmt, ...)
-#define ACA_LOG_ERROR(fmt, ...)
-#define ACA_LOG_FATAL(fmt, ...)
-#define ACA_LOG_DEBUG(fmt, ...)
-#define ACA_LOG_TRACE(fmt, ...)
+#define ACA_LOG_BINARY(level, fmt, ...)                                                            \
+    do {                                                                                           \
+        if (ACA_LOG_LEVEL_ENABLED(level)) {                                                        \
+            static aca_log_binary_site *acaLogBinarySite = NULL;                                   \
+            acaLogBinary(&acaLogBinarySite, level, __FILE__, __LINE__, fmt, ##__VA_ARGS__);        \
+        }                                                                                          \
+    } while (0)
+#if defined(ACA_LOG_BINARY_MACROS)
+#define ACA_LOG_CALL(level, fmt, ...) ACA_LOG_BINARY(level, fmt, ##__VA_ARGS__)
+#else
+#define ACA_LOG_CALL(level, fmt, ...)                                                              \
+    do {                                                                                           \
+        static aca_log_site acaLogSite = ACA_LOG_SITE_INIT(level);                                 \
+        if (ACA_LOG_LEVEL_ENABLED(level) && acaLogSite.enabled) {                                  \
+            acaLogAt(&acaLogSite, fmt, ##__VA_ARGS__);                                             \
+        }                                                                                          \
+    } while (0)
+#endif // ACA_LOG_BINARY_MACROS
+// fmt must be a string literal so the suppressed suffix can be appended to it
+#define ACA_LOG_LIMITED(kind, n, burst, level, fmt, ...)                                           \
+    do {                                                                                           \
+        static aca_log_limit acaLogLimitState = ACA_LOG_LIMIT_INIT;                                \
+        size_t               acaLogSuppressed = 0;                                                 \
+        if (ACA_LOG_LEVEL_ENABLED(level) &&                                                        \
+            acaLogLimit(&acaLogLimitState, kind, n, burst, &acaLogSuppressed)) {                   \
+            if (acaLogSuppressed != 0) {                                                           \
+                ACA_LOG_CALL(level,                                                                \
+                             fmt " [suppressed %lu message(s)]",                                   \
+                             ##__VA_ARGS__,                                                        \
+                             (unsigned long)acaLogSuppressed);                                     \
+            } else {                                                                               \
+                ACA_LOG_CALL(level, fmt, ##__VA_ARGS__);                                           \
+            }                                                                                      \
+        }                                                                                          \
+    } while (0)
+// e.g. ACA_LOG_KV(ACA_LOG_INFO, "login", ACA_LOG_KV_STR("user", name), ACA_LOG_KV_INT("id", id));
+#define ACA_LOG_KV(level, msg, ...)                                                                \
+    do {                                                                                           \
+        if (ACA_LOG_LEVEL_ENABLED(level)) {                                                        \
+            const aca_log_kv acaLogKvFields[] = {__VA_ARGS__};                                     \
+            acaLogKv(level,                                                                        \
+                     __FILE__,                                                                     \
+                     __LINE__,                                                                     \
+                     msg,                                                                          \
+                     acaLogKvFields,                                                               \
+                     sizeof(acaLogKvFields) / sizeof(acaLogKvFields[0]));                          \
+        }                                                                                          \
+    } while (0)
+// e.g. ACA_LOG_SPAN_BEGIN("decode"); ... ACA_LOG_SPAN_END("decode");
+#define ACA_LOG_SPAN_BEGIN(name)                                                                   \
+    do {                                                                                           \
+        if (gAcaLogTraceEnabled) {                                                                 \
+            acaLogTraceBegin(name);                                                                \
+        }                                                                                          \
+    } while (0)
+#define ACA_LOG_SPAN_END(name)                                                                     \
+    do {                                                                                           \
+        if (gAcaLogTraceEnabled) {                                                                 \
+            acaLogTraceEnd(name);                                                                  \
+        }                                                                                          \
+    } while (0)
+#define ACA_LOG_COUNTER(name, value)                                                               \
+    do {                                                                                           \
+        if (gAcaLogTraceEnabled) {                                                                 \
+            acaLogTraceCounter(name, (double)(value));                                             \
+        }                                                                                          \
+    } while (0)
+#else
+#define ACA_LOG_BINARY(level, fmt, ...)
+#define ACA_LOG_CALL(level, fmt, ...)
+#define ACA_LOG_LIMITED(kind, n, burst, level, fmt, ...)
+#define ACA_LOG_KV(level, msg, ...)
+#define ACA_LOG_SPAN_BEGIN(name)
+#define ACA_LOG_SPAN_END(name)
+#define ACA_LOG_COUNTER(name, value)
+#endif // ACA_LOG_STRIP_LOGGING_MACROS
+
+// e.g. ACA_LOG_EVERY_N(ACA_LOG_WARN, 1000, "bad checksum on port %d", port);
+#define ACA_LOG_EVERY_N(level, n, fmt, ...)                                                        \
+    ACA_LOG_LIMITED(ACA_LOG_LIMIT_EVERY_N, n, 0, level, fmt, ##__VA_ARGS__)
+#define ACA_LOG_FIRST_N(level, n, fmt, ...)                                                        \
+    ACA_LOG_LIMITED(ACA_LOG_LIMIT_FIRST_N, n, 0, level, fmt, ##__VA_ARGS__)
+#define ACA_LOG_EVERY_MS(level, ms, fmt, ...)                                                      \
+    ACA_LOG_LIMITED(ACA_LOG_LIMIT_EVERY_MS, ms, 0, level, fmt, ##__VA_ARGS__)
+#define ACA_LOG_TOKENS(level, perSecond, burst, fmt, ...)                                          \
+    ACA_LOG_LIMITED(ACA_LOG_LIMIT_TOKENS, perSecond, burst, level, fmt, ##__VA_ARGS__)
+
+#if ACA_LOG_MIN_LEVEL <= 0
+#define ACA_LOG_TRACE(fmt, ...) ACA_LOG_CALL(ACA_LOG_TRACE, fmt, ##__VA_ARGS__)
+#else
+#define ACA_LOG_TRACE(fmt, ...) ((void)0)
+#endif
+#if ACA_LOG_MIN_LEVEL <= 1
+#define ACA_LOG_DEBUG(fmt, ...) ACA_LOG_CALL(ACA_LOG_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define ACA_LOG_DEBUG(fmt, ...) ((void)0)
+#endif
+#if ACA_LOG_MIN_LEVEL <= 2
+#define ACA_LOG_INFO(fmt, ...) ACA_LOG_CALL(ACA_LOG_INFO, fmt, ##__VA_ARGS__)
+#else
+#define ACA_LOG_INFO(fmt, ...) ((void)0)
+#endif
+#if ACA_LOG_MIN_LEVEL <= 3
+#define ACA_LOG_WARN(fmt, ...) ACA_LOG_CALL(ACA_LOG_WARN, fmt, ##__VA_ARGS__)
+#else
+#define ACA_LOG_WARN(fmt, ...) ((void)0)
+#endif
+#if ACA_LOG_MIN_LEVEL <= 4
+#define ACA_LOG_ERROR(fmt, ...) ACA_LOG_CALL(ACA_LOG_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define ACA_LOG_ERROR(fmt, ...) ((void)0)
+#endif
+#if ACA_LOG_MIN_LEVEL <= 5
+#define ACA_LOG_FATAL(fmt, ...) ACA_LOG_CALL(ACA_LOG_FATAL, fmt, ##__VA_ARGS__)
+#else
+#define ACA_LOG_FATAL(fmt, ...) ((void)0)
+#endif
+
+#if defined(__cplusplus)
+// C++ front-end - aca::log::info("x={} y={}", x, y). arguments are encoded by their static types
+// (no va_list), unsupported argument types don't compile. ACA_LOG_FMT checks the format against the
+// arguments at compile time (C++11), the functions do so when consteval is available (C++20)
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && (_MSC_VER >= 1926))
+#define ACA_LOG_CALLER_FILE __builtin_FILE()
+#define ACA_LOG_CALLER_LINE __builtin_LINE()
+#else
+#define ACA_LOG_CALLER_FILE "?"
+#define ACA_LOG_CALLER_LINE 0
+#endif
+
+namespace aca {
+namespace log {
+namespace detail {
+
+// aca_log_arg_type of an argument type (left undefined for types that can't be logged)
+template <typename T, typename Enable = void>
+struct ArgType;
+template <>
+struct ArgType<bool> : std::integral_constant<char, ACA_LOG_ARG_TYPE_BOOL> {};
+template <>
+struct ArgType<char> : std::integral_constant<char, ACA_LOG_ARG_TYPE_CHAR> {};
+template <typename T>
+struct ArgType<T,
+               typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value &&
+                                       !std::is_same<T, char>::value>::type>
+    : std::integral_constant<char, ACA_LOG_ARG_TYPE_INT> {};
+template <typename T>
+struct ArgType<T,
+               typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                                       !std::is_same<T, bool>::value &&
+                                       !std::is_same<T, char>::value>::type>
+    : std::integral_constant<char, ACA_LOG_ARG_TYPE_UINT> {};
+template <typename T>
+struct ArgType<T, typename std::enable_if<std::is_enum<T>::value>::type>
+    : std::integral_constant<char, ACA_LOG_ARG_TYPE_INT> {};
+template <typename T>
+struct ArgType<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+    : std::integral_constant<char, ACA_LOG_ARG_TYPE_DOUBLE> {};
+template <>
+struct ArgType<const char *> : std::integral_constant<char, ACA_LOG_ARG_TYPE_STR> {};
+template <>
+struct ArgType<char *> : std::integral_constant<char, ACA_LOG_ARG_TYPE_STR> {};
+template <>
+struct ArgType<std::string> : std::integral_constant<char, ACA_LOG_ARG_TYPE_STR> {};
+#if __cplusplus >= 201703L
+template <>
+struct ArgType<std::string_view> : std::integral_constant<char, ACA_LOG_ARG_TYPE_STR> {};
+#endif
+template <typename T>
+struct ArgType<T *,
+               typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type,
+                                                     char>::value>::type>
+    : std::integral_constant<char, ACA_LOG_ARG_TYPE_PTR> {};
+template <>
+struct ArgType<std::nullptr_t> : std::integral_constant<char, ACA_LOG_ARG_TYPE_PTR> {};
+
+// compile-time format check - walks fmt and matches every field against the argument types
+// (C++11 constexpr, so one recursion level per format character)
+constexpr bool IsSpecFlag(char c) {
+    return (c == '-') || (c == '+') || (c == ' ') || (c == '#') || (c == '0');
+}
+constexpr const char *SkipSpecFlags(const char *f) {
+    return IsSpecFlag(*f) ? SkipSpecFlags(f + 1) : f;
+}
+constexpr const char *SkipDigits(const char *f) {
+    return ((*f >= '0') && (*f <= '9')) ? SkipDigits(f + 1) : f;
+}
+constexpr const char *SkipSpec(const char *f) { // [flags][width][.precision]
+    return (*SkipDigits(SkipSpecFlags(f)) == '.') ? SkipDigits(SkipDigits(SkipSpecFlags(f)) + 1)
+                                                  : SkipDigits(SkipSpecFlags(f));
+}
+// printf conversion usable for an argument type
+constexpr bool ConvFits(char conv, char type) {
+    return ((conv == 'd') || (conv == 'i') || (conv == 'u') || (conv == 'x') || (conv == 'X') ||
+            (conv == 'o'))
+               ? ((type == 'i') || (type == 'u') || (type == 'c') || (type == 'b'))
+           : ((conv == 'f') || (conv == 'F') || (conv == 'e') || (conv == 'E') || (conv == 'g') ||
+              (conv == 'G') || (conv == 'a') || (conv == 'A'))
+               ? (type == 'f')
+           : (conv == 'c') ? ((type == 'c') || (type == 'i') || (type == 'u'))
+           : (conv == 's') ? ((type == 's') || (type == 'b'))
+           : (conv == 'p') ? ((type == 'p') || (type == 's'))
+                           : false;
+}
+constexpr bool CheckFormat(const char *f, const char *types);
+constexpr bool CheckFieldEnd(const char *f, const char *types) { // f at the conversion or '}'
+    return (*f == '}') ? CheckFormat(f + 1, types + 1)
+           : ((f[1] == '}') && ConvFits(*f, *types)) ? CheckFormat(f + 2, types + 1)
+                                                     : false;
+}
+constexpr bool CheckField(const char *f, const char *types) { // f right after the '{'
+    return (*types == 0) ? false // more fields than arguments
+           : (*f == '}') ? CheckFormat(f + 1, types + 1)
+           : (*f == ':') ? CheckFieldEnd(SkipSpec(f + 1), types)
+                         : false;
+}
+constexpr bool CheckFormat(const char *f, const char *types) {
+    return (*f == 0) ? (*types == 0) // every argument used
+           : (((*f == '{') && (f[1] == '{')) || ((*f == '}') && (f[1] == '}')))
+               ? CheckFormat(f + 2, types)
+           : (*f == '{') ? CheckField(f + 1, types)
+           : (*f == '}') ? false
+                         : CheckFormat(f + 1, types);
+}
+
+template <typename... Args>
+struct ArgTypes {
+    static constexpr char value[sizeof...(Args) + 1] = {
+        ArgType<typename std::decay<Args>::type>::value..., 0};
+    static constexpr bool Check(const char *fmt) {
+        return CheckFormat(fmt, value);
+    }
+};
+template <typename... Args>
+constexpr char ArgTypes<Args...>::value[sizeof...(Args) + 1];
+
+// only used in decltype - ArgTypes of the ACA_LOG_FMT arguments
+template <typename... Args>
+ArgTypes<Args...> TypesOf(const Args &...);
+
+// encoders, picked by aca_log_arg_type
+template <typename T>
+inline aca_log_arg Encode(const T &value, std::integral_constant<char, ACA_LOG_ARG_TYPE_INT>) {
+    aca_log_arg arg = {ACA_LOG_ARG_TYPE_INT, (long long)value, 0.0, NULL, 0};
+    return arg;
+}
+template <typename T>
+inline aca_log_arg Encode(const T &value, std::integral_constant<char, ACA_LOG_ARG_TYPE_UINT>) {
+    aca_log_arg arg = {ACA_LOG_ARG_TYPE_UINT, (long long)(unsigned long long)value, 0.0, NULL, 0};
+    return arg;
+}
+template <typename T>
+inline aca_log_arg Encode(const T &value, std::integral_constant<char, ACA_LOG_ARG_TYPE_DOUBLE>) {
+    aca_log_arg arg = {ACA_LOG_ARG_TYPE_DOUBLE, 0, (double)value, NULL, 0};
+    return arg;
+}
+template <typename T>
+inline aca_log_arg Encode(const T &value, std::integral_constant<char, ACA_LOG_ARG_TYPE_CHAR>) {
+    aca_log_arg arg = {ACA_LOG_ARG_TYPE_CHAR, (long long)(unsigned char)value, 0.0, NULL, 0};
+    return arg;
+}
+template <typename T>
+inline aca_log_arg Encode(const T &value, std::integral_constant<char, ACA_LOG_ARG_TYPE_BOOL>) {
+    aca_log_arg arg = {ACA_LOG_ARG_TYPE_BOOL, value ? 1 : 0, 0.0, NULL, 0};
+    return arg;
+}
+inline aca_log_arg EncodeStr(const char *data, size_t len) {
+    aca_log_arg arg = {ACA_LOG_ARG_TYPE_STR, 0, 0.0, data, len};
+    return arg;
+}
+inline aca_log_arg Encode(const char *value, std::integral_constant<char, ACA_LOG_ARG_TYPE_STR>) {
+    return EncodeStr(value, (value != NULL) ? strlen(value) : 0);
+}
+inline aca_log_arg Encode(const std::string &value,
+                          std::integral_constant<char, ACA_LOG_ARG_TYPE_STR>) {
+    return EncodeStr(value.data(), value.size());
+}
+#if __cplusplus >= 201703L
+inline aca_log_arg Encode(std::string_view value,
+                          std::integral_constant<char, ACA_LOG_ARG_TYPE_STR>) {
+    return EncodeStr(value.data(), value.size());
+}
+#endif
+template <typename T>
+inline aca_log_arg Encode(const T &value, std::integral_constant<char, ACA_LOG_ARG_TYPE_PTR>) {
+    aca_log_arg arg = {ACA_LOG_ARG_TYPE_PTR, 0, 0.0, (const void *)value, 0};
+    return arg;
+}
+template <typename T>
+inline aca_log_arg Encode(const T &value) {
+    return Encode(value,
+                  std::integral_constant<char, ArgType<typename std::decay<T>::type>::value>());
+}
+
+template <typename T>
+struct Identity {
+    typedef T type;
+};
+
+template <typename... Args>
+inline void Log(
+    aca_log_level level, const char *file, int line, const char *fmt, const Args &...args) {
+    if (ACA_LOG_LEVEL_ENABLED(level)) {
+        const aca_log_arg encoded[sizeof...(Args) + 1] = {Encode(args)..., aca_log_arg()};
+        acaLogArgs(level, file, line, fmt, encoded, sizeof...(Args));
+    }
+}
+
+template <typename... Args>
+inline void LogAt(aca_log_site *site, const char *fmt, const Args &...args) {
+    const aca_log_arg encoded[sizeof...(Args) + 1] = {Encode(args)..., aca_log_arg()};
+    acaLogArgsAt(site, fmt, encoded, sizeof...(Args));
+}
+
+#if defined(__cpp_consteval)
+void FormatDoesNotMatchArguments(); // not constexpr - reaching it fails the consteval check
+#endif
+
+} // namespace detail
+
+// format string of the aca::log functions, also captures the caller's file and line
+template <typename... Args>
+struct FormatString {
+#if defined(__cpp_consteval)
+    template <size_t N>
+    consteval FormatString(const char (&str)[N],
+                           const char *callerFile = ACA_LOG_CALLER_FILE,
+                           int         callerLine = ACA_LOG_CALLER_LINE)
+        : fmt(str), file(callerFile), line(callerLine) {
+        if (!detail::ArgTypes<Args...>::Check(str)) {
+            detail::FormatDoesNotMatchArguments();
+        }
+    }
+#else
+    template <size_t N>
+    FormatString(const char (&str)[N],
+                 const char *callerFile = ACA_LOG_CALLER_FILE,
+                 int         callerLine = ACA_LOG_CALLER_LINE)
+        : fmt(str), file(callerFile), line(callerLine) {}
+#endif // __cpp_consteval
+    const char *fmt;
+    const char *file;
+    int         line;
+};
+
+#define ACA_LOG_FMT_LEVEL_FUNC(name, level)                                                        \
+    template <typename... Args>                                                                    \
+    inline void name(FormatString<typename detail::Identity<Args>::type...> fmt,                   \
+                     const Args &...args) {                                                        \
+        detail::Log(level, fmt.file, fmt.line, fmt.fmt, args...);                                  \
+    }
+ACA_LOG_FMT_LEVEL_FUNC(trace, ACA_LOG_TRACE)
+ACA_LOG_FMT_LEVEL_FUNC(debug, ACA_LOG_DEBUG)
+ACA_LOG_FMT_LEVEL_FUNC(info, ACA_LOG_INFO)
+ACA_LOG_FMT_LEVEL_FUNC(warn, ACA_LOG_WARN)
+ACA_LOG_FMT_LEVEL_FUNC(error, ACA_LOG_ERROR)
+ACA_LOG_FMT_LEVEL_FUNC(fatal, ACA_LOG_FATAL)
+#undef ACA_LOG_FMT_LEVEL_FUNC
+
+// scoped trace span - begins on construction and ends when it goes out of scope (ACA_LOG_SPAN)
+class Span {
+  public:
+    explicit Span(const char *name) : name_(gAcaLogTraceEnabled ? name : NULL) {
+        if (name_ != NULL) {
+            acaLogTraceBegin(name_);
+        }
+    }
+    ~Span() {
+        if (name_ != NULL) {
+            acaLogTraceEnd(name_);
+        }
+    }
+
+  private:
+    Span(const Span &);
+    Span &operator=(const Span &);
+    const char *name_;
+};
+
+} // namespace log
+} // namespace aca
+
+// e.g. ACA_LOG_FMT(ACA_LOG_INFO, "rx {} bytes from {}", n, peer); - fmt must be a string literal
+#if !defined(ACA_LOG_STRIP_LOGGING_MACROS)
+#define ACA_LOG_FMT(level, fmt, ...)                                                               \
+    do {                                                                                           \
+        static_assert(decltype(aca::log::detail::TypesOf(__VA_ARGS__))::Check(fmt),                \
+                      "format string doesn't match the arguments");                               \
+        static aca_log_site acaLogSite = ACA_LOG_SITE_INIT(level);                                 \
+        if (ACA_LOG_LEVEL_ENABLED(level) && acaLogSite.enabled) {                                  \
+            aca::log::detail::LogAt(&acaLogSite, fmt, ##__VA_ARGS__);                              \
+        }                                                                                          \
+    } while (0)
+#else
+#define ACA_LOG_FMT(level, fmt, ...)
+#endif // ACA_LOG_STRIP_LOGGING_MACROS
+
+// e.g. { ACA_LOG_SPAN("flush"); ... } - the span ends with the enclosing scope
+#define ACA_LOG_SPAN_CONCAT_(a, b) a##b
+#define ACA_LOG_SPAN_CONCAT(a, b) ACA_LOG_SPAN_CONCAT_(a, b)
+#if !defined(ACA_LOG_STRIP_LOGGING_MACROS)
+#define ACA_LOG_SPAN(name) aca::log::Span ACA_LOG_SPAN_CONCAT(acaLogSpan, __LINE__)(name)
+#else
+#define ACA_LOG_SPAN(name)
 #endif // ACA_LOG_STRIP_LOGGING_MACROS
+#endif // __cplusplus
 
 #ifdef ACA_LOG_IMPLEMENTATION
 
@@ -66,14 +838,31 @@ ACA_LOG_HANDLER(acaLogStandardFileHandler);
 #endif
 
 #include <assert.h>
+#include <float.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <signal.h>
 #ifdef _WIN32
+#include <io.h>
 #include <windows.h>
 #else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <time.h>
 #endif
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
 
 #if __STDC_VERSION__ >= 201112L
 #define THREAD_LOCAL _Thread_local
@@ -83,6 +872,223 @@ ACA_LOG_HANDLER(acaLogStandardFileHandler);
 #define THREAD_LOCAL __thread
 #endif
 
+// max formatted message bytes stored per async record (longer messages are truncated)
+#if !defined(ACA_LOG_ASYNC_MSG_SIZE)
+#define ACA_LOG_ASYNC_MSG_SIZE 256
+#endif
+// how long the async writer thread sleeps when the queue is empty
+#if !defined(ACA_LOG_ASYNC_IDLE_US)
+#define ACA_LOG_ASYNC_IDLE_US 1000
+#endif
+// per-thread line buffer size (lines that don't fit fall back to a heap buffer)
+#if !defined(ACA_LOG_LINE_BUFFER_SIZE)
+#define ACA_LOG_LINE_BUFFER_SIZE 1024
+#endif
+// per-thread staging buffer for binary records, and the largest single binary record
+#if !defined(ACA_LOG_BINARY_BUFFER_SIZE)
+#define ACA_LOG_BINARY_BUFFER_SIZE (64 * 1024)
+#endif
+#if !defined(ACA_LOG_BINARY_RECORD_MAX)
+#define ACA_LOG_BINARY_RECORD_MAX 1024
+#endif
+// records kept per thread by the flight recorder, and the message bytes kept per record
+#if !defined(ACA_LOG_FLIGHT_RECORDS)
+#define ACA_LOG_FLIGHT_RECORDS 2048
+#endif
+#if !defined(ACA_LOG_FLIGHT_MSG_SIZE)
+#define ACA_LOG_FLIGHT_MSG_SIZE 192
+#endif
+// per-thread staging buffer for trace events, and the message bytes kept per instant event
+#if !defined(ACA_LOG_TRACE_BUFFER_SIZE)
+#define ACA_LOG_TRACE_BUFFER_SIZE (64 * 1024)
+#endif
+#if !defined(ACA_LOG_TRACE_MSG_SIZE)
+#define ACA_LOG_TRACE_MSG_SIZE 256
+#endif
+// call site enable/disable rules kept for sites that register later
+#if !defined(ACA_LOG_SITE_RULES)
+#define ACA_LOG_SITE_RULES 64
+#endif
+// call site + message slots tracked by the dedup stage (power of two), and the message bytes kept
+// per slot for the repeat summary
+#if !defined(ACA_LOG_DEDUP_SLOTS)
+#define ACA_LOG_DEDUP_SLOTS 64
+#endif
+#if !defined(ACA_LOG_DEDUP_MSG_SIZE)
+#define ACA_LOG_DEDUP_MSG_SIZE 256
+#endif
+// message and file name bytes per shared-memory ring slot, and how long the collector waits on a
+// claimed slot that never gets published before it checks whether the writer died (and skips it)
+#if !defined(ACA_LOG_SHM_MSG_SIZE)
+#define ACA_LOG_SHM_MSG_SIZE 256
+#endif
+#if !defined(ACA_LOG_SHM_FILE_SIZE)
+#define ACA_LOG_SHM_FILE_SIZE 48
+#endif
+#if !defined(ACA_LOG_SHM_STALL_MS)
+#define ACA_LOG_SHM_STALL_MS 1000
+#endif
+
+// initial timestamp source, and how long the TSC rate is measured against the monotonic clock
+#if !defined(ACA_LOG_CLOCK)
+#define ACA_LOG_CLOCK ACA_LOG_CLOCK_MONOTONIC
+#endif
+#if !defined(ACA_LOG_TSC_CALIBRATION_MS)
+#define ACA_LOG_TSC_CALIBRATION_MS 10
+#endif
+
+// atomic helpers (acquire loads, release stores, full-barrier read-modify-writes, fences)
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline size_t acaLogAtomicLoad(volatile size_t *ptr) {
+    size_t value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+}
+static inline void acaLogAtomicStore(volatile size_t *ptr, size_t value) {
+    _ReadWriteBarrier();
+    *ptr = value;
+}
+static inline bool acaLogAtomicCas(volatile size_t *ptr, size_t expected, size_t desired) {
+#if defined(_WIN64)
+    return (size_t)_InterlockedCompareExchange64(
+               (volatile __int64 *)ptr, (__int64)desired, (__int64)expected) == expected;
+#else
+    return (size_t)_InterlockedCompareExchange(
+               (volatile long *)ptr, (long)desired, (long)expected) == expected;
+#endif
+}
+static inline size_t acaLogAtomicExchange(volatile size_t *ptr, size_t value) {
+#if defined(_WIN64)
+    return (size_t)_InterlockedExchange64((volatile __int64 *)ptr, (__int64)value);
+#else
+    return (size_t)_InterlockedExchange((volatile long *)ptr, (long)value);
+#endif
+}
+static inline void *acaLogAtomicLoadPtr(void *volatile *ptr) {
+    void *value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+}
+static inline void acaLogAtomicStorePtr(void *volatile *ptr, void *value) {
+    _ReadWriteBarrier();
+    *ptr = value;
+}
+static inline bool acaLogAtomicCasPtr(void *volatile *ptr, void *expected, void *desired) {
+    return _InterlockedCompareExchangePointer(ptr, desired, expected) == expected;
+}
+static inline size_t acaLogAtomicAdd(volatile size_t *ptr, size_t value) {
+#if defined(_WIN64)
+    return (size_t)_InterlockedExchangeAdd64((volatile __int64 *)ptr, (__int64)value);
+#else
+    return (size_t)_InterlockedExchangeAdd((volatile long *)ptr, (long)value);
+#endif
+}
+static inline void acaLogAtomicFenceAcquire(void) {
+    MemoryBarrier();
+}
+static inline void acaLogAtomicFenceRelease(void) {
+    MemoryBarrier();
+}
+#else
+static inline size_t acaLogAtomicLoad(volatile size_t *ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+static inline void acaLogAtomicStore(volatile size_t *ptr, size_t value) {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+static inline bool acaLogAtomicCas(volatile size_t *ptr, size_t expected, size_t desired) {
+    return __atomic_compare_exchange_n(
+        ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static inline size_t acaLogAtomicAdd(volatile size_t *ptr, size_t value) {
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+static inline size_t acaLogAtomicExchange(volatile size_t *ptr, size_t value) {
+    return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+static inline void *acaLogAtomicLoadPtr(void *volatile *ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+static inline void acaLogAtomicStorePtr(void *volatile *ptr, void *value) {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+static inline bool acaLogAtomicCasPtr(void *volatile *ptr, void *expected, void *desired) {
+    return __atomic_compare_exchange_n(
+        ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+// gcc warns that ThreadSanitizer doesn't model fences - keep builds with -Werror working
+#if defined(__SANITIZE_THREAD__) && !defined(__clang__) && (__GNUC__ >= 12)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wtsan"
+#endif
+static inline void acaLogAtomicFenceAcquire(void) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+static inline void acaLogAtomicFenceRelease(void) {
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+#if defined(__SANITIZE_THREAD__) && !defined(__clang__) && (__GNUC__ >= 12)
+#pragma GCC diagnostic pop
+#endif
+#endif // _MSC_VER
+
+// thread helpers
+#ifdef _WIN32
+typedef HANDLE aca_log_thread;
+#define ACA_LOG_THREAD_ROUTINE(name) static DWORD WINAPI name(LPVOID arg)
+#define ACA_LOG_THREAD_RETURN return 0
+static inline int acaLogThreadCreate(aca_log_thread *thread, LPTHREAD_START_ROUTINE routine) {
+    *thread = CreateThread(NULL, 0, routine, NULL, 0, NULL);
+    return (*thread != NULL) ? 0 : -1;
+}
+static inline void acaLogThreadJoin(aca_log_thread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+static inline void acaLogThreadYield(void) {
+    SwitchToThread();
+}
+static inline void acaLogSleepUs(unsigned int usec) {
+    Sleep((usec >= 1000) ? (usec / 1000) : 1);
+}
+typedef SRWLOCK aca_log_mutex;
+#define ACA_LOG_MUTEX_INIT SRWLOCK_INIT
+static inline void acaLogMutexLock(aca_log_mutex *mutex) {
+    AcquireSRWLockExclusive(mutex);
+}
+static inline void acaLogMutexUnlock(aca_log_mutex *mutex) {
+    ReleaseSRWLockExclusive(mutex);
+}
+#else
+typedef pthread_t aca_log_thread;
+#define ACA_LOG_THREAD_ROUTINE(name) static void *name(void *arg)
+#define ACA_LOG_THREAD_RETURN return NULL
+static inline int acaLogThreadCreate(aca_log_thread *thread, void *(*routine)(void *)) {
+    return (pthread_create(thread, NULL, routine, NULL) == 0) ? 0 : -1;
+}
+static inline void acaLogThreadJoin(aca_log_thread thread) {
+    pthread_join(thread, NULL);
+}
+static inline void acaLogThreadYield(void) {
+    sched_yield();
+}
+static inline void acaLogSleepUs(unsigned int usec) {
+    struct timespec ts;
+    ts.tv_sec  = usec / 1000000;
+    ts.tv_nsec = (long)(usec % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+}
+typedef pthread_mutex_t aca_log_mutex;
+#define ACA_LOG_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+static inline void acaLogMutexLock(aca_log_mutex *mutex) {
+    pthread_mutex_lock(mutex);
+}
+static inline void acaLogMutexUnlock(aca_log_mutex *mutex) {
+    pthread_mutex_unlock(mutex);
+}
+#endif // _WIN32
+
 #define ACA_LOG_SET_LEVEL(level, levelStr)                                                         \
     do {                                                                                           \
         switch (level) {                                                                           \
@@ -111,120 +1117,946 @@ ACA_LOG_HANDLER(acaLogStandardFileHandler);
         }                                                                                          \
     } while (0)
 
-// returns a singular "file+line" string
-static inline const char *FormatFileLine(const char *file, int line) {
-    static THREAD_LOCAL char buffer[64 + 1] = {0};
-#if defined(ACA_LOG_CHOP_FILEPATH) // since some compilers treat __FILE__ as full path
-    const char *leaf = strrchr(file, '/') ? strrchr(file, '/') + 1 : file;
-#if defined(_WIN32)
-    if (leaf == file) {
-        leaf = strrchr(file, '\\') ? strrchr(file, '\\') + 1 : file;
+static const char gAcaLogDigitPairs[] = "00010203040506070809101112131415161718192021222324"
+                                        "25262728293031323334353637383940414243444546474849"
+                                        "50515253545556575859606162636465666768697071727374"
+                                        "75767778798081828384858687888990919293949596979899";
+
+// writes value in decimal (two digits per division) backwards from end - returns the first digit
+static inline char *acaLogFormatDecimal(char *end, unsigned long long value) {
+    char *p = end;
+    while (value >= 100) {
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--p = gAcaLogDigitPairs[pair + 1];
+        *--p = gAcaLogDigitPairs[pair];
     }
-#endif // _WIN32
-    snprintf(buffer, sizeof(buffer) - 1, "%s:%d", leaf, line);
-#else
-    snprintf(buffer, sizeof(buffer) - 1, "%s:%d", file, line);
-#endif // ACA_LOG_CHOP_FILEPATH
-    return buffer;
+    if (value >= 10) {
+        *--p = gAcaLogDigitPairs[value * 2 + 1];
+        *--p = gAcaLogDigitPairs[value * 2];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return p;
 }
 
-// returns a monotonic timestamp value
-static double GetTimestamp() {
-    static int    initialized = 0;
-    static double start_time  = 0;
-#ifdef _WIN32
-    static LARGE_INTEGER frequency;
-    LARGE_INTEGER        counter;
-    if (!initialized) {
-        QueryPerformanceFrequency(&frequency);
-        QueryPerformanceCounter(&counter);
-        start_time  = (double)counter.QuadPart / (double)frequency.QuadPart;
-        initialized = 1;
+// exact product - a * b == *product + *error (Veltkamp split, no FMA needed)
+static inline void acaLogTwoProduct(double a, double b, double *product, double *error) {
+    const double split = 134217729.0; // 2^27 + 1
+    double       aSplit = split * a;
+    double       bSplit = split * b;
+    double       aHi    = aSplit - (aSplit - a);
+    double       aLo    = a - aHi;
+    double       bHi    = bSplit - (bSplit - b);
+    double       bLo    = b - bHi;
+    *product            = a * b;
+    *error = (((aHi * bHi) - *product) + (aHi * bLo) + (aLo * bHi)) + (aLo * bLo);
+}
+
+// %f digits for |value| < 1e18 and precision <= 15 - rounds the exact binary value half-to-even
+// like glibc, so the output matches printf. writes backwards from end, returns the first char
+static char *acaLogFormatFixed(char *end, double mag, int precision, bool alt) {
+    static const double powers[] = {1e0,
+                                    1e1,
+                                    1e2,
+                                    1e3,
+                                    1e4,
+                                    1e5,
+                                    1e6,
+                                    1e7,
+                                    1e8,
+                                    1e9,
+                                    1e10,
+                                    1e11,
+                                    1e12,
+                                    1e13,
+                                    1e14,
+                                    1e15};
+    unsigned long long whole = (unsigned long long)mag;
+    double             frac  = mag - (double)whole; // exact
+    double             scaled, error;
+    acaLogTwoProduct(frac, powers[precision], &scaled, &error);
+    unsigned long long digits = (unsigned long long)scaled;
+    double             rest   = (scaled - (double)digits) - 0.5;
+    bool               odd    = (precision > 0) ? (digits & 1) : (whole & 1);
+    if ((rest > 0.0) || ((rest == 0.0) && ((error > 0.0) || ((error == 0.0) && odd)))) {
+        ++digits;
     }
-    QueryPerformanceCounter(&counter);
-    return ((double)counter.QuadPart / (double)frequency.QuadPart) - start_time;
-#else
-    struct timespec ts;
-    if (!initialized) {
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        start_time  = ts.tv_sec + (ts.tv_nsec / 1000000000.0);
-        initialized = 1;
+    if (digits >= (unsigned long long)powers[precision]) {
+        digits -= (unsigned long long)powers[precision];
+        ++whole;
     }
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (ts.tv_sec + (ts.tv_nsec / 1000000000.0)) - start_time;
-#endif
+    char *p = end;
+    if (precision > 0) {
+        char *fracEnd = p;
+        p             = acaLogFormatDecimal(p, digits);
+        while (p > fracEnd - precision) {
+            *--p = '0';
+        }
+        *--p = '.';
+    } else if (alt) {
+        *--p = '.';
+    }
+    return acaLogFormatDecimal(p, whole);
 }
 
-THREAD_LOCAL aca_log_handler *tl_acaLogHandler = acaLogStandardHandler;
-#if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS)
-static const char *gAcaLogLevelColorMap[] = {ACA_LOG_COLOR_WHITE,
-                                             ACA_LOG_COLOR_MAGENTA,
-                                             ACA_LOG_COLOR_GREEN,
-                                             ACA_LOG_COLOR_YELLOW,
-                                             ACA_LOG_COLOR_RED,
-                                             ACA_LOG_COLOR_RED};
-#endif // ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS
+// acaLogFormat output - counts every byte like vsnprintf but only stores what fits
+typedef struct aca_log_format_out {
+    char  *buf;
+    size_t size;
+    size_t len;
+} aca_log_format_out;
 
-// main log entrypoint
-void acaLog(aca_log_level level, const char *file, int line, const char *fmt, ...) {
+static inline void acaLogFormatPut(aca_log_format_out *out, const char *str, size_t len) {
+    if (out->len < out->size) {
+        size_t room = out->size - out->len;
+        memcpy(&out->buf[out->len], str, (len < room) ? len : room);
+    }
+    out->len += len;
+}
+
+static inline void acaLogFormatPad(aca_log_format_out *out, char c, int count) {
+    if (count <= 0) {
+        return;
+    }
+    if (out->len < out->size) {
+        size_t room = out->size - out->len;
+        memset(&out->buf[out->len], c, ((size_t)count < room) ? (size_t)count : room);
+    }
+    out->len += (size_t)count;
+}
+
+// vsnprintf replacement for the hot path - handles %d %i %u %x %X %o %c %s %f %F %% (and %p on
+// glibc/macOS) with flags, width, precision (including *) and the hh/h/l/ll/j/z/t lengths without
+// locale lookups. anything else (%e, %g, %a, %n, L, wide chars, NULL strings or pointers, huge or
+// non-finite %f values) hands the whole format to vsnprintf, so the output is always what printf
+// would produce
+int acaLogFormat(char *buf, size_t size, const char *fmt, va_list args) {
+#if defined(ACA_LOG_DISABLE_FAST_FORMAT) || (defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD != 0))
+    return vsnprintf(buf, size, fmt, args);
+#else
+    aca_log_format_out out = {buf, (size > 0) ? size - 1 : 0, 0};
+    va_list            argsCopy;
+    va_copy(argsCopy, args);
+    const char *p = fmt;
+    while (*p != 0) {
+        const char *literal = p;
+        while ((*p != 0) && (*p != '%')) {
+            ++p;
+        }
+        acaLogFormatPut(&out, literal, (size_t)(p - literal));
+        if (*p == 0) {
+            break;
+        }
+        if (p[1] == '%') {
+            acaLogFormatPut(&out, "%", 1);
+            p += 2;
+            continue;
+        }
+
+        // same grammar as acaLogParseFmtSpec, flags kept as bools for the hot path
+        bool left = false, zero = false, alt = false;
+        char sign = 0;
+        for (++p;; ++p) {
+            if (*p == '-') {
+                left = true;
+            } else if (*p == '0') {
+                zero = true;
+            } else if (*p == '#') {
+                alt = true;
+            } else if (*p == '+') {
+                sign = '+';
+            } else if ((*p == ' ') && (sign == 0)) {
+                sign = ' ';
+            } else if (*p != ' ') {
+                break;
+            }
+        }
+        int width     = -1;
+        int precision = -1;
+        if (*p == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                left  = true;
+                width = -width;
+            }
+            ++p;
+        } else {
+            while ((*p >= '0') && (*p <= '9')) {
+                width = ((width < 0) ? 0 : width * 10) + (*p++ - '0');
+            }
+        }
+        if (*p == '.') {
+            ++p;
+            precision = 0;
+            if (*p == '*') {
+                precision = va_arg(args, int);
+                if (precision < 0) {
+                    precision = -1;
+                }
+                ++p;
+            } else {
+                while ((*p >= '0') && (*p <= '9')) {
+                    precision = (precision * 10) + (*p++ - '0');
+                }
+            }
+        }
+        char length[2] = {0, 0};
+        if (((p[0] == 'h') && (p[1] == 'h')) || ((p[0] == 'l') && (p[1] == 'l'))) {
+            length[0] = *p++;
+            length[1] = *p++;
+        } else if ((*p == 'h') || (*p == 'l') || (*p == 'j') || (*p == 'z') || (*p == 't') ||
+                   (*p == 'L')) {
+            length[0] = *p++;
+        }
+        char conv = *p;
+        if (conv != 0) {
+            ++p;
+        }
+
+        char        tmp[64];
+        char       *end       = &tmp[sizeof(tmp)];
+        const char *body      = end;
+        size_t      len       = 0;
+        const char *prefix    = "";
+        size_t      prefixLen = 0;
+        int         zeros     = 0; // between prefix and body
+        switch (conv) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                unsigned long long value;
+                bool               negative = false;
+                if ((conv == 'd') || (conv == 'i')) {
+                    long long signedValue;
+                    switch (length[0]) {
+                        case 'l':
+                            signedValue = (length[1] == 'l') ? va_arg(args, long long)
+                                                             : va_arg(args, long);
+                            break;
+                        case 'j':
+                            signedValue = (long long)va_arg(args, intmax_t);
+                            break;
+                        case 'z':
+                            signedValue = (long long)va_arg(args, ptrdiff_t); // signed size_t
+                            break;
+                        case 't':
+                            signedValue = (long long)va_arg(args, ptrdiff_t);
+                            break;
+                        case 'h':
+                            signedValue = va_arg(args, int);
+                            signedValue = (length[1] == 'h') ? (signed char)signedValue
+                                                             : (short)signedValue;
+                            break;
+                        case 0:
+                            signedValue = va_arg(args, int);
+                            break;
+                        default:
+                            goto fallback;
+                    }
+                    negative = signedValue < 0;
+                    value    = negative ? 0ULL - (unsigned long long)signedValue
+                                        : (unsigned long long)signedValue;
+                } else {
+                    switch (length[0]) {
+                        case 'l':
+                            value = (length[1] == 'l') ? va_arg(args, unsigned long long)
+                                                       : va_arg(args, unsigned long);
+                            break;
+                        case 'j':
+                            value = (unsigned long long)va_arg(args, uintmax_t);
+                            break;
+                        case 'z':
+                            value = (unsigned long long)va_arg(args, size_t);
+                            break;
+                        case 't':
+                            value = (unsigned long long)va_arg(args, size_t); // unsigned ptrdiff_t
+                            break;
+                        case 'h':
+                            value = va_arg(args, unsigned int);
+                            value = (length[1] == 'h') ? (unsigned char)value
+                                                       : (unsigned short)value;
+                            break;
+                        case 0:
+                            value = va_arg(args, unsigned int);
+                            break;
+                        default:
+                            goto fallback;
+                    }
+                    sign = 0;
+                }
+                if ((value != 0) || (precision != 0)) {
+                    if ((conv == 'x') || (conv == 'X')) {
+                        const char *hex = (conv == 'x') ? "0123456789abcdef" : "0123456789ABCDEF";
+                        char       *d   = end;
+                        do {
+                            *--d = hex[value & 15];
+                            value >>= 4;
+                        } while (value != 0);
+                        body = d;
+                    } else if (conv == 'o') {
+                        char *d = end;
+                        do {
+                            *--d = (char)('0' + (value & 7));
+                            value >>= 3;
+                        } while (value != 0);
+                        body = d;
+                    } else {
+                        body = acaLogFormatDecimal(end, value);
+                    }
+                }
+                len = (size_t)(end - body);
+                if (negative) {
+                    prefix    = "-";
+                    prefixLen = 1;
+                } else if (sign == '+') {
+                    prefix    = "+";
+                    prefixLen = 1;
+                } else if (sign == ' ') {
+                    prefix    = " ";
+                    prefixLen = 1;
+                } else if (alt && (len > 0) && (body[0] != '0') && (conv == 'x')) {
+                    prefix    = "0x";
+                    prefixLen = 2;
+                } else if (alt && (len > 0) && (body[0] != '0') && (conv == 'X')) {
+                    prefix    = "0X";
+                    prefixLen = 2;
+                } else if (alt && (conv == 'o') && ((int)len >= precision) &&
+                           ((len == 0) || (body[0] != '0'))) {
+                    prefix    = "0";
+                    prefixLen = 1;
+                }
+                if ((int)len < precision) {
+                    zeros = precision - (int)len;
+                } else if (zero && !left && (precision < 0) && (width > 0)) {
+                    zeros = width - (int)(prefixLen + len);
+                }
+                break;
+            }
+            case 'f':
+            case 'F': {
+                if (length[0] == 'L') {
+                    goto fallback;
+                }
+                double value = va_arg(args, double);
+                double mag   = (value < 0.0) ? -value : value;
+                if (precision < 0) {
+                    precision = 6;
+                }
+                if (!(mag < 1e18) || (precision > 15)) { // also catches NaN
+                    goto fallback;
+                }
+                unsigned long long bits;
+                memcpy(&bits, &value, sizeof(bits));
+                body = acaLogFormatFixed(end, mag, precision, alt);
+                len  = (size_t)(end - body);
+                if (bits >> 63) { // -0.0 keeps its sign too
+                    prefix    = "-";
+                    prefixLen = 1;
+                } else if (sign == '+') {
+                    prefix    = "+";
+                    prefixLen = 1;
+                } else if (sign == ' ') {
+                    prefix    = " ";
+                    prefixLen = 1;
+                }
+                if (zero && !left && (width > 0)) {
+                    zeros = width - (int)(prefixLen + len);
+                }
+                break;
+            }
+#if defined(__GLIBC__) || defined(__APPLE__)
+            case 'p': { // "%#lx" for non-NULL pointers here (NULL differs per libc)
+                const void *ptr   = va_arg(args, const void *);
+                uintptr_t   value = (uintptr_t)ptr;
+                if ((ptr == NULL) || (length[0] != 0) || (precision >= 0) || zero || (sign != 0)) {
+                    goto fallback;
+                }
+                char *d = end;
+                do {
+                    *--d = "0123456789abcdef"[value & 15];
+                    value >>= 4;
+                } while (value != 0);
+                body      = d;
+                len       = (size_t)(end - body);
+                prefix    = "0x";
+                prefixLen = 2;
+                break;
+            }
+#endif // __GLIBC__ || __APPLE__
+            case 'c':
+                if ((length[0] != 0) || zero) {
+                    goto fallback;
+                }
+                tmp[0] = (char)(unsigned char)va_arg(args, int);
+                body   = tmp;
+                len    = 1;
+                break;
+            case 's':
+                if ((length[0] != 0) || zero) {
+                    goto fallback;
+                }
+                body = va_arg(args, const char *);
+                if (body == NULL) {
+                    goto fallback;
+                }
+                if (precision >= 0) {
+                    const char *nul = (const char *)memchr(body, 0, (size_t)precision);
+                    len             = (nul != NULL) ? (size_t)(nul - body) : (size_t)precision;
+                } else {
+                    len = strlen(body);
+                }
+                break;
+            default:
+                goto fallback;
+        }
+
+        int padding = width - (int)(prefixLen + (size_t)(zeros > 0 ? zeros : 0) + len);
+        if (!left) {
+            acaLogFormatPad(&out, ' ', padding);
+        }
+        acaLogFormatPut(&out, prefix, prefixLen);
+        acaLogFormatPad(&out, '0', zeros);
+        acaLogFormatPut(&out, body, len);
+        if (left) {
+            acaLogFormatPad(&out, ' ', padding);
+        }
+    }
+    va_end(argsCopy);
+    if (size > 0) {
+        buf[(out.len < out.size) ? out.len : out.size] = 0;
+    }
+    return (int)out.len;
+
+fallback:
+    {
+        int n = vsnprintf(buf, size, fmt, argsCopy);
+        va_end(argsCopy);
+        return n;
+    }
+#endif // ACA_LOG_DISABLE_FAST_FORMAT
+}
+
+int acaLogFormatf(char *buf, size_t size, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    assert(tl_acaLogHandler != NULL && "no log handler set for acaLog!");
-    tl_acaLogHandler(level, file, line, fmt, args);
+    int n = acaLogFormat(buf, size, fmt, args);
+    va_end(args);
+    return n;
+}
+
+// call site of the record being handled on this thread (set by acaLogAt)
+static THREAD_LOCAL aca_log_site *tl_acaLogSite = NULL;
+
+// returns a singular "file+line" string
+static inline const char *FormatFileLine(const char *file, int line) {
+    static THREAD_LOCAL char buffer[64 + 1] = {0};
+    if ((tl_acaLogSite != NULL) && (tl_acaLogSite->fileName == file) &&
+        (tl_acaLogSite->line == line)) {
+        return tl_acaLogSite->fileLine; // formatted once when the site registered
+    }
+#if defined(ACA_LOG_CHOP_FILEPATH) // since some compilers treat __FILE__ as full path
+    const char *leaf = strrchr(file, '/') ? strrchr(file, '/') + 1 : file;
+#if defined(_WIN32)
+    if (leaf == file) {
+        leaf = strrchr(file, '\\') ? strrchr(file, '\\') + 1 : file;
+    }
+#endif // _WIN32
+    acaLogFormatf(buffer, sizeof(buffer) - 1, "%s:%d", leaf, line);
+#else
+    acaLogFormatf(buffer, sizeof(buffer) - 1, "%s:%d", file, line);
+#endif // ACA_LOG_CHOP_FILEPATH
+    return buffer;
+}
+
+// timestamp clock - records take raw ticks of the selected source and only turn them into seconds
+// (one multiply) when they get formatted. set up once on the first timestamp or by acaLogSetClock
+// (state 0 = new, 1 = setting up, 2 = ready), threads that race the setup wait for it
+static struct {
+    volatile size_t state;
+    aca_log_clock   source;
+    uint64_t        start; // ticks at setup - timestamps count from here
+    double          secondsPerTick;
+} gAcaLogClock;
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ACA_LOG_CLOCK_HAS_TSC
+#if defined(_MSC_VER)
+static inline uint64_t acaLogClockReadTsc(void) {
+    return __rdtsc();
+}
+// invariant TSC - constant rate across P-/C-states
+static inline bool acaLogClockTscUsable(void) {
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if ((unsigned int)regs[0] < 0x80000007u) {
+        return false;
+    }
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+}
+#else
+static inline uint64_t acaLogClockReadTsc(void) {
+    return __builtin_ia32_rdtsc();
+}
+static inline bool acaLogClockTscUsable(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000u, &eax, &ebx, &ecx, &edx) || (eax < 0x80000007u)) {
+        return false;
+    }
+    __get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+#endif // _MSC_VER
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+#define ACA_LOG_CLOCK_HAS_TSC
+// the generic timer's virtual counter - constant rate, readable from user space
+static inline uint64_t acaLogClockReadTsc(void) {
+    uint64_t ticks;
+    __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+}
+static inline bool acaLogClockTscUsable(void) {
+    return true;
+}
+#endif // x86 / arm64
+
+static inline uint64_t acaLogClockRead(aca_log_clock source) {
+#ifdef _WIN32
+    if (source == ACA_LOG_CLOCK_COARSE) {
+        return GetTickCount64();
+    }
+#if defined(ACA_LOG_CLOCK_HAS_TSC)
+    if (source == ACA_LOG_CLOCK_TSC) {
+        return acaLogClockReadTsc();
+    }
+#endif // ACA_LOG_CLOCK_HAS_TSC
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)counter.QuadPart;
+#else
+    struct timespec ts;
+#if defined(ACA_LOG_CLOCK_HAS_TSC)
+    if (source == ACA_LOG_CLOCK_TSC) {
+        return acaLogClockReadTsc();
+    }
+#endif // ACA_LOG_CLOCK_HAS_TSC
+#if defined(CLOCK_MONOTONIC_COARSE)
+    clock_gettime((source == ACA_LOG_CLOCK_COARSE) ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC, &ts);
+#else
+    (void)source;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif // CLOCK_MONOTONIC_COARSE
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+#endif // _WIN32
+}
+
+// picks the source (falling back to MONOTONIC), measures its rate and publishes state 2 - the
+// caller owns state 1
+static void acaLogClockSetup(aca_log_clock source) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double secondsPerTick = 1.0 / (double)frequency.QuadPart;
+    if (source == ACA_LOG_CLOCK_COARSE) {
+        secondsPerTick = 0.001;
+    }
+#else
+    double secondsPerTick = 1e-9;
+#if !defined(CLOCK_MONOTONIC_COARSE)
+    if (source == ACA_LOG_CLOCK_COARSE) {
+        source = ACA_LOG_CLOCK_MONOTONIC;
+    }
+#endif // CLOCK_MONOTONIC_COARSE
+#endif // _WIN32
+    if (source == ACA_LOG_CLOCK_TSC) {
+#if defined(ACA_LOG_CLOCK_HAS_TSC)
+        if (acaLogClockTscUsable()) {
+#if defined(__aarch64__)
+            uint64_t frequency;
+            __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+            secondsPerTick = 1.0 / (double)frequency;
+#else
+            // one-time calibration against the monotonic clock
+            uint64_t clock0 = acaLogClockRead(ACA_LOG_CLOCK_MONOTONIC);
+            uint64_t tsc0   = acaLogClockReadTsc();
+            acaLogSleepUs(ACA_LOG_TSC_CALIBRATION_MS * 1000);
+            uint64_t clock1 = acaLogClockRead(ACA_LOG_CLOCK_MONOTONIC);
+            uint64_t tsc1   = acaLogClockReadTsc();
+            secondsPerTick  = ((double)(clock1 - clock0) * secondsPerTick) / (double)(tsc1 - tsc0);
+#endif // __aarch64__
+        } else {
+            source = ACA_LOG_CLOCK_MONOTONIC;
+        }
+#else
+        source = ACA_LOG_CLOCK_MONOTONIC;
+#endif // ACA_LOG_CLOCK_HAS_TSC
+    }
+    gAcaLogClock.source         = source;
+    gAcaLogClock.secondsPerTick = secondsPerTick;
+    gAcaLogClock.start          = acaLogClockRead(source);
+    acaLogAtomicStore(&gAcaLogClock.state, 2);
+}
+
+static void acaLogClockInit(void) {
+    if (acaLogAtomicCas(&gAcaLogClock.state, 0, 1)) {
+        acaLogClockSetup(ACA_LOG_CLOCK);
+        return;
+    }
+    while (acaLogAtomicLoad(&gAcaLogClock.state) != 2) {
+        acaLogThreadYield();
+    }
+}
+
+// raw clock ticks - cheap enough for the hot path, convert with acaLogClockSeconds
+static inline uint64_t acaLogClockTicks(void) {
+    if (acaLogAtomicLoad(&gAcaLogClock.state) != 2) {
+        acaLogClockInit();
+    }
+    return acaLogClockRead(gAcaLogClock.source);
+}
+
+static inline double acaLogClockSeconds(uint64_t ticks) {
+    return (double)(int64_t)(ticks - gAcaLogClock.start) * gAcaLogClock.secondsPerTick;
+}
+
+// returns a monotonic timestamp value (seconds since the clock was set up)
+static double GetTimestamp() {
+    return acaLogClockSeconds(acaLogClockTicks());
+}
+
+// picks the timestamp source - only before the first timestamp was taken, since records may still
+// hold raw ticks of the current source and readers use its fields without a lock. returns the
+// source in use (MONOTONIC if the requested one isn't available, the existing one if too late)
+aca_log_clock acaLogSetClock(aca_log_clock clock) {
+    if (acaLogAtomicCas(&gAcaLogClock.state, 0, 1)) {
+        acaLogClockSetup(clock);
+    } else {
+        acaLogClockInit(); // waits for a setup in progress
+    }
+    return gAcaLogClock.source;
+}
+
+aca_log_clock acaLogGetClock(void) {
+    if (acaLogAtomicLoad(&gAcaLogClock.state) != 2) {
+        acaLogClockInit();
+    }
+    return gAcaLogClock.source;
+}
+
+double acaLogTimestamp(void) {
+    return GetTimestamp();
+}
+
+static aca_log_interval_clock *volatile gAcaLogIntervalClock = NULL;
+
+void acaLogSetIntervalClock(aca_log_interval_clock *clock) {
+    acaLogAtomicStorePtr((void *volatile *)&gAcaLogIntervalClock, (void *)clock);
+}
+
+// seconds for interval decisions - GetTimestamp unless a clock was injected
+static double acaLogIntervalNow(void) {
+    aca_log_interval_clock *clock =
+        (aca_log_interval_clock *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogIntervalClock);
+    return (clock != NULL) ? clock() : GetTimestamp();
+}
+
+THREAD_LOCAL aca_log_handler *tl_acaLogHandler      = NULL; // NULL = gAcaLogDefaultHandler
+static aca_log_handler *volatile gAcaLogDefaultHandler = acaLogStandardHandler;
+#if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS)
+static const char *gAcaLogLevelColorMap[] = {ACA_LOG_COLOR_WHITE,
+                                             ACA_LOG_COLOR_MAGENTA,
+                                             ACA_LOG_COLOR_GREEN,
+                                             ACA_LOG_COLOR_YELLOW,
+                                             ACA_LOG_COLOR_RED,
+                                             ACA_LOG_COLOR_RED};
+#endif // ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS
+
+volatile size_t gAcaLogLevel = ACA_LOG_TRACE;
+
+// sets the runtime level - records below it are skipped before their arguments are evaluated
+void acaLogSetLevel(aca_log_level level) {
+    acaLogAtomicStore(&gAcaLogLevel, (size_t)level);
+}
+
+aca_log_level acaLogGetLevel(void) {
+    return (aca_log_level)acaLogAtomicLoad(&gAcaLogLevel);
+}
+
+// rate limiter for the ACA_LOG_EVERY_N/FIRST_N/EVERY_MS/TOKENS macros - lock-free, and a call
+// that gets suppressed costs at most a couple of atomic operations however hot the site is.
+// returns non-zero if the record should be logged, with the number of records skipped since the
+// previous one in *suppressed
+int acaLogLimit(
+    aca_log_limit *limit, aca_log_limit_kind kind, size_t n, size_t burst, size_t *suppressed) {
+    size_t count, now, next, observed, allowed;
+    *suppressed = 0;
+    if (n == 0) {
+        n = 1;
+    }
+    switch (kind) {
+        case ACA_LOG_LIMIT_EVERY_N:
+            count = acaLogAtomicAdd(&limit->count, 1);
+            if ((count % n) != 0) {
+                return 0;
+            }
+            *suppressed = (count != 0) ? n - 1 : 0;
+            return 1;
+        case ACA_LOG_LIMIT_FIRST_N:
+            if (acaLogAtomicLoad(&limit->count) >= n) { // plain load once exhausted - no contention
+                return 0;
+            }
+            return acaLogAtomicAdd(&limit->count, 1) < n;
+        case ACA_LOG_LIMIT_EVERY_MS:
+        case ACA_LOG_LIMIT_TOKENS:
+            // both are a single "next allowed" timestamp (GCRA) - EVERY_MS is a bucket of one token
+            now = (size_t)(acaLogIntervalNow() * 1000000.0);
+            if (kind == ACA_LOG_LIMIT_EVERY_MS) {
+                n       = n * 1000; // interval in microseconds
+                allowed = 0;
+            } else {
+                n       = (1000000 + n - 1) / n;
+                allowed = (burst > 1) ? (burst - 1) * n : 0;
+            }
+            while (1) {
+                observed = acaLogAtomicLoad(&limit->next);
+                next     = observed;
+                if ((ptrdiff_t)(now - next) < 0) {
+                    if ((size_t)(next - now) > allowed) {
+                        acaLogAtomicAdd(&limit->suppressed, 1);
+                        return 0;
+                    }
+                } else {
+                    next = now; // site was idle - no credit beyond the burst
+                }
+                if (acaLogAtomicCas(&limit->next, observed, next + n)) {
+                    break;
+                }
+            }
+            *suppressed = acaLogAtomicExchange(&limit->suppressed, 0);
+            return 1;
+        default:
+            assert(false && "invalid log limit kind!");
+            return 1;
+    }
+}
+
+// main log entrypoint
+void acaLog(aca_log_level level, const char *file, int line, const char *fmt, ...) {
+    if ((int)level < ACA_LOG_LEVEL_LOAD()) {
+        return;
+    }
+    va_list          args;
+    aca_log_handler *handler = acaLogGetHandler();
+    va_start(args, fmt);
+    assert(handler != NULL && "no log handler set for acaLog!");
+    handler(level, file, line, fmt, args);
     va_end(args);
 }
 
-// sets a new handler for the acaLog routine
+// sets a new handler for the acaLog routine (calling thread only)
 void acaLogSetHandler(aca_log_handler *handler) {
     tl_acaLogHandler = handler;
 }
 
 // returns current log handler for acaLog routine
 aca_log_handler *acaLogGetHandler(void) {
-    return tl_acaLogHandler;
+    if (tl_acaLogHandler != NULL) {
+        return tl_acaLogHandler;
+    }
+    return (aca_log_handler *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogDefaultHandler);
 }
 
-static inline void acaLogStandardHandlerImpl(
-    FILE *fp, aca_log_level level, const char *file, int line, const char *fmt, va_list args) {
-#if defined(ACA_LOG_TAG)
-    fprintf(fp, "[" ACA_LOG_TAG "] ");
-#endif // ACA_LOG_TAG
+// sets the handler used by every thread that has no handler of its own
+void acaLogSetDefaultHandler(aca_log_handler *handler) {
+    acaLogAtomicStorePtr((void *volatile *)&gAcaLogDefaultHandler,
+                         (handler != NULL) ? (void *)handler : (void *)acaLogStandardHandler);
+}
+
+aca_log_handler *acaLogGetDefaultHandler(void) {
+    return (aca_log_handler *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogDefaultHandler);
+}
+
+// formats the [tag] [timestamp] [level] [file:line] prefix of a standard log line into buf (no
+// [tag] if tag is NULL or empty) - returns the prefix length
+static size_t acaLogStandardPrefixFormatTag(char         *buf,
+                                            size_t        size,
+                                            const char   *tag,
+                                            bool          colors,
+                                            aca_log_level level,
+                                            const char   *file,
+                                            int           line,
+                                            double        timestamp) {
+    size_t len = 0;
+    int    n   = 0;
+    buf[0]     = 0;
+    if ((tag != NULL) && (tag[0] != 0)) {
+        n = acaLogFormatf(buf, size, "[%s] ", tag);
+        len += (n > 0) ? (size_t)n : 0;
+    }
 #if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP)
-    fprintf(fp, "[%10.4f] ", GetTimestamp());
+    if (len < size) {
+        n = acaLogFormatf(&buf[len], size - len, "[%10.4f] ", timestamp);
+        len += (n > 0) ? (size_t)n : 0;
+    }
+#else
+    (void)timestamp;
 #endif // ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP
 #if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL)
     const char *levelStr;
     ACA_LOG_SET_LEVEL(level, levelStr);
+    if (len < size) {
 #if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS)
-    if (fp == stdout) { // only allow color escape codes for terminal output
-        fprintf(fp, "[%s%5s%s] ", gAcaLogLevelColorMap[level], levelStr, ACA_LOG_COLOR_RESET);
-    } else {
-        fprintf(fp, "[%5s] ", levelStr);
-    }
+        if (colors) { // only allow color escape codes for terminal output
+            n = acaLogFormatf(&buf[len],
+                              size - len,
+                              "[%s%5s%s] ",
+                              gAcaLogLevelColorMap[level],
+                              levelStr,
+                              ACA_LOG_COLOR_RESET);
+        } else {
+            n = acaLogFormatf(&buf[len], size - len, "[%5s] ", levelStr);
+        }
 #else
-    fprintf(fp, "[%5s] ", levelStr);
+        n = acaLogFormatf(&buf[len], size - len, "[%5s] ", levelStr);
 #endif // ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS
+        len += (n > 0) ? (size_t)n : 0;
+    }
 #endif // ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL
 #if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_FILELINE)
-    fprintf(fp, "[%28s] ", FormatFileLine(file, line));
+    if (len < size) {
+        n = acaLogFormatf(&buf[len], size - len, "[%28s] ", FormatFileLine(file, line));
+        len += (n > 0) ? (size_t)n : 0;
+    }
 #endif // ACA_LOG_DISABLE_STANDARD_HANDLER_FILELINE
+    (void)colors;
+    (void)level;
+    (void)file;
+    (void)line;
+    return (len < size) ? len : size - 1;
+}
+
+// standard prefix with this build's ACA_LOG_TAG
+static inline size_t acaLogStandardPrefixFormat(char         *buf,
+                                                size_t        size,
+                                                bool          colors,
+                                                aca_log_level level,
+                                                const char   *file,
+                                                int           line,
+                                                double        timestamp) {
+#if defined(ACA_LOG_TAG)
+    const char *tag = ACA_LOG_TAG;
+#else
+    const char *tag = NULL;
+#endif // ACA_LOG_TAG
+    return acaLogStandardPrefixFormatTag(buf, size, tag, colors, level, file, line, timestamp);
+}
+
+// per-thread line buffer - every record is assembled here and emitted with a single fwrite
+static THREAD_LOCAL char tl_acaLogLineBuffer[ACA_LOG_LINE_BUFFER_SIZE];
+
+// appends the formatted message and newline behind the prefixLen bytes already in the line buffer -
+// returns the line (the line buffer, or a heap buffer for oversized lines that must be freed)
+static char *acaLogFormatLine(size_t prefixLen, const char *fmt, va_list args, size_t *outLen) {
+    char   *line = tl_acaLogLineBuffer;
+    size_t  room = sizeof(tl_acaLogLineBuffer) - prefixLen;
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int    n      = acaLogFormat(&line[prefixLen], room, fmt, args);
+    size_t msgLen = (n > 0) ? (size_t)n : 0;
+    if (msgLen >= room) {
+        char *heap = (char *)malloc(prefixLen + msgLen + 2);
+        if (heap != NULL) {
+            memcpy(heap, line, prefixLen);
+            acaLogFormat(&heap[prefixLen], msgLen + 1, fmt, argsCopy);
+            line = heap;
+        } else {
+            msgLen = room - 1; // keep the truncated message
+        }
+    }
+    va_end(argsCopy);
+
+    size_t len  = prefixLen + msgLen;
+    line[len++] = '\n';
+    *outLen     = len;
+    return line;
+}
+
+// formats the line (see acaLogFormatLine) and writes it with one (locked) fwrite
+static int acaLogWriteLine(FILE *fp, size_t prefixLen, const char *fmt, va_list args) {
+    size_t len  = 0;
+    char  *line = acaLogFormatLine(prefixLen, fmt, args, &len);
+    fwrite(line, 1, len, fp);
+    if (line != tl_acaLogLineBuffer) {
+        free(line);
+    }
+    return (int)len;
+}
+
+static int acaLogWriteLinef(FILE *fp, size_t prefixLen, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = acaLogWriteLine(fp, prefixLen, fmt, args);
+    va_end(args);
+    return len;
+}
+
+// writes only the standard prefix to fp
+static inline int acaLogStandardPrefixImpl(
+    FILE *fp, aca_log_level level, const char *file, int line, double timestamp) {
+    size_t len = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                            sizeof(tl_acaLogLineBuffer),
+                                            fp == stdout,
+                                            level,
+                                            file,
+                                            line,
+                                            timestamp);
+    return (int)fwrite(tl_acaLogLineBuffer, 1, len, fp);
+}
+
+// writes a full standard log line stamped with timestamp - returns bytes written
+static inline int acaLogStandardLineImpl(FILE         *fp,
+                                         aca_log_level level,
+                                         const char   *file,
+                                         int           line,
+                                         double        timestamp,
+                                         const char   *fmt,
+                                         va_list       args) {
+    size_t prefixLen = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                                  sizeof(tl_acaLogLineBuffer),
+                                                  fp == stdout,
+                                                  level,
+                                                  file,
+                                                  line,
+                                                  timestamp);
+    return acaLogWriteLine(fp, prefixLen, fmt, args);
+}
 
-    vfprintf(fp, fmt, args);
-    fprintf(fp, "\n");
+// writes a full standard log line - returns bytes written
+static inline int acaLogStandardHandlerImpl(
+    FILE *fp, aca_log_level level, const char *file, int line, const char *fmt, va_list args) {
+    double timestamp = 0.0;
+#if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP)
+    timestamp = GetTimestamp();
+#endif // ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP
+    return acaLogStandardLineImpl(fp, level, file, line, timestamp, fmt, args);
 }
 
 // a more classic and configurable logging - log_tag, timestamp, level, file, line, fmt...
 ACA_LOG_HANDLER(acaLogStandardHandler) {
-    return acaLogStandardHandlerImpl(stdout, level, file, line, fmt, args);
+    acaLogStandardHandlerImpl(stdout, level, file, line, fmt, args);
 }
 
 // barebones logging - level fmt...
 ACA_LOG_HANDLER(acaLogBasicHandler) {
     const char *levelStr;
     ACA_LOG_SET_LEVEL(level, levelStr);
-    fprintf(stdout, "[%5s] ", levelStr);
-    vfprintf(stdout, fmt, args);
-    fprintf(stdout, "\n");
+    int prefixLen =
+        acaLogFormatf(tl_acaLogLineBuffer, sizeof(tl_acaLogLineBuffer), "[%5s] ", levelStr);
+    acaLogWriteLine(stdout, (size_t)prefixLen, fmt, args);
 }
 
 // this handler just disables/eats the logging
@@ -232,6 +2064,472 @@ ACA_LOG_HANDLER(acaLogNullHandler) {
     return;
 }
 
+// sparse time index internals - the sidecar is a header (magic, block bytes, epoch) followed by one
+// entry per block of records in log order. log bytes no entry covers (the block still being filled,
+// or data appended while nothing kept the index) are always scanned by a query. every run restarts
+// the log timestamps at 0, so each entry carries the wall clock time of its run's timestamp 0 and
+// queries compare timestamp + epoch (an index built after the fact has no epoch, it stays 0)
+#define ACA_LOG_INDEX_MAGIC "ACALIDX2"
+#define ACA_LOG_INDEX_HEADER_SIZE 24
+#define ACA_LOG_INDEX_READ_SIZE (64 * 1024)
+
+typedef struct aca_log_index_entry {
+    uint64_t start;   // log offset of the block's first record
+    uint64_t end;     // log offset just past the block's last record
+    double   first;   // earliest timestamp in the block
+    double   last;    // latest timestamp in the block
+    double   epoch;   // unix time of timestamp 0 in the run that wrote the block (0 = none)
+    uint32_t levels;  // bit per aca_log_level present in the block
+    uint32_t records; // records in the block
+} aca_log_index_entry;
+
+typedef struct aca_log_index_writer {
+    FILE               *fp;
+    uint64_t            blockBytes;
+    double              epoch;
+    aca_log_index_entry block; // block being filled (records == 0 if none)
+    uint64_t            end;   // log offset the indexed data ends at
+} aca_log_index_writer;
+
+typedef struct aca_log_index_reader {
+    FILE    *fp;
+    char    *buf;
+    size_t   len;    // bytes in buf
+    size_t   pos;    // start of the next line in buf
+    uint64_t offset; // log offset of buf[pos]
+    bool     eof;
+} aca_log_index_reader;
+
+// 64-bit fseek/ftell, logs outgrow a long on some platforms
+static int acaLogIndexSeek(FILE *fp, uint64_t offset, int whence) {
+#ifdef _WIN32
+    return _fseeki64(fp, (__int64)offset, whence);
+#else
+    return fseeko(fp, (off_t)offset, whence);
+#endif
+}
+
+static uint64_t acaLogIndexTell(FILE *fp) {
+#ifdef _WIN32
+    __int64 pos = _ftelli64(fp);
+#else
+    off_t pos = ftello(fp);
+#endif
+    return (pos > 0) ? (uint64_t)pos : 0;
+}
+
+// the header epoch is the one of the run appending to the log last, for the bytes past the entries
+static int acaLogIndexWriteHeader(FILE *fp, uint64_t blockBytes, double epoch) {
+    unsigned char header[ACA_LOG_INDEX_HEADER_SIZE] = {0};
+    uint32_t      bytes                             = (uint32_t)blockBytes;
+    memcpy(header, ACA_LOG_INDEX_MAGIC, 8);
+    memcpy(&header[8], &bytes, 4);
+    memcpy(&header[16], &epoch, 8);
+    return (fwrite(header, 1, sizeof(header), fp) == sizeof(header)) ? 0 : -1;
+}
+
+static int acaLogIndexReadHeader(FILE *fp, uint64_t *blockBytes, double *epoch) {
+    unsigned char header[ACA_LOG_INDEX_HEADER_SIZE];
+    uint32_t      bytes;
+    if ((fread(header, 1, sizeof(header), fp) != sizeof(header)) ||
+        (memcmp(header, ACA_LOG_INDEX_MAGIC, 8) != 0)) {
+        return -1;
+    }
+    memcpy(&bytes, &header[8], 4);
+    memcpy(epoch, &header[16], 8);
+    *blockBytes = bytes;
+    return 0;
+}
+
+// writes out the block being filled
+static int acaLogIndexFlushBlock(aca_log_index_writer *writer) {
+    int ret = 0;
+    if (writer->block.records != 0) {
+        ret = (fwrite(&writer->block, sizeof(writer->block), 1, writer->fp) == 1) ? 0 : -1;
+        writer->block.records = 0;
+    }
+    return ret;
+}
+
+// adds the record at log bytes [start, end) - a new block is only started by a record, so the
+// continuation lines of a multi-line message (see acaLogIndexExtend) stay with their record
+static int acaLogIndexAdd(aca_log_index_writer *writer,
+                          uint64_t              start,
+                          uint64_t              end,
+                          double                timestamp,
+                          aca_log_level         level) {
+    aca_log_index_entry *block = &writer->block;
+    int                  ret   = 0;
+    if ((block->records != 0) && (start - block->start >= writer->blockBytes)) {
+        ret = acaLogIndexFlushBlock(writer);
+    }
+    if (block->records == 0) {
+        block->start  = start;
+        block->first  = timestamp;
+        block->last   = timestamp;
+        block->epoch  = writer->epoch;
+        block->levels = 0;
+    }
+    block->end   = end;
+    block->first = (timestamp < block->first) ? timestamp : block->first;
+    block->last  = (timestamp > block->last) ? timestamp : block->last;
+    block->levels |= 1u << level;
+    block->records++;
+    writer->end = end;
+    return ret;
+}
+
+static void acaLogIndexExtend(aca_log_index_writer *writer, uint64_t end) {
+    if (writer->block.records != 0) {
+        writer->block.end = end;
+    }
+    writer->end = end;
+}
+
+static void acaLogIndexReaderSeek(aca_log_index_reader *reader, uint64_t offset) {
+    acaLogIndexSeek(reader->fp, offset, SEEK_SET);
+    reader->len    = 0;
+    reader->pos    = 0;
+    reader->offset = offset;
+    reader->eof    = false;
+}
+
+// returns the length of the next line (newline included), 0 at the end of the log. lines longer
+// than ACA_LOG_INDEX_READ_SIZE come back in pieces
+static size_t acaLogIndexNextLine(aca_log_index_reader *reader, const char **line) {
+    while (1) {
+        char  *begin = &reader->buf[reader->pos];
+        size_t avail = reader->len - reader->pos;
+        char  *eol   = (char *)memchr(begin, '\n', avail);
+        if ((eol != NULL) || (avail == ACA_LOG_INDEX_READ_SIZE) || (reader->eof && (avail != 0))) {
+            size_t len = (eol != NULL) ? (size_t)(eol - begin) + 1 : avail;
+            reader->pos += len;
+            reader->offset += len;
+            *line = begin;
+            return len;
+        }
+        if (reader->eof) {
+            return 0;
+        }
+        memmove(reader->buf, begin, avail);
+        size_t got  = fread(&reader->buf[avail], 1, ACA_LOG_INDEX_READ_SIZE - avail, reader->fp);
+        reader->len = avail + got;
+        reader->pos = 0;
+        reader->eof = (got == 0);
+    }
+}
+
+// picks the timestamp and level out of the leading [...] fields of a standard line - false for a
+// line that doesn't start a record (e.g. the continuation lines of a multi-line message)
+static bool acaLogIndexParseLine(const char    *line,
+                                 size_t         len,
+                                 double        *timestamp,
+                                 aca_log_level *level) {
+    bool   hasTimestamp = false;
+    bool   hasLevel     = false;
+    size_t pos          = 0;
+    while ((pos < len) && (line[pos] == '[') && !(hasTimestamp && hasLevel)) {
+        const char *close = (const char *)memchr(&line[pos], ']', len - pos);
+        if (close == NULL) {
+            break;
+        }
+        char   field[32];
+        size_t fieldLen = (size_t)(close - &line[pos]) - 1;
+        if (fieldLen < sizeof(field)) {
+            memcpy(field, &line[pos + 1], fieldLen);
+            field[fieldLen] = 0;
+            char  *numberEnd;
+            double number = strtod(field, &numberEnd);
+            if (!hasTimestamp && (numberEnd != field) && (*numberEnd == 0)) {
+                *timestamp   = number;
+                hasTimestamp = true;
+            } else if (!hasLevel) {
+                const char *name = field + strspn(field, " ");
+                for (int l = ACA_LOG_TRACE; (l <= ACA_LOG_FATAL) && !hasLevel; ++l) {
+                    const char *levelStr;
+                    ACA_LOG_SET_LEVEL((aca_log_level)l, levelStr);
+                    if (strcmp(name, levelStr) == 0) {
+                        *level   = (aca_log_level)l;
+                        hasLevel = true;
+                    }
+                }
+            }
+        }
+        pos = (size_t)(close - line) + 1;
+        pos += (pos < len) && (line[pos] == ' ');
+    }
+    return hasTimestamp && hasLevel;
+}
+
+// scans through an existing standard format log and writes its index (blockBytes 0 = 64 KiB)
+int acaLogIndexBuild(FILE *log, FILE *index, size_t blockBytes) {
+    aca_log_index_writer writer;
+    aca_log_index_reader reader;
+    memset(&writer, 0, sizeof(writer));
+    memset(&reader, 0, sizeof(reader));
+    writer.fp         = index;
+    writer.blockBytes = (blockBytes != 0) ? blockBytes : 64 * 1024;
+    reader.fp         = log;
+    reader.buf        = (char *)malloc(ACA_LOG_INDEX_READ_SIZE);
+    if (reader.buf == NULL) {
+        return -1;
+    }
+    acaLogIndexReaderSeek(&reader, 0);
+
+    const char *line;
+    size_t      len;
+    int         ret = acaLogIndexWriteHeader(index, writer.blockBytes, 0.0);
+    while ((ret == 0) && ((len = acaLogIndexNextLine(&reader, &line)) != 0)) {
+        double        timestamp;
+        aca_log_level level;
+        if (acaLogIndexParseLine(line, len, &timestamp, &level)) {
+            ret = acaLogIndexAdd(&writer, reader.offset - len, reader.offset, timestamp, level);
+        } else {
+            acaLogIndexExtend(&writer, reader.offset);
+        }
+    }
+    if (ret == 0) {
+        ret = acaLogIndexFlushBlock(&writer);
+    }
+    free(reader.buf);
+    return ((ret == 0) && (fflush(index) == 0)) ? 0 : -1;
+}
+
+typedef struct aca_log_index_query {
+    aca_log_index_reader reader;
+    double               from;
+    double               to;
+    aca_log_level        minLevel;
+    FILE                *out;
+    long                 records;
+    size_t               scanned;
+    uint64_t             start; // pending range of log bytes to scan
+    uint64_t             end;
+    double               epoch; // added to the timestamps of the pending range
+} aca_log_index_query;
+
+// writes the matching records of log bytes [start, end), which starts at a record
+static void acaLogIndexScan(aca_log_index_query *query, uint64_t start, uint64_t end) {
+    aca_log_index_reader *reader = &query->reader;
+    bool                  match  = false;
+    const char           *line;
+    size_t                len;
+    acaLogIndexReaderSeek(reader, start);
+    while ((reader->offset < end) && ((len = acaLogIndexNextLine(reader, &line)) != 0)) {
+        double        timestamp;
+        aca_log_level level;
+        if (acaLogIndexParseLine(line, len, &timestamp, &level)) {
+            timestamp += query->epoch;
+            match = (timestamp >= query->from) && (timestamp <= query->to) &&
+                    (level >= query->minLevel);
+            query->records += match;
+        }
+        if (match) {
+            fwrite(line, 1, len, query->out);
+        }
+    }
+    query->scanned += (size_t)(reader->offset - start);
+}
+
+// adds [start, end) to the pending range, scanning the pending range first if they don't touch or
+// come from different runs
+static void acaLogIndexQueryRange(aca_log_index_query *query,
+                                  uint64_t             start,
+                                  uint64_t             end,
+                                  double               epoch) {
+    if ((query->end > query->start) && (query->end == start) && (query->epoch == epoch)) {
+        query->end = end;
+        return;
+    }
+    if (query->end > query->start) {
+        acaLogIndexScan(query, query->start, query->end);
+    }
+    query->start = start;
+    query->end   = end;
+    query->epoch = epoch;
+}
+
+// writes the records of log within [from, to] at/above minLevel to out - reads only the blocks the
+// index can't rule out. from/to are on the index's time axis (timestamp + epoch, see above).
+// returns the records written, or -1 if index doesn't belong to log
+long acaLogIndexQuery(FILE         *log,
+                      FILE         *index,
+                      double        from,
+                      double        to,
+                      aca_log_level minLevel,
+                      FILE         *out,
+                      size_t       *scanned) {
+    aca_log_index_query query;
+    aca_log_index_entry entry;
+    uint64_t            blockBytes;
+    uint64_t            cursor    = 0;
+    double              tailEpoch = 0.0;
+    memset(&query, 0, sizeof(query));
+
+    // an index whose entries aren't in order or run past the end of log is stale
+    if (index != NULL) {
+        acaLogIndexSeek(log, 0, SEEK_END);
+        uint64_t size = acaLogIndexTell(log);
+        rewind(index);
+        if (acaLogIndexReadHeader(index, &blockBytes, &tailEpoch) != 0) {
+            return -1;
+        }
+        while (fread(&entry, sizeof(entry), 1, index) == 1) {
+            if ((entry.start < cursor) || (entry.end < entry.start) || (entry.end > size)) {
+                return -1;
+            }
+            cursor = entry.end;
+        }
+        cursor = 0;
+    }
+
+    query.reader.fp  = log;
+    query.reader.buf = (char *)malloc(ACA_LOG_INDEX_READ_SIZE);
+    query.from       = from;
+    query.to         = to;
+    query.minLevel   = minLevel;
+    query.out        = out;
+    if (query.reader.buf == NULL) {
+        return -1;
+    }
+    if (index != NULL) {
+        acaLogIndexSeek(index, ACA_LOG_INDEX_HEADER_SIZE, SEEK_SET);
+        while (fread(&entry, sizeof(entry), 1, index) == 1) {
+            if (entry.start > cursor) {
+                acaLogIndexQueryRange(&query, cursor, entry.start, entry.epoch); // not indexed
+            }
+            if ((entry.last + entry.epoch >= from) && (entry.first + entry.epoch <= to) &&
+                ((entry.levels >> minLevel) != 0)) {
+                acaLogIndexQueryRange(&query, entry.start, entry.end, entry.epoch);
+            }
+            cursor = entry.end;
+        }
+    }
+    acaLogIndexQueryRange(&query, cursor, UINT64_MAX, tailEpoch); // the tail past the last block
+    acaLogIndexQueryRange(&query, 0, 0, 0.0);
+    free(query.reader.buf);
+    if (scanned != NULL) {
+        *scanned = query.scanned;
+    }
+    return query.records;
+}
+
+#if defined(ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB)
+#if defined(ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP)
+#error "ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB needs the standard handler timestamp"
+#endif // ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP
+#if !defined(ACA_LOG_TO_STANDARD_FILE_HANDLER_ACCESS_STR)
+// the default "w" truncates the log on every record, the index would restart with each one
+#error "ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB needs an appending ACCESS_STR (\"a\")"
+#endif // ACA_LOG_TO_STANDARD_FILE_HANDLER_ACCESS_STR
+
+// index kept by acaLogStandardFileHandler - assumes no other process appends to the same log
+static struct {
+    aca_log_mutex        lock;
+    aca_log_index_writer writer;
+    bool                 registered;
+    double               epoch;
+} gAcaLogIndex = {ACA_LOG_MUTEX_INIT};
+
+// unix time in seconds
+static double acaLogIndexWallClock(void) {
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime; // 100 ns since 1601
+    return (double)(ticks - 116444736000000000ULL) * 1e-7;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static void acaLogIndexClose(void) {
+    acaLogMutexLock(&gAcaLogIndex.lock);
+    if (gAcaLogIndex.writer.fp != NULL) {
+        acaLogIndexFlushBlock(&gAcaLogIndex.writer);
+        fclose(gAcaLogIndex.writer.fp);
+        gAcaLogIndex.writer.fp = NULL;
+    }
+    acaLogMutexUnlock(&gAcaLogIndex.lock);
+}
+
+// opens log.idx - an index left by an earlier run is continued if its entries end before start
+static void acaLogIndexOpenLocked(const char *log, uint64_t start) {
+    aca_log_index_writer *writer     = &gAcaLogIndex.writer;
+    uint64_t              blockBytes = (uint64_t)ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB * 1024;
+    uint64_t              bytes      = 0;
+    double                epoch      = 0.0;
+    aca_log_index_entry   last;
+    char                  path[512];
+    acaLogFormatf(path, sizeof(path), "%s.idx", log);
+    last.end = 0;
+
+    bool  resume = false;
+    FILE *fp     = fopen(path, "rb");
+    if (fp != NULL) {
+        resume = (acaLogIndexReadHeader(fp, &bytes, &epoch) == 0) && (bytes == blockBytes);
+        acaLogIndexSeek(fp, 0, SEEK_END);
+        uint64_t size = acaLogIndexTell(fp);
+        resume = resume && (((size - ACA_LOG_INDEX_HEADER_SIZE) % sizeof(last)) == 0);
+        if (resume && (size > ACA_LOG_INDEX_HEADER_SIZE)) {
+            acaLogIndexSeek(fp, size - sizeof(last), SEEK_SET);
+            resume = (fread(&last, sizeof(last), 1, fp) == 1) && (last.end <= start);
+        }
+        fclose(fp);
+    }
+    if (!gAcaLogIndex.registered) { // once per run, so the blocks of a run share their epoch
+        gAcaLogIndex.registered = true;
+        gAcaLogIndex.epoch      = acaLogIndexWallClock() - GetTimestamp();
+        atexit(acaLogIndexClose);
+    }
+
+    // the header is rewritten with this run's epoch, then the entries are appended
+    writer->fp = fopen(path, resume ? "r+b" : "wb");
+    if (writer->fp == NULL) {
+        return;
+    }
+    acaLogIndexWriteHeader(writer->fp, blockBytes, gAcaLogIndex.epoch);
+    acaLogIndexSeek(writer->fp, 0, SEEK_END);
+    if (!resume) {
+        last.end = 0;
+    }
+    writer->blockBytes    = blockBytes;
+    writer->epoch         = gAcaLogIndex.epoch;
+    writer->block.records = 0;
+    writer->end           = last.end;
+}
+
+// writes the record and indexes it - the lock keeps log offsets and index entries in step
+static void acaLogIndexAppendRecord(FILE         *fp,
+                                    const char   *log,
+                                    aca_log_level level,
+                                    const char   *file,
+                                    int           line,
+                                    const char   *fmt,
+                                    va_list       args) {
+    aca_log_index_writer *writer    = &gAcaLogIndex.writer;
+    double                timestamp = GetTimestamp();
+    acaLogMutexLock(&gAcaLogIndex.lock);
+    int len = acaLogStandardLineImpl(fp, level, file, line, timestamp, fmt, args);
+    fflush(fp);
+    uint64_t end   = acaLogIndexTell(fp);
+    uint64_t start = (end > (uint64_t)len) ? end - (uint64_t)len : 0;
+    if ((writer->fp != NULL) && (start < writer->end)) { // truncated or rewritten, start over
+        fclose(writer->fp);
+        writer->fp = NULL;
+    }
+    if (writer->fp == NULL) {
+        acaLogIndexOpenLocked(log, start);
+    }
+    if (writer->fp != NULL) {
+        acaLogIndexAdd(writer, start, end, timestamp, level);
+    }
+    acaLogMutexUnlock(&gAcaLogIndex.lock);
+}
+#endif // ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB
+
 // same as standard handler but routes to a file vs. stdout
 ACA_LOG_HANDLER(acaLogStandardFileHandler) {
     FILE       *fp             = NULL;
@@ -247,6 +2545,12 @@ ACA_LOG_HANDLER(acaLogStandardFileHandler) {
         assert(false && "cannot read a log file!");
         return;
     }
+#if defined(ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB)
+    if (strchr(dumpFileAccess, 'a') == NULL) {
+        assert(false && "an indexed log file must be appended to!");
+        return;
+    }
+#endif // ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB
 #endif // ACA_LOG_TO_STANDARD_FILE_HANDLER_ACCESS_STR
 #ifdef _WIN32
     if (fopen_s(&fp, dumpFile, dumpFileAccess) != 0) {
@@ -261,10 +2565,4454 @@ ACA_LOG_HANDLER(acaLogStandardFileHandler) {
     }
 #endif
 
+#if defined(ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB)
+    acaLogIndexAppendRecord(fp, dumpFile, level, file, line, fmt, args);
+#else
     acaLogStandardHandlerImpl(fp, level, file, line, fmt, args);
+#endif // ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB
     fclose(fp);
 }
 
+// async handler internals - a bounded MPSC queue of fixed-size record slots (each slot carries a
+// sequence number so producers can claim slots lock-free) drained by a single writer thread
+typedef struct aca_log_async_slot {
+    volatile size_t seq;
+    aca_log_level   level;
+    const char     *file;
+    int             line;
+    uint64_t        ticks; // converted by the writer thread
+    size_t          msgLen;
+    char            msg[ACA_LOG_ASYNC_MSG_SIZE];
+} aca_log_async_slot;
+
+static struct {
+    aca_log_async_slot         *slots;
+    size_t                      mask;
+    aca_log_async_full_behavior fullBehavior;
+    unsigned int                sampleRate;
+    FILE                       *fp;
+    aca_log_thread              thread;
+    size_t                      reportedDrops;
+    volatile size_t             running;
+    volatile size_t             producers; // handler calls in flight - slots are freed at 0 only
+    char                        pad0[64];  // keep producer/consumer counters on separate lines
+    volatile size_t             enqueuePos;
+    volatile size_t             sampleCounter;
+    volatile size_t             dropped;
+    char                        pad1[64];
+    volatile size_t             dequeuePos;
+    volatile size_t             flushedPos; // dequeuePos as of the last fflush
+} gAcaLogAsync;
+
+// claims a free slot - returns NULL if the queue is full
+static aca_log_async_slot *acaLogAsyncReserve(size_t *outPos) {
+    size_t pos = acaLogAtomicLoad(&gAcaLogAsync.enqueuePos);
+    while (1) {
+        aca_log_async_slot *slot = &gAcaLogAsync.slots[pos & gAcaLogAsync.mask];
+        size_t              seq  = acaLogAtomicLoad(&slot->seq);
+        if (seq == pos) {
+            if (acaLogAtomicCas(&gAcaLogAsync.enqueuePos, pos, pos + 1)) {
+                *outPos = pos;
+                return slot;
+            }
+        } else if (seq < pos) {
+            return NULL;
+        }
+        pos = acaLogAtomicLoad(&gAcaLogAsync.enqueuePos);
+    }
+}
+
+// writes out every published record - only called by the writer thread (or after it is joined)
+static size_t acaLogAsyncDrain(void) {
+    size_t count = 0;
+    while (1) {
+        size_t              pos  = gAcaLogAsync.dequeuePos;
+        aca_log_async_slot *slot = &gAcaLogAsync.slots[pos & gAcaLogAsync.mask];
+        if (acaLogAtomicLoad(&slot->seq) != pos + 1) {
+            break;
+        }
+        size_t prefixLen = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                                      sizeof(tl_acaLogLineBuffer),
+                                                      gAcaLogAsync.fp == stdout,
+                                                      slot->level,
+                                                      slot->file,
+                                                      slot->line,
+                                                      acaLogClockSeconds(slot->ticks));
+        acaLogWriteLinef(gAcaLogAsync.fp, prefixLen, "%.*s", (int)slot->msgLen, slot->msg);
+
+        acaLogAtomicStore(&slot->seq, pos + gAcaLogAsync.mask + 1);
+        acaLogAtomicStore(&gAcaLogAsync.dequeuePos, pos + 1);
+        ++count;
+    }
+
+    size_t dropped = acaLogAtomicLoad(&gAcaLogAsync.dropped);
+    if (dropped != gAcaLogAsync.reportedDrops) {
+        size_t prefixLen = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                                      sizeof(tl_acaLogLineBuffer),
+                                                      gAcaLogAsync.fp == stdout,
+                                                      ACA_LOG_WARN,
+                                                      __FILE__,
+                                                      __LINE__,
+                                                      GetTimestamp());
+        acaLogWriteLinef(gAcaLogAsync.fp,
+                         prefixLen,
+                         "async queue full - dropped %lu record(s)",
+                         (unsigned long)(dropped - gAcaLogAsync.reportedDrops));
+        gAcaLogAsync.reportedDrops = dropped;
+        ++count;
+    }
+    if (count > 0) {
+        fflush(gAcaLogAsync.fp);
+    }
+    acaLogAtomicStore(&gAcaLogAsync.flushedPos, gAcaLogAsync.dequeuePos);
+    return count;
+}
+
+ACA_LOG_THREAD_ROUTINE(acaLogAsyncWriter) {
+    (void)arg;
+    while (1) {
+        if (acaLogAsyncDrain() == 0) {
+            if (!acaLogAtomicLoad(&gAcaLogAsync.running)) {
+                break;
+            }
+            acaLogSleepUs(ACA_LOG_ASYNC_IDLE_US);
+        }
+    }
+    ACA_LOG_THREAD_RETURN;
+}
+
+// starts the async writer thread - returns 0 on success
+int acaLogAsyncStart(const aca_log_async_config *config) {
+    static bool registeredAtExit = false;
+    if (acaLogAtomicLoad(&gAcaLogAsync.running)) {
+        return -1;
+    }
+
+    size_t capacity = 2;
+    while (capacity < ((config && config->capacity) ? config->capacity : 1024)) {
+        capacity <<= 1;
+    }
+    aca_log_async_slot *slots = (aca_log_async_slot *)malloc(capacity * sizeof(*slots));
+    if (slots == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].seq = i;
+    }
+
+    gAcaLogAsync.slots         = slots;
+    gAcaLogAsync.mask          = capacity - 1;
+    gAcaLogAsync.fullBehavior  = config ? config->fullBehavior : ACA_LOG_ASYNC_DROP;
+    gAcaLogAsync.sampleRate    = (config && config->sampleRate) ? config->sampleRate : 8;
+    gAcaLogAsync.fp            = (config && config->fp) ? config->fp : stdout;
+    gAcaLogAsync.reportedDrops = 0;
+    gAcaLogAsync.enqueuePos    = 0;
+    gAcaLogAsync.dequeuePos    = 0;
+    gAcaLogAsync.flushedPos    = 0;
+    gAcaLogAsync.sampleCounter = 0;
+    gAcaLogAsync.dropped       = 0;
+    acaLogAtomicStore(&gAcaLogAsync.running, 1);
+    if (acaLogThreadCreate(&gAcaLogAsync.thread, acaLogAsyncWriter) != 0) {
+        acaLogAtomicStore(&gAcaLogAsync.running, 0);
+        free(slots);
+        gAcaLogAsync.slots = NULL;
+        return -1;
+    }
+
+    // guarantees queued records still reach the output on a normal exit
+    if (!registeredAtExit) {
+        atexit(acaLogAsyncStop);
+        registeredAtExit = true;
+    }
+    return 0;
+}
+
+// blocks until every record enqueued before this call has been written out and flushed
+void acaLogAsyncFlush(void) {
+    if (!acaLogAtomicLoad(&gAcaLogAsync.running)) {
+        return;
+    }
+    size_t target = acaLogAtomicLoad(&gAcaLogAsync.enqueuePos);
+    while (acaLogAtomicLoad(&gAcaLogAsync.flushedPos) < target) {
+        acaLogThreadYield();
+    }
+}
+
+// drains the queue and stops the writer thread (async handler falls back to the standard handler)
+void acaLogAsyncStop(void) {
+    if (!acaLogAtomicCas(&gAcaLogAsync.running, 1, 0)) {
+        return;
+    }
+    // producers that got past the running check may still write into the slots
+    while (acaLogAtomicLoad(&gAcaLogAsync.producers) != 0) {
+        acaLogThreadYield();
+    }
+    acaLogThreadJoin(gAcaLogAsync.thread);
+    acaLogAsyncDrain();
+    free(gAcaLogAsync.slots);
+    gAcaLogAsync.slots = NULL;
+}
+
+// total records dropped due to back-pressure since the last acaLogAsyncStart
+size_t acaLogAsyncDropped(void) {
+    return acaLogAtomicLoad(&gAcaLogAsync.dropped);
+}
+
+// claims a slot (honouring the full behavior) and fills it - the caller is counted in producers
+static void acaLogAsyncEnqueue(
+    aca_log_level level, const char *file, int line, const char *fmt, va_list args) {
+    if (gAcaLogAsync.fullBehavior == ACA_LOG_ASYNC_SAMPLE) {
+        size_t capacity = gAcaLogAsync.mask + 1;
+        size_t used     = acaLogAtomicLoad(&gAcaLogAsync.enqueuePos) -
+                      acaLogAtomicLoad(&gAcaLogAsync.dequeuePos);
+        if ((used >= capacity - (capacity / 4)) &&
+            (acaLogAtomicAdd(&gAcaLogAsync.sampleCounter, 1) % gAcaLogAsync.sampleRate) != 0) {
+            acaLogAtomicAdd(&gAcaLogAsync.dropped, 1);
+            return;
+        }
+    }
+
+    size_t              pos;
+    aca_log_async_slot *slot = acaLogAsyncReserve(&pos);
+    while (slot == NULL) {
+        if ((gAcaLogAsync.fullBehavior != ACA_LOG_ASYNC_BLOCK) ||
+            !acaLogAtomicLoad(&gAcaLogAsync.running)) {
+            acaLogAtomicAdd(&gAcaLogAsync.dropped, 1);
+            return;
+        }
+        acaLogThreadYield();
+        slot = acaLogAsyncReserve(&pos);
+    }
+
+    slot->level     = level;
+    slot->file      = file;
+    slot->line      = line;
+    slot->ticks     = acaLogClockTicks();
+    int len         = acaLogFormat(slot->msg, sizeof(slot->msg), fmt, args);
+    slot->msgLen    = (len < 0) ? 0 : (size_t)len;
+    if (slot->msgLen >= sizeof(slot->msg)) {
+        slot->msgLen = sizeof(slot->msg) - 1;
+    }
+    acaLogAtomicStore(&slot->seq, pos + 1);
+}
+
+// captures level, file, line, timestamp and the formatted message into a queue slot - the writer
+// thread does the prefix formatting and I/O
+ACA_LOG_HANDLER(acaLogAsyncHandler) {
+    acaLogAtomicAdd(&gAcaLogAsync.producers, 1); // announced before running is checked
+    if (!acaLogAtomicLoad(&gAcaLogAsync.running)) {
+        acaLogAtomicAdd(&gAcaLogAsync.producers, (size_t)-1);
+        acaLogStandardHandler(level, file, line, fmt, args);
+        return;
+    }
+    acaLogAsyncEnqueue(level, file, line, fmt, args);
+    acaLogAtomicAdd(&gAcaLogAsync.producers, (size_t)-1);
+
+    if (level == ACA_LOG_FATAL) {
+        acaLogAsyncFlush();
+    }
+}
+
+// buffered file handler internals - one process-wide file guarded by a mutex
+static struct {
+    aca_log_mutex       lock;
+    aca_log_file_config config;
+    char                path[256];
+    FILE               *fp;
+    char               *buffer;
+    size_t              fileBytes;
+    double              openedAt;
+    double              lastFlush;
+    bool                dirty; // records written since the last flush
+    aca_log_thread      flusher;
+    volatile size_t     flusherRunning;
+} gAcaLogFile = {ACA_LOG_MUTEX_INIT};
+
+static void acaLogFileFlushLocked(double now) {
+    fflush(gAcaLogFile.fp);
+    gAcaLogFile.lastFlush = now;
+    gAcaLogFile.dirty     = false;
+}
+
+static int acaLogFileOpenLocked(void) {
+    gAcaLogFile.fp = fopen(gAcaLogFile.path, "a");
+    if (gAcaLogFile.fp == NULL) {
+        return -1;
+    }
+    setvbuf(gAcaLogFile.fp, gAcaLogFile.buffer, _IOFBF, gAcaLogFile.config.bufferSize);
+    fseek(gAcaLogFile.fp, 0, SEEK_END);
+    long size             = ftell(gAcaLogFile.fp);
+    gAcaLogFile.fileBytes = (size > 0) ? (size_t)size : 0;
+    gAcaLogFile.openedAt  = acaLogIntervalNow();
+    gAcaLogFile.lastFlush = gAcaLogFile.openedAt;
+    gAcaLogFile.dirty     = false;
+    return 0;
+}
+
+// flushes records that have waited flushInterval, even if no further record arrives to notice -
+// wakes up a few times per interval (at most every 50 ms)
+ACA_LOG_THREAD_ROUTINE(acaLogFileFlusher) {
+    (void)arg;
+    while (acaLogAtomicLoad(&gAcaLogFile.flusherRunning)) {
+        acaLogMutexLock(&gAcaLogFile.lock);
+        double interval = gAcaLogFile.config.flushInterval;
+        double now      = acaLogIntervalNow();
+        if ((gAcaLogFile.fp != NULL) && gAcaLogFile.dirty &&
+            (now - gAcaLogFile.lastFlush >= interval)) {
+            acaLogFileFlushLocked(now);
+        }
+        acaLogMutexUnlock(&gAcaLogFile.lock);
+        double step = (interval / 4.0 < 0.05) ? interval / 4.0 : 0.05;
+        acaLogSleepUs((step > 0.001) ? (unsigned int)(step * 1000000.0) : 1000);
+    }
+    ACA_LOG_THREAD_RETURN;
+}
+
+// shifts path -> path.1 -> path.2 ... dropping anything past maxFiles, then reopens path
+static void acaLogFileRotateLocked(void) {
+    char from[sizeof(gAcaLogFile.path) + 16];
+    char to[sizeof(gAcaLogFile.path) + 16];
+    fclose(gAcaLogFile.fp);
+    gAcaLogFile.fp = NULL;
+
+    unsigned int maxFiles = gAcaLogFile.config.maxFiles;
+    if (maxFiles == 0) {
+        remove(gAcaLogFile.path);
+    } else {
+        snprintf(to, sizeof(to), "%s.%u", gAcaLogFile.path, maxFiles);
+        remove(to);
+        for (unsigned int i = maxFiles - 1; i > 0; --i) {
+            snprintf(from, sizeof(from), "%s.%u", gAcaLogFile.path, i);
+            snprintf(to, sizeof(to), "%s.%u", gAcaLogFile.path, i + 1);
+            rename(from, to);
+        }
+        snprintf(to, sizeof(to), "%s.1", gAcaLogFile.path);
+        rename(gAcaLogFile.path, to);
+    }
+    acaLogFileOpenLocked();
+}
+
+// opens (or re-opens) the buffered log file - returns 0 on success
+int acaLogFileOpen(const aca_log_file_config *config) {
+    aca_log_file_config defaults = ACA_LOG_FILE_CONFIG_INIT;
+#if defined(ACA_LOG_TO_STANDARD_FILE_HANDLER_FILENAME)
+    defaults.path = ACA_LOG_TO_STANDARD_FILE_HANDLER_FILENAME;
+#endif // ACA_LOG_TO_STANDARD_FILE_HANDLER_FILENAME
+    static bool registeredAtExit = false;
+
+    acaLogFileClose();
+    acaLogMutexLock(&gAcaLogFile.lock);
+    gAcaLogFile.config = config ? *config : defaults;
+    if (gAcaLogFile.config.path == NULL) {
+        gAcaLogFile.config.path = defaults.path;
+    }
+    if (gAcaLogFile.config.bufferSize == 0) {
+        gAcaLogFile.config.bufferSize = defaults.bufferSize;
+    }
+    snprintf(gAcaLogFile.path, sizeof(gAcaLogFile.path), "%s", gAcaLogFile.config.path);
+
+    int ret            = -1;
+    gAcaLogFile.buffer = (char *)malloc(gAcaLogFile.config.bufferSize);
+    if (gAcaLogFile.buffer != NULL) {
+        ret = acaLogFileOpenLocked();
+        if (ret != 0) {
+            free(gAcaLogFile.buffer);
+            gAcaLogFile.buffer = NULL;
+        }
+    }
+    if ((ret == 0) && (gAcaLogFile.config.flushInterval > 0.0) &&
+        (acaLogAtomicExchange(&gAcaLogFile.flusherRunning, 1) == 0) &&
+        (acaLogThreadCreate(&gAcaLogFile.flusher, acaLogFileFlusher) != 0)) {
+        acaLogAtomicStore(&gAcaLogFile.flusherRunning, 0); // records still check the interval
+    }
+    if ((ret == 0) && !registeredAtExit) {
+        atexit(acaLogFileClose);
+        registeredAtExit = true;
+    }
+    acaLogMutexUnlock(&gAcaLogFile.lock);
+    return ret;
+}
+
+// pushes the user-space buffer out to the file
+void acaLogFileFlush(void) {
+    acaLogMutexLock(&gAcaLogFile.lock);
+    if (gAcaLogFile.fp != NULL) {
+        acaLogFileFlushLocked(acaLogIntervalNow());
+    }
+    acaLogMutexUnlock(&gAcaLogFile.lock);
+}
+
+// flushes and closes the buffered log file
+void acaLogFileClose(void) {
+    if (acaLogAtomicExchange(&gAcaLogFile.flusherRunning, 0) != 0) {
+        acaLogThreadJoin(gAcaLogFile.flusher);
+    }
+    acaLogMutexLock(&gAcaLogFile.lock);
+    if (gAcaLogFile.fp != NULL) {
+        fclose(gAcaLogFile.fp);
+        gAcaLogFile.fp = NULL;
+    }
+    free(gAcaLogFile.buffer);
+    gAcaLogFile.buffer = NULL;
+    acaLogMutexUnlock(&gAcaLogFile.lock);
+}
+
+// same output as the standard file handler, but the file stays open and writes are buffered -
+// flushes on a full buffer, flushInterval (checked here and by the flusher thread while idle) or
+// level >= flushLevel. if the file isn't open (closed, or reopening it after a rotation failed) it
+// is opened again with the last config (defaults if acaLogFileOpen was never called)
+ACA_LOG_HANDLER(acaLogBufferedFileHandler) {
+    acaLogMutexLock(&gAcaLogFile.lock);
+    if (gAcaLogFile.fp == NULL) {
+        aca_log_file_config config = gAcaLogFile.config;
+        char                path[sizeof(gAcaLogFile.path)];
+        memcpy(path, gAcaLogFile.path, sizeof(path));
+        config.path = path;
+        acaLogMutexUnlock(&gAcaLogFile.lock);
+        if (acaLogFileOpen((path[0] != 0) ? &config : NULL) != 0) {
+            assert(false && "failed to open log file!");
+            return;
+        }
+        acaLogMutexLock(&gAcaLogFile.lock);
+    }
+    if (gAcaLogFile.fp == NULL) {
+        acaLogMutexUnlock(&gAcaLogFile.lock);
+        return;
+    }
+    double now = acaLogIntervalNow();
+    if ((gAcaLogFile.config.rotateInterval > 0.0) &&
+        (now - gAcaLogFile.openedAt >= gAcaLogFile.config.rotateInterval)) {
+        acaLogFileRotateLocked();
+    }
+    if (gAcaLogFile.fp == NULL) {
+        acaLogMutexUnlock(&gAcaLogFile.lock);
+        return;
+    }
+
+    int written = acaLogStandardHandlerImpl(gAcaLogFile.fp, level, file, line, fmt, args);
+    gAcaLogFile.fileBytes += (written > 0) ? (size_t)written : 0;
+    gAcaLogFile.dirty = true;
+
+    if ((level >= gAcaLogFile.config.flushLevel) ||
+        ((gAcaLogFile.config.flushInterval > 0.0) &&
+         (now - gAcaLogFile.lastFlush >= gAcaLogFile.config.flushInterval))) {
+        acaLogFileFlushLocked(now);
+    }
+    if ((gAcaLogFile.config.rotateBytes > 0) &&
+        (gAcaLogFile.fileBytes >= gAcaLogFile.config.rotateBytes)) {
+        acaLogFileRotateLocked();
+    }
+    acaLogMutexUnlock(&gAcaLogFile.lock);
+}
+
+// mmap segment handler internals - appenders reserve space with one atomic add and copy the line
+// in without any lock. each segment counts the appenders currently copying into it so the mapping
+// is only released once the last of them is done, the mutex only serializes rolling segments.
+// appenders also hold a global pin while they use a segment descriptor (taken before the current
+// pointer is loaded), released descriptors are only freed once no appender is pinned
+typedef struct aca_log_mmap_segment {
+    struct aca_log_mmap_segment *next; // released list
+    char                        *map;
+    size_t                       size;
+    unsigned int                 index;
+    volatile size_t              used;    // reserved bytes (may overshoot size once it is full)
+    volatile size_t              end;     // first failed reservation - nothing written past it
+    volatile size_t              writers; // appenders currently copying into the mapping
+    volatile size_t              retired; // set once a newer segment took over
+#if !defined(_WIN32)
+    int fd;
+#endif // _WIN32
+} aca_log_mmap_segment;
+
+static struct {
+    aca_log_mutex                  lock;
+    aca_log_mmap_config            config;
+    char                           path[256];
+    unsigned int                   index;
+    aca_log_mmap_segment *volatile current;
+    aca_log_mmap_segment          *spare;    // preallocated next segment
+    aca_log_mmap_segment          *released; // unmapped descriptors appenders may still hold
+    volatile size_t                pins;     // appenders that may hold a segment descriptor
+} gAcaLogMmap = {ACA_LOG_MUTEX_INIT};
+
+#if !defined(_WIN32)
+// creates, preallocates and maps the next segment file - returns NULL on failure
+static aca_log_mmap_segment *acaLogMmapSegmentCreate(void) {
+    char path[sizeof(gAcaLogMmap.path) + 16];
+    snprintf(path, sizeof(path), "%s.%06u", gAcaLogMmap.path, gAcaLogMmap.index++);
+
+    aca_log_mmap_segment *seg = (aca_log_mmap_segment *)calloc(1, sizeof(aca_log_mmap_segment));
+    if (seg == NULL) {
+        return NULL;
+    }
+    seg->size  = gAcaLogMmap.config.segmentSize;
+    seg->index = gAcaLogMmap.index - 1;
+    seg->end   = seg->size;
+    seg->fd    = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (seg->fd < 0) {
+        free(seg);
+        return NULL;
+    }
+#if defined(__linux__)
+    // reserve the blocks up front so page faults never have to allocate (and can't hit ENOSPC)
+    int err = posix_fallocate(seg->fd, 0, (off_t)seg->size);
+#else
+    int err = ftruncate(seg->fd, (off_t)seg->size);
+#endif // __linux__
+    if (err == 0) {
+        seg->map = (char *)mmap(NULL, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED, seg->fd, 0);
+    }
+    if ((err != 0) || (seg->map == MAP_FAILED)) {
+        close(seg->fd);
+        unlink(path);
+        free(seg);
+        return NULL;
+    }
+    return seg;
+}
+
+// waits out the segment's appenders, then unmaps it and trims the file down to its data - the
+// descriptor goes to the released list (the caller holds the lock and has unpublished seg)
+static void acaLogMmapSegmentReleaseLocked(aca_log_mmap_segment *seg) {
+    acaLogAtomicExchange(&seg->retired, 1);
+    while (acaLogAtomicLoad(&seg->writers) != 0) {
+        acaLogThreadYield();
+    }
+    size_t used = acaLogAtomicLoad(&seg->used);
+    size_t end  = acaLogAtomicLoad(&seg->end);
+    munmap(seg->map, seg->size);
+    if (ftruncate(seg->fd, (off_t)((used < end) ? used : end)) != 0) {
+        // leave the zeroed tail in place - readers stop at the first NUL anyway
+    }
+    close(seg->fd);
+    seg->next            = gAcaLogMmap.released;
+    gAcaLogMmap.released = seg;
+}
+
+// removes the unused spare segment file
+static void acaLogMmapSpareDiscardLocked(void) {
+    aca_log_mmap_segment *seg = gAcaLogMmap.spare;
+    if (seg != NULL) {
+        char path[sizeof(gAcaLogMmap.path) + 16];
+        snprintf(path, sizeof(path), "%s.%06u", gAcaLogMmap.path, seg->index);
+        munmap(seg->map, seg->size);
+        close(seg->fd);
+        unlink(path);
+        free(seg);
+        gAcaLogMmap.spare = NULL;
+    }
+}
+
+// frees the released descriptors if no appender but the caller's own ownPins is pinned - every
+// appender that could still hold one of them pinned before it was unpublished
+static void acaLogMmapReapLocked(size_t ownPins) {
+    if (acaLogAtomicAdd(&gAcaLogMmap.pins, 0) != ownPins) {
+        return; // someone may still hold one - retried on the next roll or close
+    }
+    while (gAcaLogMmap.released != NULL) {
+        aca_log_mmap_segment *seg = gAcaLogMmap.released;
+        gAcaLogMmap.released      = seg->next;
+        free(seg);
+    }
+}
+#endif // _WIN32
+
+// opens the first unused segment of config->path - returns 0 on success (-1 on Windows)
+int acaLogMmapOpen(const aca_log_mmap_config *config) {
+#if defined(_WIN32)
+    (void)config;
+    return -1;
+#else
+    aca_log_mmap_config defaults = ACA_LOG_MMAP_CONFIG_INIT;
+    static bool         registeredAtExit = false;
+
+    acaLogMmapClose();
+    acaLogMutexLock(&gAcaLogMmap.lock);
+    gAcaLogMmap.config = config ? *config : defaults;
+    if (gAcaLogMmap.config.path == NULL) {
+        gAcaLogMmap.config.path = defaults.path;
+    }
+    if (gAcaLogMmap.config.segmentSize < ACA_LOG_LINE_BUFFER_SIZE) {
+        gAcaLogMmap.config.segmentSize = ACA_LOG_LINE_BUFFER_SIZE;
+    }
+    snprintf(gAcaLogMmap.path, sizeof(gAcaLogMmap.path), "%s", gAcaLogMmap.config.path);
+
+    // continue after segments left behind by earlier runs
+    char path[sizeof(gAcaLogMmap.path) + 16];
+    for (gAcaLogMmap.index = 0;; ++gAcaLogMmap.index) {
+        snprintf(path, sizeof(path), "%s.%06u", gAcaLogMmap.path, gAcaLogMmap.index);
+        if (access(path, F_OK) != 0) {
+            break;
+        }
+    }
+
+    aca_log_mmap_segment *seg = acaLogMmapSegmentCreate();
+    acaLogAtomicStorePtr((void *volatile *)&gAcaLogMmap.current, seg);
+    if (seg != NULL) {
+        gAcaLogMmap.spare = acaLogMmapSegmentCreate(); // a failed spare is created on the roll
+    }
+    if ((seg != NULL) && !registeredAtExit) {
+        atexit(acaLogMmapClose);
+        registeredAtExit = true;
+    }
+    acaLogMutexUnlock(&gAcaLogMmap.lock);
+    return (seg != NULL) ? 0 : -1;
+#endif // _WIN32
+}
+
+// asks the kernel to write the current segment back to disk (and waits for it)
+void acaLogMmapSync(void) {
+#if !defined(_WIN32)
+    acaLogMutexLock(&gAcaLogMmap.lock);
+    aca_log_mmap_segment *seg =
+        (aca_log_mmap_segment *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogMmap.current);
+    if (seg != NULL) {
+        msync(seg->map, seg->size, MS_SYNC);
+    }
+    acaLogMutexUnlock(&gAcaLogMmap.lock);
+#endif // _WIN32
+}
+
+// releases the current segment, trimming the file to the data written, and removes the spare
+void acaLogMmapClose(void) {
+#if !defined(_WIN32)
+    acaLogMutexLock(&gAcaLogMmap.lock);
+    aca_log_mmap_segment *seg =
+        (aca_log_mmap_segment *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogMmap.current);
+    acaLogAtomicStorePtr((void *volatile *)&gAcaLogMmap.current, NULL);
+    if (seg != NULL) {
+        acaLogMmapSegmentReleaseLocked(seg);
+    }
+    acaLogMmapSpareDiscardLocked();
+    acaLogMmapReapLocked(0);
+    acaLogMutexUnlock(&gAcaLogMmap.lock);
+#endif // _WIN32
+}
+
+#if !defined(_WIN32)
+// copies one line into the current segment, rolling a new one in when it is full - returns false
+// if there is no segment to write to
+static bool acaLogMmapAppend(const char *line, size_t len) {
+    bool written = false;
+    acaLogAtomicAdd(&gAcaLogMmap.pins, 1); // before loading current - keeps seg from being freed
+    while (1) {
+        aca_log_mmap_segment *seg =
+            (aca_log_mmap_segment *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogMmap.current);
+        if (seg == NULL) {
+            break;
+        }
+        acaLogAtomicAdd(&seg->writers, 1);
+        if (acaLogAtomicAdd(&seg->retired, 0) != 0) { // lost a race with a roll - try the new one
+            acaLogAtomicAdd(&seg->writers, (size_t)-1);
+            continue;
+        }
+        if (len > seg->size) {
+            len = seg->size; // can't ever fit - keep what a whole segment holds
+        }
+        size_t offset = acaLogAtomicAdd(&seg->used, len);
+        if (offset + len <= seg->size) {
+            memcpy(&seg->map[offset], line, len);
+            acaLogAtomicAdd(&seg->writers, (size_t)-1);
+            written = true;
+            break;
+        }
+
+        // segment is full - remember where its data ends and roll the spare in (first one wins).
+        // the preallocation for the next spare happens after appenders moved on to the new one
+        size_t end = acaLogAtomicLoad(&seg->end);
+        while ((offset < end) && !acaLogAtomicCas(&seg->end, end, offset)) {
+            end = acaLogAtomicLoad(&seg->end);
+        }
+        acaLogAtomicAdd(&seg->writers, (size_t)-1);
+        acaLogMutexLock(&gAcaLogMmap.lock);
+        if (acaLogAtomicLoadPtr((void *volatile *)&gAcaLogMmap.current) == seg) {
+            aca_log_mmap_segment *next = gAcaLogMmap.spare;
+            gAcaLogMmap.spare          = NULL;
+            if (next == NULL) {
+                next = acaLogMmapSegmentCreate();
+            }
+            acaLogAtomicStorePtr((void *volatile *)&gAcaLogMmap.current, next);
+            acaLogMmapSegmentReleaseLocked(seg);
+            if (next != NULL) {
+                gAcaLogMmap.spare = acaLogMmapSegmentCreate();
+            }
+            acaLogMmapReapLocked(1);
+        }
+        acaLogMutexUnlock(&gAcaLogMmap.lock);
+    }
+    acaLogAtomicAdd(&gAcaLogMmap.pins, (size_t)-1);
+    return written;
+}
+#endif // _WIN32
+
+// standard log lines appended to memory-mapped segment files (opens with defaults if needed) -
+// falls back to the standard file handler where mmap isn't available
+ACA_LOG_HANDLER(acaLogMmapHandler) {
+#if defined(_WIN32)
+    acaLogStandardFileHandler(level, file, line, fmt, args);
+#else
+    if (acaLogAtomicLoadPtr((void *volatile *)&gAcaLogMmap.current) == NULL) {
+        // only opened lazily the first time - once closed (or a roll failed) records are dropped
+        acaLogMutexLock(&gAcaLogMmap.lock);
+        bool neverOpened = (gAcaLogMmap.path[0] == 0);
+        acaLogMutexUnlock(&gAcaLogMmap.lock);
+        if (neverOpened && (acaLogMmapOpen(NULL) != 0)) {
+            assert(false && "failed to open log segment!");
+            return;
+        }
+    }
+
+    size_t prefixLen = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                                  sizeof(tl_acaLogLineBuffer),
+                                                  false,
+                                                  level,
+                                                  file,
+                                                  line,
+                                                  GetTimestamp());
+    size_t len       = 0;
+    char  *record    = acaLogFormatLine(prefixLen, fmt, args, &len);
+    acaLogMmapAppend(record, len);
+    if (record != tl_acaLogLineBuffer) {
+        free(record);
+    }
+
+    if (level == ACA_LOG_FATAL) {
+        acaLogMmapSync();
+    }
+#endif // _WIN32
+}
+
+// compressed file handler internals - records are appended to an in-memory block that gets
+// compressed and written out as one frame once it is full (or on flush). frames never reference
+// each other, so a reader can start at any of them:
+//   frame:   magic "\xacLZ1", u32 rawLen, u32 payloadLen (high bit set = payload stored as is),
+//            u32 checksum of the raw bytes, payload (native byte order)
+//   payload: LZ sequences - token (high nibble literal count, low nibble match length - 4), extra
+//            literal count bytes (255 = more follow), literals, u16 LE match offset, extra match
+//            length bytes. the last sequence ends after its literals
+#define ACA_LOG_LZ_MAGIC "\xacLZ1"
+#define ACA_LOG_LZ_HEADER_SIZE 16
+#define ACA_LOG_LZ_STORED 0x80000000u
+#define ACA_LOG_LZ_BLOCK_MAX (16u * 1024 * 1024)
+#define ACA_LOG_LZ_HASH_BITS 12
+#define ACA_LOG_LZ_MIN_MATCH 4
+#define ACA_LOG_LZ_MAX_OFFSET 65535
+
+static inline uint32_t acaLogLzRead32(const unsigned char *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t acaLogLzHash(uint32_t value) {
+    return (value * 2654435761u) >> (32 - ACA_LOG_LZ_HASH_BITS);
+}
+
+// 64-bit FNV-1a over 8 byte words (bytes for the tail), folded to 32 bits
+static uint32_t acaLogLzChecksum(const unsigned char *data, size_t len) {
+    uint64_t hash = 14695981039346656037ull;
+    size_t   i    = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, &data[i], sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < len; ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+static inline unsigned char *acaLogLzPutLength(unsigned char *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+// writes one sequence (literals, then the match unless last is set) - returns NULL if it doesn't
+// fit before oend
+static unsigned char *acaLogLzPutSequence(unsigned char       *op,
+                                          unsigned char       *oend,
+                                          const unsigned char *literals,
+                                          size_t               litLen,
+                                          size_t               offset,
+                                          size_t               matchLen,
+                                          bool                 last) {
+    if ((size_t)(oend - op) < litLen + (litLen / 255) + (matchLen / 255) + 5) {
+        return NULL;
+    }
+    unsigned char *token = op++;
+    *token               = (unsigned char)(((litLen >= 15) ? 15 : litLen) << 4);
+    if (litLen >= 15) {
+        op = acaLogLzPutLength(op, litLen - 15);
+    }
+    memcpy(op, literals, litLen);
+    op += litLen;
+    if (last) {
+        return op;
+    }
+    *op++ = (unsigned char)(offset & 0xff);
+    *op++ = (unsigned char)(offset >> 8);
+    *token |= (unsigned char)((matchLen >= 15) ? 15 : matchLen);
+    if (matchLen >= 15) {
+        op = acaLogLzPutLength(op, matchLen - 15);
+    }
+    return op;
+}
+
+// greedy LZ77 with a single-probe hash table over a 64 KiB window - returns the compressed size,
+// or 0 if it doesn't fit in dstCap bytes
+size_t acaLogLzCompress(const void *src, size_t srcLen, void *dst, size_t dstCap) {
+    const unsigned char *in     = (const unsigned char *)src;
+    const unsigned char *iend   = in + srcLen;
+    const unsigned char *ilimit = (srcLen > 12) ? iend - 12 : in; // keeps 4 byte reads in bounds
+    const unsigned char *ip     = in;
+    const unsigned char *anchor = in;
+    unsigned char       *op     = (unsigned char *)dst;
+    unsigned char       *oend   = op + dstCap;
+    uint32_t             table[1 << ACA_LOG_LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    while (ip < ilimit) {
+        uint32_t             seq = acaLogLzRead32(ip);
+        uint32_t             h   = acaLogLzHash(seq);
+        const unsigned char *ref = in + table[h];
+        table[h]                 = (uint32_t)(ip - in);
+        if ((ref >= ip) || (ip - ref > ACA_LOG_LZ_MAX_OFFSET) || (acaLogLzRead32(ref) != seq)) {
+            ip += 1 + ((size_t)(ip - anchor) >> 6); // speeds up through incompressible data
+            continue;
+        }
+        while ((ip > anchor) && (ref > in) && (ip[-1] == ref[-1])) {
+            --ip;
+            --ref;
+        }
+        const unsigned char *mp = ip + ACA_LOG_LZ_MIN_MATCH;
+        const unsigned char *rp = ref + ACA_LOG_LZ_MIN_MATCH;
+        while (mp + 4 <= iend) { // 4 bytes at a time, then the differing word byte by byte
+            if (acaLogLzRead32(mp) != acaLogLzRead32(rp)) {
+                break;
+            }
+            mp += 4;
+            rp += 4;
+        }
+        while ((mp < iend) && (*mp == *rp)) {
+            ++mp;
+            ++rp;
+        }
+        op = acaLogLzPutSequence(op,
+                                 oend,
+                                 anchor,
+                                 (size_t)(ip - anchor),
+                                 (size_t)(ip - ref),
+                                 (size_t)(mp - ip) - ACA_LOG_LZ_MIN_MATCH,
+                                 false);
+        if (op == NULL) {
+            return 0;
+        }
+        ip = anchor = mp;
+        if (ip < ilimit) {
+            table[acaLogLzHash(acaLogLzRead32(ip - 2))] = (uint32_t)(ip - 2 - in);
+        }
+    }
+    op = acaLogLzPutSequence(op, oend, anchor, (size_t)(iend - anchor), 0, 0, true);
+    return (op != NULL) ? (size_t)(op - (unsigned char *)dst) : 0;
+}
+
+static inline bool acaLogLzGetLength(const unsigned char **ip,
+                                     const unsigned char  *iend,
+                                     size_t               *len) {
+    unsigned char byte;
+    do {
+        if (*ip >= iend) {
+            return false;
+        }
+        byte = *(*ip)++;
+        *len += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// decodes a compressed payload - returns 0 if it decoded to exactly dstLen bytes, -1 if it is
+// malformed (never reads or writes out of bounds)
+int acaLogLzDecompress(const void *src, size_t srcLen, void *dst, size_t dstLen) {
+    const unsigned char *ip     = (const unsigned char *)src;
+    const unsigned char *iend   = ip + srcLen;
+    unsigned char       *ostart = (unsigned char *)dst;
+    unsigned char       *op     = ostart;
+    unsigned char       *oend   = ostart + dstLen;
+    while (ip < iend) {
+        unsigned int token  = *ip++;
+        size_t       litLen = token >> 4;
+        if ((litLen == 15) && !acaLogLzGetLength(&ip, iend, &litLen)) {
+            return -1;
+        }
+        if ((litLen > (size_t)(iend - ip)) || (litLen > (size_t)(oend - op))) {
+            return -1;
+        }
+        memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        size_t offset   = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        size_t matchLen = token & 15;
+        ip += 2;
+        if ((matchLen == 15) && !acaLogLzGetLength(&ip, iend, &matchLen)) {
+            return -1;
+        }
+        matchLen += ACA_LOG_LZ_MIN_MATCH;
+        if ((offset == 0) || (offset > (size_t)(op - ostart)) ||
+            (matchLen > (size_t)(oend - op))) {
+            return -1;
+        }
+        // an overlapping match repeats the last offset bytes - copied in growing chunks that never
+        // overlap their source
+        const unsigned char *ref = op - offset;
+        while (matchLen > 0) {
+            size_t chunk = ((size_t)(op - ref) < matchLen) ? (size_t)(op - ref) : matchLen;
+            memcpy(op, ref, chunk);
+            op += chunk;
+            matchLen -= chunk;
+        }
+    }
+    return (op == oend) ? 0 : -1;
+}
+
+// one process-wide compressed file guarded by a mutex
+static struct {
+    aca_log_mutex     lock;
+    aca_log_lz_config config;
+    char              path[256];
+    FILE             *fp;
+    unsigned char    *block; // raw records not written yet
+    size_t            used;
+    unsigned char    *frame; // header + payload of the frame being written
+    double            lastFlush;
+    aca_log_thread    flusher;
+    volatile size_t   flusherRunning;
+} gAcaLogLz = {ACA_LOG_MUTEX_INIT};
+
+// compresses raw into one frame and writes it - frame must hold header + rawLen bytes
+static void acaLogLzWriteFrame(FILE                *fp,
+                               unsigned char       *frame,
+                               const unsigned char *raw,
+                               size_t               rawLen) {
+    unsigned char *payload    = frame + ACA_LOG_LZ_HEADER_SIZE;
+    size_t         payloadLen = 0;
+    if (rawLen > 1) {
+        payloadLen = acaLogLzCompress(raw, rawLen, payload, rawLen - 1);
+    }
+    uint32_t lenField = (uint32_t)payloadLen;
+    if (payloadLen == 0) {
+        memcpy(payload, raw, rawLen); // incompressible - stored
+        payloadLen = rawLen;
+        lenField   = (uint32_t)rawLen | ACA_LOG_LZ_STORED;
+    }
+    uint32_t rawField = (uint32_t)rawLen;
+    uint32_t checksum = acaLogLzChecksum(raw, rawLen);
+    memcpy(&frame[0], ACA_LOG_LZ_MAGIC, 4);
+    memcpy(&frame[4], &rawField, 4);
+    memcpy(&frame[8], &lenField, 4);
+    memcpy(&frame[12], &checksum, 4);
+    fwrite(frame, 1, ACA_LOG_LZ_HEADER_SIZE + payloadLen, fp);
+}
+
+static void acaLogLzFlushLocked(void) {
+    if ((gAcaLogLz.fp != NULL) && (gAcaLogLz.used > 0)) {
+        acaLogLzWriteFrame(gAcaLogLz.fp, gAcaLogLz.frame, gAcaLogLz.block, gAcaLogLz.used);
+        gAcaLogLz.used = 0;
+        fflush(gAcaLogLz.fp);
+    }
+    gAcaLogLz.lastFlush = GetTimestamp();
+}
+
+// writes a block out once it has waited flushInterval, even if no further record arrives to
+// notice - wakes up a few times per interval (at most every 50 ms)
+ACA_LOG_THREAD_ROUTINE(acaLogLzFlusher) {
+    (void)arg;
+    while (acaLogAtomicLoad(&gAcaLogLz.flusherRunning)) {
+        acaLogMutexLock(&gAcaLogLz.lock);
+        double interval = gAcaLogLz.config.flushInterval;
+        if ((gAcaLogLz.used > 0) && (GetTimestamp() - gAcaLogLz.lastFlush >= interval)) {
+            acaLogLzFlushLocked();
+        }
+        acaLogMutexUnlock(&gAcaLogLz.lock);
+        double step = (interval / 4.0 < 0.05) ? interval / 4.0 : 0.05;
+        acaLogSleepUs((step > 0.001) ? (unsigned int)(step * 1000000.0) : 1000);
+    }
+    ACA_LOG_THREAD_RETURN;
+}
+
+// opens (or re-opens) the compressed log file for appending - returns 0 on success
+int acaLogLzOpen(const aca_log_lz_config *config) {
+    aca_log_lz_config defaults         = ACA_LOG_LZ_CONFIG_INIT;
+    static bool       registeredAtExit = false;
+
+    acaLogLzClose();
+    acaLogMutexLock(&gAcaLogLz.lock);
+    gAcaLogLz.config = config ? *config : defaults;
+    if (gAcaLogLz.config.path == NULL) {
+        gAcaLogLz.config.path = defaults.path;
+    }
+    if (gAcaLogLz.config.blockSize == 0) {
+        gAcaLogLz.config.blockSize = defaults.blockSize;
+    } else if (gAcaLogLz.config.blockSize > ACA_LOG_LZ_BLOCK_MAX) {
+        gAcaLogLz.config.blockSize = ACA_LOG_LZ_BLOCK_MAX;
+    }
+    snprintf(gAcaLogLz.path, sizeof(gAcaLogLz.path), "%s", gAcaLogLz.config.path);
+
+    int ret         = -1;
+    gAcaLogLz.block = (unsigned char *)malloc(gAcaLogLz.config.blockSize);
+    gAcaLogLz.frame = (unsigned char *)malloc(ACA_LOG_LZ_HEADER_SIZE + gAcaLogLz.config.blockSize);
+    gAcaLogLz.fp    = NULL;
+    if ((gAcaLogLz.block != NULL) && (gAcaLogLz.frame != NULL)) {
+        gAcaLogLz.fp = fopen(gAcaLogLz.path, "ab");
+    }
+    if (gAcaLogLz.fp != NULL) {
+        gAcaLogLz.used      = 0;
+        gAcaLogLz.lastFlush = GetTimestamp();
+        ret                 = 0;
+        if ((gAcaLogLz.config.flushInterval > 0.0) &&
+            (acaLogAtomicExchange(&gAcaLogLz.flusherRunning, 1) == 0) &&
+            (acaLogThreadCreate(&gAcaLogLz.flusher, acaLogLzFlusher) != 0)) {
+            acaLogAtomicStore(&gAcaLogLz.flusherRunning, 0); // records still check the interval
+        }
+    } else {
+        free(gAcaLogLz.block);
+        free(gAcaLogLz.frame);
+        gAcaLogLz.block = NULL;
+        gAcaLogLz.frame = NULL;
+    }
+    if ((ret == 0) && !registeredAtExit) {
+        atexit(acaLogLzClose);
+        registeredAtExit = true;
+    }
+    acaLogMutexUnlock(&gAcaLogLz.lock);
+    return ret;
+}
+
+// writes the pending block out as a frame
+void acaLogLzFlush(void) {
+    acaLogMutexLock(&gAcaLogLz.lock);
+    acaLogLzFlushLocked();
+    acaLogMutexUnlock(&gAcaLogLz.lock);
+}
+
+// flushes and closes the compressed log file
+void acaLogLzClose(void) {
+    if (acaLogAtomicExchange(&gAcaLogLz.flusherRunning, 0) != 0) {
+        acaLogThreadJoin(gAcaLogLz.flusher);
+    }
+    acaLogMutexLock(&gAcaLogLz.lock);
+    if (gAcaLogLz.fp != NULL) {
+        acaLogLzFlushLocked();
+        fclose(gAcaLogLz.fp);
+        gAcaLogLz.fp = NULL;
+    }
+    free(gAcaLogLz.block);
+    free(gAcaLogLz.frame);
+    gAcaLogLz.block = NULL;
+    gAcaLogLz.frame = NULL;
+    acaLogMutexUnlock(&gAcaLogLz.lock);
+}
+
+// standard log lines (no colors) gathered into blocks and written as compressed frames - a block
+// goes out when it is full, after flushInterval or for level >= flushLevel (opens with defaults
+// if needed). a line longer than the block size becomes a frame of its own (cut to the block max)
+ACA_LOG_HANDLER(acaLogLzHandler) {
+    acaLogMutexLock(&gAcaLogLz.lock);
+    bool opened = (gAcaLogLz.fp != NULL);
+    acaLogMutexUnlock(&gAcaLogLz.lock);
+    if (!opened && (acaLogLzOpen(NULL) != 0)) {
+        assert(false && "failed to open compressed log file!");
+        return;
+    }
+
+    double now       = GetTimestamp();
+    size_t prefixLen = acaLogStandardPrefixFormat(
+        tl_acaLogLineBuffer, sizeof(tl_acaLogLineBuffer), false, level, file, line, now);
+    size_t len    = 0;
+    char  *record = acaLogFormatLine(prefixLen, fmt, args, &len);
+
+    acaLogMutexLock(&gAcaLogLz.lock);
+    if (gAcaLogLz.fp != NULL) {
+        if (gAcaLogLz.used + len > gAcaLogLz.config.blockSize) {
+            acaLogLzFlushLocked();
+        }
+        if (len <= gAcaLogLz.config.blockSize) {
+            memcpy(&gAcaLogLz.block[gAcaLogLz.used], record, len);
+            gAcaLogLz.used += len;
+        } else {
+            if (len > ACA_LOG_LZ_BLOCK_MAX) { // readers reject larger frames
+                len             = ACA_LOG_LZ_BLOCK_MAX;
+                record[len - 1] = '\n';
+            }
+            unsigned char *frame = (unsigned char *)malloc(ACA_LOG_LZ_HEADER_SIZE + len);
+            if (frame != NULL) {
+                acaLogLzWriteFrame(gAcaLogLz.fp, frame, (const unsigned char *)record, len);
+                free(frame);
+            }
+        }
+        if ((level >= gAcaLogLz.config.flushLevel) ||
+            ((gAcaLogLz.config.flushInterval > 0.0) &&
+             (now - gAcaLogLz.lastFlush >= gAcaLogLz.config.flushInterval))) {
+            acaLogLzFlushLocked();
+        }
+    }
+    acaLogMutexUnlock(&gAcaLogLz.lock);
+    if (record != tl_acaLogLineBuffer) {
+        free(record);
+    }
+}
+
+// frame reader buffers, grown on demand
+typedef struct aca_log_lz_reader {
+    unsigned char *raw;
+    size_t         rawCap;
+    unsigned char *payload;
+    size_t         payloadCap;
+} aca_log_lz_reader;
+
+static bool acaLogLzReserve(unsigned char **buf, size_t *cap, size_t size) {
+    if (size <= *cap) {
+        return true;
+    }
+    unsigned char *grown = (unsigned char *)realloc(*buf, size);
+    if (grown == NULL) {
+        return false;
+    }
+    *buf = grown;
+    *cap = size;
+    return true;
+}
+
+// reads and verifies the frame at the current position - returns its raw size (raw bytes in
+// reader->raw), 0 at the end of the file or -1 if the bytes there aren't an intact frame. no
+// writer produces frames larger than ACA_LOG_LZ_BLOCK_MAX, so a damaged size can't make the
+// reader allocate more than that
+static long acaLogLzReadFrame(FILE *in, aca_log_lz_reader *reader) {
+    unsigned char header[ACA_LOG_LZ_HEADER_SIZE];
+    size_t        got = fread(header, 1, sizeof(header), in);
+    if (got == 0) {
+        return 0;
+    }
+    uint32_t rawLen, lenField, checksum;
+    memcpy(&rawLen, &header[4], 4);
+    memcpy(&lenField, &header[8], 4);
+    memcpy(&checksum, &header[12], 4);
+    bool   stored     = (lenField & ACA_LOG_LZ_STORED) != 0;
+    size_t payloadLen = lenField & ~ACA_LOG_LZ_STORED;
+    if ((got != sizeof(header)) || (memcmp(header, ACA_LOG_LZ_MAGIC, 4) != 0) ||
+        (rawLen == 0) || (rawLen > ACA_LOG_LZ_BLOCK_MAX) || (payloadLen > rawLen) ||
+        (stored && (payloadLen != rawLen)) ||
+        !acaLogLzReserve(&reader->raw, &reader->rawCap, rawLen) ||
+        !acaLogLzReserve(&reader->payload, &reader->payloadCap, payloadLen)) {
+        return -1;
+    }
+    unsigned char *payload = stored ? reader->raw : reader->payload;
+    if (fread(payload, 1, payloadLen, in) != payloadLen) {
+        return -1;
+    }
+    if (!stored && (acaLogLzDecompress(payload, payloadLen, reader->raw, rawLen) != 0)) {
+        return -1;
+    }
+    return (acaLogLzChecksum(reader->raw, rawLen) == checksum) ? (long)rawLen : -1;
+}
+
+// moves in to the next intact frame at or after its current position - returns the frame offset,
+// or -1 if there is none (e.g. to tail a file: fseek near its end, then sync)
+long long acaLogLzSync(FILE *in) {
+    aca_log_lz_reader reader  = {NULL, 0, NULL, 0};
+    const char       *magic   = ACA_LOG_LZ_MAGIC;
+    uint64_t          pos     = acaLogIndexTell(in);
+    long long         found   = -1;
+    int               matched = 0;
+    int               c;
+    while ((c = fgetc(in)) != EOF) {
+        ++pos;
+        if (c == (unsigned char)magic[matched]) {
+            ++matched;
+        } else {
+            matched = (c == (unsigned char)magic[0]) ? 1 : 0;
+        }
+        if (matched == 4) {
+            uint64_t start = pos - 4;
+            acaLogIndexSeek(in, start, SEEK_SET);
+            if (acaLogLzReadFrame(in, &reader) > 0) {
+                found = (long long)start;
+                break;
+            }
+            pos     = start + 1;
+            matched = 0;
+            acaLogIndexSeek(in, pos, SEEK_SET);
+        }
+    }
+    if (found >= 0) {
+        acaLogIndexSeek(in, (uint64_t)found, SEEK_SET);
+    }
+    free(reader.raw);
+    free(reader.payload);
+    return found;
+}
+
+// writes the text of every frame from the current position on - damaged or partial frames are
+// skipped up to the next intact one. returns 0, or -1 if anything had to be skipped
+int acaLogLzDecode(FILE *in, FILE *out) {
+    aca_log_lz_reader reader = {NULL, 0, NULL, 0};
+    int               ret    = 0;
+    while (1) {
+        long pos = ftell(in);
+        long len = acaLogLzReadFrame(in, &reader);
+        if (len == 0) {
+            break;
+        }
+        if (len < 0) {
+            ret = -1;
+            fseek(in, pos + 1, SEEK_SET);
+            if (acaLogLzSync(in) < 0) {
+                break;
+            }
+            continue;
+        }
+        fwrite(reader.raw, 1, (size_t)len, out);
+    }
+    free(reader.raw);
+    free(reader.payload);
+    return ret;
+}
+
+// datagram handler internals - lines are packed into a batch of datagrams (a line never spans two)
+// that goes out with as few syscalls as possible once the batch is full, after flushInterval or for
+// level >= flushLevel. sends never block - datagrams the socket has no room for are dropped and
+// counted. one process-wide socket guarded by a mutex
+#define ACA_LOG_NET_BATCH_MAX 64
+#define ACA_LOG_NET_DATAGRAM_MAX 65507 // largest UDP payload
+
+static struct {
+    aca_log_mutex      lock;
+    aca_log_net_config config;
+    char               address[256];
+    int                fd;
+    bool               opened;
+    char              *buffer; // batch datagrams of datagramSize bytes each
+    size_t             lens[ACA_LOG_NET_BATCH_MAX];
+    size_t             records[ACA_LOG_NET_BATCH_MAX];
+    size_t             count; // datagrams in use, the last one is still being filled
+    double             lastFlush;
+    size_t             reportedDrops;
+    volatile size_t    dropped;
+    aca_log_thread     flusher;
+    volatile size_t    flusherRunning;
+} gAcaLogNet = {ACA_LOG_MUTEX_INIT};
+
+#if !defined(_WIN32)
+// "unix:/path" or "udp:host:port" - returns a datagram socket connected (or bound) to it, -1 on
+// failure
+static int acaLogNetSocket(const char *address, bool bindIt) {
+    int fd = -1;
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(address + 5) >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        strcpy(addr.sun_path, address + 5);
+        fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (bindIt) {
+            unlink(addr.sun_path); // left over from an earlier receiver
+        }
+        int ret = bindIt ? bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+                         : connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+        if (ret != 0) {
+            close(fd);
+            return -1;
+        }
+    } else if (strncmp(address, "udp:", 4) == 0) {
+        const char *host  = address + 4;
+        const char *colon = strrchr(host, ':');
+        char        name[128];
+        if ((colon == NULL) || ((size_t)(colon - host) >= sizeof(name))) {
+            return -1;
+        }
+        if ((host[0] == '[') && (colon > host + 1) && (colon[-1] == ']')) { // [::1]:port
+            ++host;
+            snprintf(name, sizeof(name), "%.*s", (int)(colon - host - 1), host);
+        } else {
+            snprintf(name, sizeof(name), "%.*s", (int)(colon - host), host);
+        }
+        struct addrinfo  hints;
+        struct addrinfo *res = NULL;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        hints.ai_flags    = AI_NUMERICSERV | (bindIt ? AI_PASSIVE : 0);
+        if (getaddrinfo(name, colon + 1, &hints, &res) != 0) {
+            return -1;
+        }
+        fd = socket(res->ai_family, SOCK_DGRAM, 0);
+        if (fd >= 0) {
+            int ret = bindIt ? bind(fd, res->ai_addr, res->ai_addrlen)
+                             : connect(fd, res->ai_addr, res->ai_addrlen);
+            if (ret != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(res);
+    }
+    return fd;
+}
+
+// sends every datagram of the batch - several per sendmmsg where available, whatever the socket
+// can't take right now is dropped
+static void acaLogNetFlushLocked(void) {
+    size_t sent = 0;
+    size_t size = gAcaLogNet.config.datagramSize;
+#if defined(__linux__) && defined(_GNU_SOURCE)
+    struct mmsghdr msgs[ACA_LOG_NET_BATCH_MAX];
+    struct iovec   iovs[ACA_LOG_NET_BATCH_MAX];
+    memset(msgs, 0, sizeof(msgs[0]) * gAcaLogNet.count);
+    for (size_t i = 0; i < gAcaLogNet.count; ++i) {
+        iovs[i].iov_base           = &gAcaLogNet.buffer[i * size];
+        iovs[i].iov_len            = gAcaLogNet.lens[i];
+        msgs[i].msg_hdr.msg_iov    = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (sent < gAcaLogNet.count) {
+        int n = sendmmsg(
+            gAcaLogNet.fd, &msgs[sent], (unsigned int)(gAcaLogNet.count - sent), MSG_DONTWAIT);
+        if ((n < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        sent += (size_t)n;
+    }
+#else
+    while (sent < gAcaLogNet.count) {
+        const char *datagram = &gAcaLogNet.buffer[sent * size];
+        if (send(gAcaLogNet.fd, datagram, gAcaLogNet.lens[sent], MSG_DONTWAIT) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        ++sent;
+    }
+#endif // __linux__ && _GNU_SOURCE
+    for (size_t i = sent; i < gAcaLogNet.count; ++i) {
+        acaLogAtomicAdd(&gAcaLogNet.dropped, gAcaLogNet.records[i]);
+    }
+    gAcaLogNet.count     = 0;
+    gAcaLogNet.lastFlush = GetTimestamp();
+}
+
+// packs one line into the batch (cut to datagramSize if longer), sending the batch first if full
+static void acaLogNetAppendLocked(const char *line, size_t len) {
+    size_t size = gAcaLogNet.config.datagramSize;
+    if (len > size) {
+        len = size;
+    }
+    if ((gAcaLogNet.count == 0) || (gAcaLogNet.lens[gAcaLogNet.count - 1] + len > size)) {
+        if (gAcaLogNet.count == gAcaLogNet.config.batch) {
+            acaLogNetFlushLocked();
+        }
+        gAcaLogNet.lens[gAcaLogNet.count]    = 0;
+        gAcaLogNet.records[gAcaLogNet.count] = 0;
+        ++gAcaLogNet.count;
+    }
+    size_t index = gAcaLogNet.count - 1;
+    char  *out   = &gAcaLogNet.buffer[(index * size) + gAcaLogNet.lens[index]];
+    memcpy(out, line, len);
+    out[len - 1] = '\n';
+    gAcaLogNet.lens[index] += len;
+    ++gAcaLogNet.records[index];
+}
+
+// sends a partial batch once it has waited flushInterval, even if no further record arrives to
+// notice - wakes up a few times per interval (at most every 50 ms)
+ACA_LOG_THREAD_ROUTINE(acaLogNetFlusher) {
+    (void)arg;
+    while (acaLogAtomicLoad(&gAcaLogNet.flusherRunning)) {
+        acaLogMutexLock(&gAcaLogNet.lock);
+        double interval = gAcaLogNet.config.flushInterval;
+        if (gAcaLogNet.opened && (gAcaLogNet.count > 0) &&
+            (GetTimestamp() - gAcaLogNet.lastFlush >= interval)) {
+            acaLogNetFlushLocked();
+        }
+        acaLogMutexUnlock(&gAcaLogNet.lock);
+        double step = (interval / 4.0 < 0.05) ? interval / 4.0 : 0.05;
+        acaLogSleepUs((step > 0.001) ? (unsigned int)(step * 1000000.0) : 1000);
+    }
+    ACA_LOG_THREAD_RETURN;
+}
+#endif // _WIN32
+
+// connects the datagram socket - returns 0 on success (POSIX only)
+int acaLogNetOpen(const aca_log_net_config *config) {
+#if defined(_WIN32)
+    (void)config;
+    return -1;
+#else
+    aca_log_net_config defaults         = ACA_LOG_NET_CONFIG_INIT;
+    static bool        registeredAtExit = false;
+
+    acaLogNetClose();
+    acaLogMutexLock(&gAcaLogNet.lock);
+    gAcaLogNet.config = config ? *config : defaults;
+    if (gAcaLogNet.config.address == NULL) {
+        gAcaLogNet.config.address = defaults.address;
+    }
+    if (gAcaLogNet.config.datagramSize == 0) {
+        gAcaLogNet.config.datagramSize = defaults.datagramSize;
+    } else if (gAcaLogNet.config.datagramSize > ACA_LOG_NET_DATAGRAM_MAX) {
+        gAcaLogNet.config.datagramSize = ACA_LOG_NET_DATAGRAM_MAX;
+    }
+    if (gAcaLogNet.config.batch == 0) {
+        gAcaLogNet.config.batch = defaults.batch;
+    } else if (gAcaLogNet.config.batch > ACA_LOG_NET_BATCH_MAX) {
+        gAcaLogNet.config.batch = ACA_LOG_NET_BATCH_MAX;
+    }
+    snprintf(gAcaLogNet.address, sizeof(gAcaLogNet.address), "%s", gAcaLogNet.config.address);
+
+    int ret           = -1;
+    gAcaLogNet.buffer = (char *)malloc(gAcaLogNet.config.batch * gAcaLogNet.config.datagramSize);
+    gAcaLogNet.fd     = -1;
+    if (gAcaLogNet.buffer != NULL) {
+        gAcaLogNet.fd = acaLogNetSocket(gAcaLogNet.address, false);
+    }
+    if (gAcaLogNet.fd >= 0) {
+        gAcaLogNet.opened    = true;
+        gAcaLogNet.count     = 0;
+        gAcaLogNet.lastFlush = GetTimestamp();
+        ret                  = 0;
+        if ((gAcaLogNet.config.flushInterval > 0.0) &&
+            (acaLogAtomicExchange(&gAcaLogNet.flusherRunning, 1) == 0) &&
+            (acaLogThreadCreate(&gAcaLogNet.flusher, acaLogNetFlusher) != 0)) {
+            acaLogAtomicStore(&gAcaLogNet.flusherRunning, 0); // records still check the interval
+        }
+    } else {
+        free(gAcaLogNet.buffer);
+        gAcaLogNet.buffer = NULL;
+    }
+    if ((ret == 0) && !registeredAtExit) {
+        atexit(acaLogNetClose);
+        registeredAtExit = true;
+    }
+    acaLogMutexUnlock(&gAcaLogNet.lock);
+    return ret;
+#endif // _WIN32
+}
+
+// sends the pending datagrams now
+void acaLogNetFlush(void) {
+#if !defined(_WIN32)
+    acaLogMutexLock(&gAcaLogNet.lock);
+    if (gAcaLogNet.opened) {
+        acaLogNetFlushLocked();
+    }
+    acaLogMutexUnlock(&gAcaLogNet.lock);
+#endif // _WIN32
+}
+
+// flushes and closes the socket
+void acaLogNetClose(void) {
+#if !defined(_WIN32)
+    if (acaLogAtomicExchange(&gAcaLogNet.flusherRunning, 0) != 0) {
+        acaLogThreadJoin(gAcaLogNet.flusher);
+    }
+    acaLogMutexLock(&gAcaLogNet.lock);
+    if (gAcaLogNet.opened) {
+        acaLogNetFlushLocked();
+        close(gAcaLogNet.fd);
+        gAcaLogNet.opened = false;
+    }
+    free(gAcaLogNet.buffer);
+    gAcaLogNet.buffer = NULL;
+    acaLogMutexUnlock(&gAcaLogNet.lock);
+#endif // _WIN32
+}
+
+size_t acaLogNetDropped(void) {
+    return acaLogAtomicLoad(&gAcaLogNet.dropped);
+}
+
+// receiver side - a datagram socket bound to the address (a stand-in collector), -1 on failure
+int acaLogNetBind(const char *address) {
+#if defined(_WIN32)
+    (void)address;
+    return -1;
+#else
+    return acaLogNetSocket(address, true);
+#endif // _WIN32
+}
+
+// standard log lines (no colors) batched into datagrams for a local collector (opens with defaults
+// if needed) - falls back to the standard file handler where there are no Unix sockets
+ACA_LOG_HANDLER(acaLogNetHandler) {
+#if defined(_WIN32)
+    acaLogStandardFileHandler(level, file, line, fmt, args);
+#else
+    acaLogMutexLock(&gAcaLogNet.lock);
+    bool opened = gAcaLogNet.opened;
+    acaLogMutexUnlock(&gAcaLogNet.lock);
+    if (!opened && (acaLogNetOpen(NULL) != 0)) {
+        assert(false && "failed to open log socket!");
+        return;
+    }
+
+    double now       = GetTimestamp();
+    size_t prefixLen = acaLogStandardPrefixFormat(
+        tl_acaLogLineBuffer, sizeof(tl_acaLogLineBuffer), false, level, file, line, now);
+    size_t len    = 0;
+    char  *record = acaLogFormatLine(prefixLen, fmt, args, &len);
+
+    acaLogMutexLock(&gAcaLogNet.lock);
+    if (gAcaLogNet.opened) {
+        size_t dropped = acaLogAtomicLoad(&gAcaLogNet.dropped);
+        if (dropped != gAcaLogNet.reportedDrops) {
+            char   notice[256];
+            size_t noticeLen = acaLogStandardPrefixFormat(
+                notice, sizeof(notice), false, ACA_LOG_WARN, __FILE__, __LINE__, now);
+            int n = acaLogFormatf(&notice[noticeLen],
+                                  sizeof(notice) - noticeLen,
+                                  "socket full - dropped %lu record(s)\n",
+                                  (unsigned long)(dropped - gAcaLogNet.reportedDrops));
+            noticeLen += (n > 0) ? (size_t)n : 0;
+            if (noticeLen >= sizeof(notice)) {
+                noticeLen = sizeof(notice) - 1;
+            }
+            acaLogNetAppendLocked(notice, noticeLen);
+            gAcaLogNet.reportedDrops = dropped;
+        }
+        acaLogNetAppendLocked(record, len);
+        if ((level >= gAcaLogNet.config.flushLevel) ||
+            ((gAcaLogNet.config.flushInterval > 0.0) &&
+             (now - gAcaLogNet.lastFlush >= gAcaLogNet.config.flushInterval))) {
+            acaLogNetFlushLocked();
+        }
+    }
+    acaLogMutexUnlock(&gAcaLogNet.lock);
+    if (record != tl_acaLogLineBuffer) {
+        free(record);
+    }
+#endif // _WIN32
+}
+
+// shared-memory ring internals - the async handler's sequence-numbered slot queue, laid out in a
+// shared mapping so the producers can live in other processes. slots carry copies of everything
+// (pointers mean nothing to the collector) and timestamps are CLOCK_MONOTONIC seconds since the
+// ring was created, so the records of all writers share one time base
+#define ACA_LOG_SHM_MAGIC "ACALSHM1"
+
+typedef struct aca_log_shm_slot {
+    volatile size_t seq;
+    volatile size_t owner; // pid of the writer filling the slot (0 = none yet)
+    double          timestamp;
+    unsigned int    pid;
+    int             line;
+    unsigned char   level;
+    unsigned short  msgLen;
+    char            file[ACA_LOG_SHM_FILE_SIZE]; // tail of the path
+    char            msg[ACA_LOG_SHM_MSG_SIZE];
+} aca_log_shm_slot;
+
+typedef struct aca_log_shm_ring {
+    char             magic[8];
+    volatile size_t  ready;    // set last by the creator
+    size_t           mask;
+    size_t           slotSize; // layout check for attaching writers
+    double           epoch;
+    volatile size_t  dropped;
+    char             pad0[64]; // keep producer/consumer counters on separate lines
+    volatile size_t  enqueuePos;
+    char             pad1[64];
+    volatile size_t  dequeuePos;
+    char             pad2[64];
+    aca_log_shm_slot slots[1]; // mask + 1 slots
+} aca_log_shm_ring;
+
+static struct {
+    aca_log_mutex              lock;
+    aca_log_shm_ring *volatile ring;
+    size_t                     mapSize;
+    volatile size_t            writers; // handler calls currently pinning the mapping
+    volatile size_t            pid;     // cached, reset in forked children
+    bool                       attachTried;
+    bool                       registered;
+    size_t                     reportedDrops; // collector side
+    bool                       stalled;
+    size_t                     stallPos;
+    double                     stallSince;
+} gAcaLogShm = {ACA_LOG_MUTEX_INIT};
+
+#if !defined(_WIN32)
+static double acaLogShmNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void acaLogShmForkChild(void) {
+    gAcaLogShm.pid = (size_t)getpid();
+}
+
+// maps a ring and makes it the process' current one (the caller holds the lock)
+static int acaLogShmInstallLocked(aca_log_shm_ring *ring, size_t mapSize) {
+    gAcaLogShm.mapSize       = mapSize;
+    gAcaLogShm.reportedDrops = acaLogAtomicLoad(&ring->dropped);
+    gAcaLogShm.stalled       = false;
+    gAcaLogShm.pid           = (size_t)getpid();
+    if (!gAcaLogShm.registered) {
+        pthread_atfork(NULL, NULL, acaLogShmForkChild);
+        atexit(acaLogShmDetach);
+        gAcaLogShm.registered = true;
+    }
+    acaLogAtomicStorePtr((void *volatile *)&gAcaLogShm.ring, ring);
+    return 0;
+}
+
+// pins the current ring for a handler call - NULL if there is none
+static aca_log_shm_ring *acaLogShmPin(void) {
+    acaLogAtomicAdd(&gAcaLogShm.writers, 1);
+    aca_log_shm_ring *ring =
+        (aca_log_shm_ring *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogShm.ring);
+    if (ring == NULL) {
+        acaLogAtomicAdd(&gAcaLogShm.writers, (size_t)-1);
+    }
+    return ring;
+}
+#endif // _WIN32
+
+// creates (replaces) the ring file and maps it - returns 0 on success (-1 on Windows). writers
+// that still have a replaced ring mapped keep writing into the orphaned copy until they re-attach
+int acaLogShmCreate(const aca_log_shm_config *config) {
+#if defined(_WIN32)
+    (void)config;
+    return -1;
+#else
+    aca_log_shm_config defaults = ACA_LOG_SHM_CONFIG_INIT;
+    const char        *path     = (config && config->path) ? config->path : defaults.path;
+    size_t             capacity = 2;
+    while (capacity < ((config && config->capacity) ? config->capacity : defaults.capacity)) {
+        capacity <<= 1;
+    }
+    size_t size = offsetof(aca_log_shm_ring, slots) + capacity * sizeof(aca_log_shm_slot);
+
+    acaLogShmDetach();
+    unlink(path);
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+#if defined(__linux__)
+    // reserve the pages up front so a writer's page fault can't fail on a full tmpfs
+    int err = posix_fallocate(fd, 0, (off_t)size);
+#else
+    int err = ftruncate(fd, (off_t)size);
+#endif // __linux__
+    void *map = MAP_FAILED;
+    if (err == 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        unlink(path);
+        return -1;
+    }
+
+    aca_log_shm_ring *ring = (aca_log_shm_ring *)map;
+    ring->mask             = capacity - 1;
+    ring->slotSize         = sizeof(aca_log_shm_slot);
+    ring->epoch            = acaLogShmNow();
+    for (size_t i = 0; i < capacity; ++i) {
+        ring->slots[i].seq = i;
+    }
+    memcpy(ring->magic, ACA_LOG_SHM_MAGIC, sizeof(ring->magic));
+    acaLogAtomicStore(&ring->ready, 1);
+
+    acaLogMutexLock(&gAcaLogShm.lock);
+    int ret = acaLogShmInstallLocked(ring, size);
+    acaLogMutexUnlock(&gAcaLogShm.lock);
+    return ret;
+#endif // _WIN32
+}
+
+// maps a ring created by the collector (NULL = default path) - returns 0 on success. not needed in
+// children forked after acaLogShmCreate/acaLogShmAttach, the mapping is inherited
+int acaLogShmAttach(const char *path) {
+#if defined(_WIN32)
+    (void)path;
+    return -1;
+#else
+    aca_log_shm_config defaults = ACA_LOG_SHM_CONFIG_INIT;
+    acaLogShmDetach();
+    int fd = open(path ? path : defaults.path, O_RDWR);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    void       *map  = MAP_FAILED;
+    size_t      size = 0;
+    if ((fstat(fd, &st) == 0) && ((size_t)st.st_size > offsetof(aca_log_shm_ring, slots))) {
+        size = (size_t)st.st_size;
+        map  = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    // only rings of the same slot layout (ACA_LOG_SHM_MSG_SIZE, ...) can be shared
+    aca_log_shm_ring *ring = (aca_log_shm_ring *)map;
+    if ((memcmp(ring->magic, ACA_LOG_SHM_MAGIC, sizeof(ring->magic)) != 0) ||
+        !acaLogAtomicLoad(&ring->ready) || (ring->slotSize != sizeof(aca_log_shm_slot)) ||
+        (offsetof(aca_log_shm_ring, slots) + (ring->mask + 1) * sizeof(aca_log_shm_slot) != size)) {
+        munmap(map, size);
+        return -1;
+    }
+    acaLogMutexLock(&gAcaLogShm.lock);
+    int ret = acaLogShmInstallLocked(ring, size);
+    acaLogMutexUnlock(&gAcaLogShm.lock);
+    return ret;
+#endif // _WIN32
+}
+
+// unmaps the ring once the handler calls using it are done (the file is left to the collector)
+void acaLogShmDetach(void) {
+#if !defined(_WIN32)
+    acaLogMutexLock(&gAcaLogShm.lock);
+    aca_log_shm_ring *ring =
+        (aca_log_shm_ring *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogShm.ring);
+    if ((ring != NULL) && acaLogAtomicCasPtr((void *volatile *)&gAcaLogShm.ring, ring, NULL)) {
+        while (acaLogAtomicLoad(&gAcaLogShm.writers) != 0) {
+            acaLogThreadYield();
+        }
+        munmap(ring, gAcaLogShm.mapSize);
+    }
+    acaLogMutexUnlock(&gAcaLogShm.lock);
+#endif // _WIN32
+}
+
+// writes every published record as a standard line tagged with the writer's pid - there must only
+// be one collector draining a ring
+size_t acaLogShmDrain(FILE *fp) {
+    size_t count = 0;
+#if defined(_WIN32)
+    (void)fp;
+#else
+    acaLogMutexLock(&gAcaLogShm.lock);
+    aca_log_shm_ring *ring =
+        (aca_log_shm_ring *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogShm.ring);
+    while (ring != NULL) {
+        size_t            pos  = ring->dequeuePos;
+        aca_log_shm_slot *slot = &ring->slots[pos & ring->mask];
+        size_t            seq  = acaLogAtomicLoad(&slot->seq);
+        if (seq != pos + 1) {
+            if ((seq != pos) || (acaLogAtomicLoad(&ring->enqueuePos) == pos)) {
+                break; // empty
+            }
+            // claimed but not published - once it took too long, skip it if the writer died. a
+            // writer that is only descheduled keeps its slot, skipping that one would let the next
+            // lap's writer share it with the late one
+            double now = acaLogShmNow();
+            if (!gAcaLogShm.stalled || (gAcaLogShm.stallPos != pos)) {
+                gAcaLogShm.stalled    = true;
+                gAcaLogShm.stallPos   = pos;
+                gAcaLogShm.stallSince = now;
+                break;
+            }
+            if (now - gAcaLogShm.stallSince < ACA_LOG_SHM_STALL_MS / 1000.0) {
+                break;
+            }
+            pid_t owner = (pid_t)acaLogAtomicLoad(&slot->owner);
+            if ((owner == 0) || (kill(owner, 0) == 0) || (errno != ESRCH)) {
+                gAcaLogShm.stallSince = now; // alive (or not known yet) - check again later
+                break;
+            }
+            if (acaLogAtomicCas(&slot->seq, pos, pos + ring->mask + 1)) {
+                acaLogAtomicStore(&slot->owner, 0);
+                acaLogAtomicAdd(&ring->dropped, 1);
+                acaLogAtomicStore(&ring->dequeuePos, pos + 1);
+            }
+            continue;
+        }
+
+        size_t prefixLen = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                                      sizeof(tl_acaLogLineBuffer),
+                                                      fp == stdout,
+                                                      (aca_log_level)slot->level,
+                                                      slot->file,
+                                                      slot->line,
+                                                      slot->timestamp);
+        acaLogWriteLinef(fp, prefixLen, "[%u] %.*s", slot->pid, (int)slot->msgLen, slot->msg);
+        acaLogAtomicStore(&slot->owner, 0);
+        acaLogAtomicStore(&slot->seq, pos + ring->mask + 1);
+        acaLogAtomicStore(&ring->dequeuePos, pos + 1);
+        ++count;
+    }
+
+    size_t dropped = (ring != NULL) ? acaLogAtomicLoad(&ring->dropped) : 0;
+    if ((ring != NULL) && (dropped != gAcaLogShm.reportedDrops)) {
+        size_t prefixLen = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                                      sizeof(tl_acaLogLineBuffer),
+                                                      fp == stdout,
+                                                      ACA_LOG_WARN,
+                                                      __FILE__,
+                                                      __LINE__,
+                                                      acaLogShmNow() - ring->epoch);
+        acaLogWriteLinef(fp,
+                         prefixLen,
+                         "shm ring full - dropped %lu record(s)",
+                         (unsigned long)(dropped - gAcaLogShm.reportedDrops));
+        gAcaLogShm.reportedDrops = dropped;
+        ++count;
+    }
+    acaLogMutexUnlock(&gAcaLogShm.lock);
+    if (count > 0) {
+        fflush(fp);
+    }
+#endif // _WIN32
+    return count;
+}
+
+// records dropped by all writers of the ring (full ring or skipped slots)
+size_t acaLogShmDropped(void) {
+    size_t dropped = 0;
+#if !defined(_WIN32)
+    aca_log_shm_ring *ring = acaLogShmPin();
+    if (ring != NULL) {
+        dropped = acaLogAtomicLoad(&ring->dropped);
+        acaLogAtomicAdd(&gAcaLogShm.writers, (size_t)-1);
+    }
+#endif // _WIN32
+    return dropped;
+}
+
+// copies level, file, line, timestamp, pid and the formatted message into a ring slot (attaches to
+// the default ring on first use) - without a ring records go to the standard handler
+ACA_LOG_HANDLER(acaLogShmHandler) {
+#if defined(_WIN32)
+    acaLogStandardFileHandler(level, file, line, fmt, args);
+#else
+    aca_log_shm_ring *ring = acaLogShmPin();
+    if (ring == NULL) {
+        acaLogMutexLock(&gAcaLogShm.lock);
+        bool tried             = gAcaLogShm.attachTried;
+        gAcaLogShm.attachTried = true;
+        acaLogMutexUnlock(&gAcaLogShm.lock);
+        if (tried || (acaLogShmAttach(NULL) != 0) || ((ring = acaLogShmPin()) == NULL)) {
+            acaLogStandardHandler(level, file, line, fmt, args);
+            return;
+        }
+    }
+
+    // claim a slot (same scheme as acaLogAsyncReserve)
+    aca_log_shm_slot *slot = NULL;
+    size_t            pos  = acaLogAtomicLoad(&ring->enqueuePos);
+    while (1) {
+        slot       = &ring->slots[pos & ring->mask];
+        size_t seq = acaLogAtomicLoad(&slot->seq);
+        if (seq == pos) {
+            if (acaLogAtomicCas(&ring->enqueuePos, pos, pos + 1)) {
+                break;
+            }
+        } else if (seq < pos) {
+            acaLogAtomicAdd(&ring->dropped, 1);
+            acaLogAtomicAdd(&gAcaLogShm.writers, (size_t)-1);
+            return;
+        }
+        pos = acaLogAtomicLoad(&ring->enqueuePos);
+    }
+    acaLogAtomicStore(&slot->owner, gAcaLogShm.pid); // first, so the collector can tell if we die
+
+    size_t fileLen  = strlen(file);
+    size_t fileSkip = (fileLen < sizeof(slot->file)) ? 0 : fileLen - (sizeof(slot->file) - 1);
+    memcpy(slot->file, file + fileSkip, fileLen - fileSkip + 1);
+    slot->timestamp = acaLogShmNow() - ring->epoch;
+    slot->pid       = (unsigned int)gAcaLogShm.pid;
+    slot->line      = line;
+    slot->level     = (unsigned char)level;
+    int    len      = acaLogFormat(slot->msg, sizeof(slot->msg), fmt, args);
+    size_t msgLen   = (len < 0) ? 0 : (size_t)len;
+    if (msgLen >= sizeof(slot->msg)) {
+        msgLen = sizeof(slot->msg) - 1;
+    }
+    slot->msgLen = (unsigned short)msgLen;
+    // fails if the collector gave up on this slot in the meantime
+    if (!acaLogAtomicCas(&slot->seq, pos, pos + 1)) {
+        acaLogAtomicAdd(&ring->dropped, 1);
+    }
+    acaLogAtomicAdd(&gAcaLogShm.writers, (size_t)-1);
+#endif // _WIN32
+}
+
+// printf conversion spec (the part after '%') - shared by the binary encoder and decoder
+typedef struct aca_log_fmt_spec {
+    char flags[8];
+    int  width;     // -1 if not given
+    int  precision; // -1 if not given
+    bool widthStar;
+    bool precisionStar;
+    char length[3]; // "", "hh", "h", "l", "ll", "j", "z", "t" or "L"
+    char conv;      // 0 if the format ended mid-spec
+} aca_log_fmt_spec;
+
+// parses one conversion spec starting right after the '%' - returns pointer past the spec
+static const char *acaLogParseFmtSpec(const char *p, aca_log_fmt_spec *spec) {
+    size_t flagCount = 0;
+    memset(spec, 0, sizeof(*spec));
+    spec->width     = -1;
+    spec->precision = -1;
+    while ((*p != 0) && (strchr("-+ #0", *p) != NULL)) {
+        if (flagCount < sizeof(spec->flags) - 1) {
+            spec->flags[flagCount++] = *p;
+        }
+        ++p;
+    }
+    if (*p == '*') {
+        spec->widthStar = true;
+        ++p;
+    } else if ((*p >= '0') && (*p <= '9')) {
+        spec->width = 0;
+        while ((*p >= '0') && (*p <= '9')) {
+            spec->width = (spec->width * 10) + (*p++ - '0');
+        }
+    }
+    if (*p == '.') {
+        ++p;
+        spec->precision = 0;
+        if (*p == '*') {
+            spec->precisionStar = true;
+            ++p;
+        }
+        while ((*p >= '0') && (*p <= '9')) {
+            spec->precision = (spec->precision * 10) + (*p++ - '0');
+        }
+    }
+    if (((p[0] == 'h') && (p[1] == 'h')) || ((p[0] == 'l') && (p[1] == 'l'))) {
+        spec->length[0] = *p++;
+        spec->length[1] = *p++;
+    } else if ((*p != 0) && (strchr("hljztL", *p) != NULL)) {
+        spec->length[0] = *p++;
+    }
+    spec->conv = *p;
+    return (*p != 0) ? p + 1 : p;
+}
+
+// argument types as pulled from a va_list (8 byte integer types are all stored as long long)
+enum {
+    ACA_LOG_ARG_INT,
+    ACA_LOG_ARG_LONG,
+    ACA_LOG_ARG_LLONG,
+    ACA_LOG_ARG_INTMAX,
+    ACA_LOG_ARG_SIZE,
+    ACA_LOG_ARG_PTRDIFF,
+    ACA_LOG_ARG_DOUBLE,
+    ACA_LOG_ARG_LDOUBLE,
+    ACA_LOG_ARG_STRING,
+    ACA_LOG_ARG_WSTRING, // %ls - stored as UTF-8
+    ACA_LOG_ARG_POINTER,
+    ACA_LOG_ARG_SKIP, // %n - consumed but never stored
+};
+
+// maps a conversion spec to the type of its value argument (-1 if it takes none)
+static int acaLogFmtSpecArgType(const aca_log_fmt_spec *spec) {
+    switch (spec->conv) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            switch (spec->length[0]) {
+                case 'l':
+                    return (spec->length[1] == 'l') ? ACA_LOG_ARG_LLONG : ACA_LOG_ARG_LONG;
+                case 'j':
+                    return ACA_LOG_ARG_INTMAX;
+                case 'z':
+                    return ACA_LOG_ARG_SIZE;
+                case 't':
+                    return ACA_LOG_ARG_PTRDIFF;
+                default:
+                    return ACA_LOG_ARG_INT;
+            }
+        case 'c':
+            return ACA_LOG_ARG_INT;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            return (spec->length[0] == 'L') ? ACA_LOG_ARG_LDOUBLE : ACA_LOG_ARG_DOUBLE;
+        case 's':
+            return (spec->length[0] == 'l') ? ACA_LOG_ARG_WSTRING : ACA_LOG_ARG_STRING;
+        case 'p':
+            return ACA_LOG_ARG_POINTER;
+        case 'n':
+            return ACA_LOG_ARG_SKIP;
+        default:
+            return -1;
+    }
+}
+
+// binary log file layout (native byte order):
+//   header: "ACALOGB2" u16 tagLen, tag (the producer's ACA_LOG_TAG - "ACALOGB1" files have none)
+//   site:   'S' u32 id, u8 level, i32 line, u16 fileLen, file, u16 fmtLen, fmt
+//   record: 'R' u32 id, f64 timestamp, u16 argLen, args (4 byte int, 8 byte integer types,
+//           double, u16 length + bytes for strings (%ls as UTF-8), 8 byte pointers)
+#define ACA_LOG_BINARY_MAGIC "ACALOGB2"
+#define ACA_LOG_BINARY_MAGIC_V1 "ACALOGB1"
+#define ACA_LOG_BINARY_MAX_ARGS 32
+
+struct aca_log_binary_site {
+    unsigned int  id;
+    aca_log_level level;
+    const char   *file;
+    int           line;
+    const char   *fmt;
+    size_t        argCount;
+    unsigned char argTypes[ACA_LOG_BINARY_MAX_ARGS];
+};
+
+// per-thread staging buffer - every live one is in a registry so flush/close can reach the records
+// other threads still hold, busy keeps the owner's appends and those flushes apart
+typedef struct aca_log_binary_buffer {
+    struct aca_log_binary_buffer *next;
+    volatile size_t               busy;
+    size_t                        used;
+    unsigned char                 data[ACA_LOG_BINARY_BUFFER_SIZE];
+} aca_log_binary_buffer;
+
+static struct {
+    aca_log_mutex         lock;
+    FILE                 *fp;
+    aca_log_binary_site **sites;
+    size_t                siteCount;
+    size_t                siteCapacity;
+} gAcaLogBinary = {ACA_LOG_MUTEX_INIT};
+
+// lock order: gAcaLogBinaryBuffersLock -> buffer busy -> gAcaLogBinary.lock
+static aca_log_mutex          gAcaLogBinaryBuffersLock = ACA_LOG_MUTEX_INIT;
+static aca_log_binary_buffer *gAcaLogBinaryBuffers     = NULL;
+
+static THREAD_LOCAL aca_log_binary_buffer *tl_acaLogBinaryBuffer = NULL;
+
+static inline void acaLogBinaryBufferLock(aca_log_binary_buffer *buffer) {
+    while (acaLogAtomicExchange(&buffer->busy, 1) != 0) {
+        acaLogThreadYield();
+    }
+}
+
+static inline void acaLogBinaryBufferUnlock(aca_log_binary_buffer *buffer) {
+    acaLogAtomicStore(&buffer->busy, 0);
+}
+
+static void acaLogBinaryWriteSiteLocked(const aca_log_binary_site *site) {
+    unsigned char  level    = (unsigned char)site->level;
+    unsigned short fileLen  = (unsigned short)strlen(site->file);
+    unsigned short fmtLen   = (unsigned short)strlen(site->fmt);
+    fputc('S', gAcaLogBinary.fp);
+    fwrite(&site->id, sizeof(site->id), 1, gAcaLogBinary.fp);
+    fwrite(&level, 1, 1, gAcaLogBinary.fp);
+    fwrite(&site->line, sizeof(site->line), 1, gAcaLogBinary.fp);
+    fwrite(&fileLen, sizeof(fileLen), 1, gAcaLogBinary.fp);
+    fwrite(site->file, 1, fileLen, gAcaLogBinary.fp);
+    fwrite(&fmtLen, sizeof(fmtLen), 1, gAcaLogBinary.fp);
+    fwrite(site->fmt, 1, fmtLen, gAcaLogBinary.fp);
+}
+
+static int acaLogBinaryOpenLocked(const char *path) {
+    if (gAcaLogBinary.fp != NULL) {
+        fclose(gAcaLogBinary.fp);
+    }
+    gAcaLogBinary.fp = fopen(path, "wb");
+    if (gAcaLogBinary.fp == NULL) {
+        return -1;
+    }
+#if defined(ACA_LOG_TAG)
+    const char *tag = ACA_LOG_TAG;
+#else
+    const char *tag = "";
+#endif // ACA_LOG_TAG
+    unsigned short tagLen = (unsigned short)strlen(tag);
+    fwrite(ACA_LOG_BINARY_MAGIC, 1, sizeof(ACA_LOG_BINARY_MAGIC) - 1, gAcaLogBinary.fp);
+    fwrite(&tagLen, sizeof(tagLen), 1, gAcaLogBinary.fp);
+    fwrite(tag, 1, tagLen, gAcaLogBinary.fp);
+    // sites registered before this open still need their definitions in the new file
+    for (size_t i = 0; i < gAcaLogBinary.siteCount; ++i) {
+        acaLogBinaryWriteSiteLocked(gAcaLogBinary.sites[i]);
+    }
+    return 0;
+}
+
+// the caller holds the buffer's busy flag (or owns it exclusively)
+static void acaLogBinaryFlushBuffer(aca_log_binary_buffer *buffer) {
+    if ((buffer == NULL) || (buffer->used == 0)) {
+        return;
+    }
+    acaLogMutexLock(&gAcaLogBinary.lock);
+    if (gAcaLogBinary.fp != NULL) {
+        fwrite(buffer->data, 1, buffer->used, gAcaLogBinary.fp);
+    }
+    acaLogMutexUnlock(&gAcaLogBinary.lock);
+    buffer->used = 0;
+}
+
+#ifndef _WIN32
+static pthread_key_t  gAcaLogBinaryKey;
+static pthread_once_t gAcaLogBinaryKeyOnce = PTHREAD_ONCE_INIT;
+
+// thread exit hook - hands the exiting thread's staged records to the file
+static void acaLogBinaryThreadExit(void *arg) {
+    aca_log_binary_buffer *buffer = (aca_log_binary_buffer *)arg;
+    acaLogMutexLock(&gAcaLogBinaryBuffersLock);
+    aca_log_binary_buffer **link = &gAcaLogBinaryBuffers;
+    while ((*link != NULL) && (*link != buffer)) {
+        link = &(*link)->next;
+    }
+    if (*link != NULL) {
+        *link = buffer->next;
+    }
+    acaLogMutexUnlock(&gAcaLogBinaryBuffersLock);
+    acaLogBinaryFlushBuffer(buffer);
+    free(buffer);
+}
+static void acaLogBinaryKeyCreate(void) {
+    pthread_key_create(&gAcaLogBinaryKey, acaLogBinaryThreadExit);
+}
+#endif // _WIN32
+
+static aca_log_binary_buffer *acaLogBinaryGetBuffer(void) {
+    if (tl_acaLogBinaryBuffer == NULL) {
+        tl_acaLogBinaryBuffer = (aca_log_binary_buffer *)malloc(sizeof(aca_log_binary_buffer));
+        if (tl_acaLogBinaryBuffer == NULL) {
+            return NULL;
+        }
+        tl_acaLogBinaryBuffer->busy = 0;
+        tl_acaLogBinaryBuffer->used = 0;
+        acaLogMutexLock(&gAcaLogBinaryBuffersLock);
+        tl_acaLogBinaryBuffer->next = gAcaLogBinaryBuffers;
+        gAcaLogBinaryBuffers        = tl_acaLogBinaryBuffer;
+        acaLogMutexUnlock(&gAcaLogBinaryBuffersLock);
+#ifndef _WIN32
+        pthread_once(&gAcaLogBinaryKeyOnce, acaLogBinaryKeyCreate);
+        pthread_setspecific(gAcaLogBinaryKey, tl_acaLogBinaryBuffer);
+#endif // _WIN32
+    }
+    return tl_acaLogBinaryBuffer;
+}
+
+// registers a call site once - later calls only load the cached site pointer
+static aca_log_binary_site *acaLogBinaryRegister(aca_log_binary_site **sitePtr,
+                                                 aca_log_level         level,
+                                                 const char           *file,
+                                                 int                   line,
+                                                 const char           *fmt) {
+    acaLogMutexLock(&gAcaLogBinary.lock);
+    aca_log_binary_site *site = *sitePtr;
+    if (site != NULL) {
+        acaLogMutexUnlock(&gAcaLogBinary.lock);
+        return site;
+    }
+    if (gAcaLogBinary.siteCount == gAcaLogBinary.siteCapacity) {
+        size_t                capacity =
+            gAcaLogBinary.siteCapacity ? gAcaLogBinary.siteCapacity * 2 : 64;
+        aca_log_binary_site **sites    = (aca_log_binary_site **)realloc(
+            gAcaLogBinary.sites, capacity * sizeof(aca_log_binary_site *));
+        if (sites == NULL) {
+            acaLogMutexUnlock(&gAcaLogBinary.lock);
+            return NULL;
+        }
+        gAcaLogBinary.sites        = sites;
+        gAcaLogBinary.siteCapacity = capacity;
+    }
+    site = (aca_log_binary_site *)calloc(1, sizeof(aca_log_binary_site));
+    if (site == NULL) {
+        acaLogMutexUnlock(&gAcaLogBinary.lock);
+        return NULL;
+    }
+    site->level = level;
+    site->file  = file;
+    site->line  = line;
+    site->fmt   = fmt;
+    for (const char *p = fmt; *p != 0;) {
+        if (*p++ != '%') {
+            continue;
+        }
+        if (*p == '%') {
+            ++p;
+            continue;
+        }
+        aca_log_fmt_spec spec;
+        p        = acaLogParseFmtSpec(p, &spec);
+        int type = acaLogFmtSpecArgType(&spec);
+        assert((site->argCount + 3 <= ACA_LOG_BINARY_MAX_ARGS) && "too many binary log args!");
+        if (spec.widthStar) {
+            site->argTypes[site->argCount++] = ACA_LOG_ARG_INT;
+        }
+        if (spec.precisionStar) {
+            site->argTypes[site->argCount++] = ACA_LOG_ARG_INT;
+        }
+        if (type >= 0) {
+            site->argTypes[site->argCount++] = (unsigned char)type;
+        }
+    }
+
+    gAcaLogBinary.sites[gAcaLogBinary.siteCount++] = site;
+    site->id                                         = (unsigned int)gAcaLogBinary.siteCount;
+    if (gAcaLogBinary.fp == NULL) {
+        acaLogBinaryOpenLocked("dump.bin");
+    } else {
+        acaLogBinaryWriteSiteLocked(site);
+    }
+    acaLogAtomicStorePtr((void *volatile *)sitePtr, site);
+    acaLogMutexUnlock(&gAcaLogBinary.lock);
+    return site;
+}
+
+// hands every thread's staged records to the current file
+static void acaLogBinaryFlushBuffers(void) {
+    acaLogMutexLock(&gAcaLogBinaryBuffersLock);
+    aca_log_binary_buffer *buffer = gAcaLogBinaryBuffers;
+    for (; buffer != NULL; buffer = buffer->next) {
+        acaLogBinaryBufferLock(buffer);
+        acaLogBinaryFlushBuffer(buffer);
+        acaLogBinaryBufferUnlock(buffer);
+    }
+    acaLogMutexUnlock(&gAcaLogBinaryBuffersLock);
+}
+
+// starts a new binary log file (otherwise the first binary record opens dump.bin)
+int acaLogBinaryOpen(const char *path) {
+    static bool registeredAtExit = false;
+    acaLogBinaryFlushBuffers();
+    acaLogMutexLock(&gAcaLogBinary.lock);
+    int ret = acaLogBinaryOpenLocked(path);
+    if ((ret == 0) && !registeredAtExit) {
+        atexit(acaLogBinaryClose);
+        registeredAtExit = true;
+    }
+    acaLogMutexUnlock(&gAcaLogBinary.lock);
+    return ret;
+}
+
+// hands every thread's staged records to the file and flushes it
+void acaLogBinaryFlush(void) {
+    acaLogBinaryFlushBuffers();
+    acaLogMutexLock(&gAcaLogBinary.lock);
+    if (gAcaLogBinary.fp != NULL) {
+        fflush(gAcaLogBinary.fp);
+    }
+    acaLogMutexUnlock(&gAcaLogBinary.lock);
+}
+
+// writes out every thread's staged records and closes the file
+void acaLogBinaryClose(void) {
+    acaLogBinaryFlushBuffers();
+    acaLogMutexLock(&gAcaLogBinary.lock);
+    if (gAcaLogBinary.fp != NULL) {
+        fclose(gAcaLogBinary.fp);
+        gAcaLogBinary.fp = NULL;
+    }
+    acaLogMutexUnlock(&gAcaLogBinary.lock);
+}
+
+// copies a wide string as UTF-8 (joining UTF-16 surrogate pairs where wchar_t is 16 bit) - at
+// most room bytes and never a partial sequence. returns the bytes written
+static size_t acaLogBinaryPutWide(unsigned char *out, size_t room, const wchar_t *str) {
+    size_t len = 0;
+    for (; (str != NULL) && (*str != 0); ++str) {
+        unsigned long c = (unsigned long)*str;
+        if ((c >= 0xd800) && (c < 0xdc00) && ((unsigned long)str[1] >= 0xdc00) &&
+            ((unsigned long)str[1] < 0xe000)) {
+            c = 0x10000 + ((c - 0xd800) << 10) + ((unsigned long)*++str - 0xdc00);
+        }
+        if ((c >= 0x110000) || ((c >= 0xd800) && (c < 0xe000))) {
+            c = 0xfffd; // lone surrogate or out of range
+        }
+        unsigned char seq[4];
+        size_t        n;
+        if (c < 0x80) {
+            seq[0] = (unsigned char)c;
+            n      = 1;
+        } else if (c < 0x800) {
+            seq[0] = (unsigned char)(0xc0 | (c >> 6));
+            seq[1] = (unsigned char)(0x80 | (c & 0x3f));
+            n      = 2;
+        } else if (c < 0x10000) {
+            seq[0] = (unsigned char)(0xe0 | (c >> 12));
+            seq[1] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+            seq[2] = (unsigned char)(0x80 | (c & 0x3f));
+            n      = 3;
+        } else {
+            seq[0] = (unsigned char)(0xf0 | (c >> 18));
+            seq[1] = (unsigned char)(0x80 | ((c >> 12) & 0x3f));
+            seq[2] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+            seq[3] = (unsigned char)(0x80 | (c & 0x3f));
+            n      = 4;
+        }
+        if (n > room - len) {
+            break;
+        }
+        memcpy(&out[len], seq, n);
+        len += n;
+    }
+    return len;
+}
+
+// stores site id, timestamp and raw argument bytes into the calling thread's staging buffer
+void acaLogBinary(aca_log_binary_site **sitePtr,
+                  aca_log_level         level,
+                  const char           *file,
+                  int                   line,
+                  const char           *fmt,
+                  ...) {
+    aca_log_binary_site *site =
+        (aca_log_binary_site *)acaLogAtomicLoadPtr((void *volatile *)sitePtr);
+    if (site == NULL) {
+        site = acaLogBinaryRegister(sitePtr, level, file, line, fmt);
+    }
+    aca_log_binary_buffer *buffer = acaLogBinaryGetBuffer();
+    if ((site == NULL) || (buffer == NULL)) {
+        return;
+    }
+    acaLogBinaryBufferLock(buffer);
+    if (ACA_LOG_BINARY_BUFFER_SIZE - buffer->used < ACA_LOG_BINARY_RECORD_MAX) {
+        acaLogBinaryFlushBuffer(buffer);
+    }
+
+    unsigned char *record    = &buffer->data[buffer->used];
+    unsigned char *out       = record + 15; // 'R' + id + timestamp + argLen
+    unsigned char *recordEnd = record + ACA_LOG_BINARY_RECORD_MAX;
+    double         timestamp = GetTimestamp();
+    record[0]                = 'R';
+    memcpy(&record[1], &site->id, 4);
+    memcpy(&record[5], &timestamp, 8);
+
+    va_list args;
+    va_start(args, fmt);
+    for (size_t i = 0; i < site->argCount; ++i) {
+        long long   integer;
+        double      real;
+        const char *str;
+        switch (site->argTypes[i]) {
+            case ACA_LOG_ARG_INT: {
+                int value = va_arg(args, int);
+                memcpy(out, &value, sizeof(value));
+                out += sizeof(value);
+                continue;
+            }
+            case ACA_LOG_ARG_LONG:
+                integer = va_arg(args, long);
+                break;
+            case ACA_LOG_ARG_LLONG:
+                integer = va_arg(args, long long);
+                break;
+            case ACA_LOG_ARG_INTMAX:
+                integer = (long long)va_arg(args, intmax_t);
+                break;
+            case ACA_LOG_ARG_SIZE:
+                integer = (long long)va_arg(args, size_t);
+                break;
+            case ACA_LOG_ARG_PTRDIFF:
+                integer = (long long)va_arg(args, ptrdiff_t);
+                break;
+            case ACA_LOG_ARG_POINTER:
+                integer = (long long)(uintptr_t)va_arg(args, void *);
+                break;
+            case ACA_LOG_ARG_DOUBLE:
+            case ACA_LOG_ARG_LDOUBLE:
+                if (site->argTypes[i] == ACA_LOG_ARG_DOUBLE) {
+                    real = va_arg(args, double);
+                } else {
+                    real = (double)va_arg(args, long double);
+                }
+                memcpy(out, &real, sizeof(real));
+                out += sizeof(real);
+                continue;
+            case ACA_LOG_ARG_STRING: {
+                // strings are copied, truncated to fit ACA_LOG_BINARY_RECORD_MAX (the args after
+                // this one take at most 8 bytes each)
+                str                   = va_arg(args, const char *);
+                size_t         later  = (site->argCount - i - 1) * 8;
+                size_t         room   = (size_t)(recordEnd - out) - 2 - later;
+                size_t         len    = (str != NULL) ? strlen(str) : 0;
+                unsigned short strLen = (unsigned short)((len < room) ? len : room);
+                memcpy(out, &strLen, sizeof(strLen));
+                if (strLen > 0) {
+                    memcpy(out + sizeof(strLen), str, strLen);
+                }
+                out += sizeof(strLen) + strLen;
+                continue;
+            }
+            case ACA_LOG_ARG_WSTRING: {
+                const wchar_t *wstr   = va_arg(args, const wchar_t *);
+                size_t         later  = (site->argCount - i - 1) * 8;
+                size_t         room   = (size_t)(recordEnd - out) - 2 - later;
+                unsigned short strLen = (unsigned short)acaLogBinaryPutWide(out + 2, room, wstr);
+                memcpy(out, &strLen, sizeof(strLen));
+                out += sizeof(strLen) + strLen;
+                continue;
+            }
+            default:
+                (void)va_arg(args, void *);
+                continue;
+        }
+        memcpy(out, &integer, sizeof(integer));
+        out += sizeof(integer);
+    }
+    va_end(args);
+
+    unsigned short argLen = (unsigned short)(out - (record + 15));
+    memcpy(&record[13], &argLen, 2);
+    buffer->used += (size_t)(out - record);
+    acaLogBinaryBufferUnlock(buffer);
+
+    if (level == ACA_LOG_FATAL) {
+        acaLogBinaryFlush();
+    }
+}
+
+// renders one binary record's message by replaying its format with the stored arguments
+static void acaLogBinaryRender(FILE                *out,
+                               const char          *fmt,
+                               const unsigned char *args,
+                               size_t               argLen) {
+    const unsigned char *argsEnd = args + argLen;
+    const char          *p       = fmt;
+    while (*p != 0) {
+        const char *literal = p;
+        while ((*p != 0) && (*p != '%')) {
+            ++p;
+        }
+        fwrite(literal, 1, (size_t)(p - literal), out);
+        if (*p == 0) {
+            break;
+        }
+        if (p[1] == '%') {
+            fputc('%', out);
+            p += 2;
+            continue;
+        }
+
+        aca_log_fmt_spec spec;
+        p = acaLogParseFmtSpec(p + 1, &spec);
+        int width = spec.width, precision = spec.precision;
+        if (spec.widthStar && (args + 4 <= argsEnd)) {
+            memcpy(&width, args, 4);
+            args += 4;
+        }
+        if (spec.precisionStar && (args + 4 <= argsEnd)) {
+            memcpy(&precision, args, 4);
+            args += 4;
+        }
+
+        // rebuild a single-conversion format with star args resolved and length normalized
+        char   specFmt[48];
+        size_t n = (size_t)snprintf(specFmt, sizeof(specFmt), "%%%s", spec.flags);
+        if (width >= 0 || spec.widthStar) {
+            n += (size_t)snprintf(&specFmt[n], sizeof(specFmt) - n, "%d", width);
+        }
+        if (precision >= 0) {
+            n += (size_t)snprintf(&specFmt[n], sizeof(specFmt) - n, ".%d", precision);
+        }
+
+        int       type = acaLogFmtSpecArgType(&spec);
+        long long integer;
+        double    real;
+        switch (type) {
+            case ACA_LOG_ARG_INT: {
+                int value = 0;
+                if (args + 4 <= argsEnd) {
+                    memcpy(&value, args, 4);
+                    args += 4;
+                }
+                snprintf(&specFmt[n], sizeof(specFmt) - n, "%s%c", spec.length, spec.conv);
+                fprintf(out, specFmt, value);
+                break;
+            }
+            case ACA_LOG_ARG_DOUBLE:
+            case ACA_LOG_ARG_LDOUBLE:
+                real = 0.0;
+                if (args + 8 <= argsEnd) {
+                    memcpy(&real, args, 8);
+                    args += 8;
+                }
+                snprintf(&specFmt[n], sizeof(specFmt) - n, "%c", spec.conv);
+                fprintf(out, specFmt, real);
+                break;
+            case ACA_LOG_ARG_STRING:
+            case ACA_LOG_ARG_WSTRING: {
+                unsigned short strLen = 0;
+                if (args + 2 <= argsEnd) {
+                    memcpy(&strLen, args, 2);
+                    args += 2;
+                }
+                if (args + strLen > argsEnd) {
+                    strLen = (unsigned short)(argsEnd - args);
+                }
+                // stored string isn't terminated - cap the precision at the stored length
+                if ((precision < 0) || (precision > strLen)) {
+                    n = (size_t)snprintf(specFmt, sizeof(specFmt), "%%%s", spec.flags);
+                    if (width >= 0) {
+                        n += (size_t)snprintf(&specFmt[n], sizeof(specFmt) - n, "%d", width);
+                    }
+                    snprintf(&specFmt[n], sizeof(specFmt) - n, ".%us", (unsigned int)strLen);
+                } else {
+                    snprintf(&specFmt[n], sizeof(specFmt) - n, "s");
+                }
+                fprintf(out, specFmt, (const char *)args);
+                args += strLen;
+                break;
+            }
+            case ACA_LOG_ARG_SKIP:
+                break;
+            case -1:
+                break;
+            default: // remaining integer types and pointers are 8 bytes on the wire
+                integer = 0;
+                if (args + 8 <= argsEnd) {
+                    memcpy(&integer, args, 8);
+                    args += 8;
+                }
+                if (type == ACA_LOG_ARG_POINTER) {
+                    snprintf(&specFmt[n], sizeof(specFmt) - n, "p");
+                    fprintf(out, specFmt, (void *)(uintptr_t)integer);
+                } else {
+                    snprintf(&specFmt[n], sizeof(specFmt) - n, "ll%c", spec.conv);
+                    fprintf(out, specFmt, integer);
+                }
+                break;
+        }
+    }
+}
+
+// a decoded record - args point into the decoder's argument arena
+typedef struct aca_log_binary_record {
+    double       timestamp;
+    size_t       order; // position in the file - keeps equal timestamps in file order
+    unsigned int id;
+    size_t       argOffset;
+    size_t       argLen;
+} aca_log_binary_record;
+
+static int acaLogBinaryRecordCompare(const void *a, const void *b) {
+    const aca_log_binary_record *x = (const aca_log_binary_record *)a;
+    const aca_log_binary_record *y = (const aca_log_binary_record *)b;
+    if (x->timestamp != y->timestamp) {
+        return (x->timestamp < y->timestamp) ? -1 : 1;
+    }
+    return (x->order < y->order) ? -1 : (x->order > y->order);
+}
+
+// renders a binary log file as standard log lines, merged by timestamp across threads (each thread
+// hands its records over in chunks) - returns 0 on success, -1 if malformed (the records read
+// before the damage are still rendered)
+int acaLogBinaryDecode(FILE *in, FILE *out) {
+    typedef struct {
+        aca_log_level level;
+        int           line;
+        char         *file;
+        char         *fmt;
+    } decoded_site;
+    char                   magic[sizeof(ACA_LOG_BINARY_MAGIC) - 1];
+    char                  *tag      = NULL;
+    decoded_site          *sites    = NULL;
+    size_t                 capacity = 0;
+    size_t                 lastId   = 0; // highest site id defined so far
+    aca_log_binary_record *records  = NULL;
+    size_t                 count    = 0;
+    size_t                 slots    = 0;
+    unsigned char         *arena    = NULL;
+    size_t                 arenaLen = 0;
+    size_t                 arenaCap = 0;
+    int                    ret      = 0;
+
+    if (fread(magic, 1, sizeof(magic), in) != sizeof(magic)) {
+        return -1;
+    }
+    if (memcmp(magic, ACA_LOG_BINARY_MAGIC, sizeof(magic)) == 0) {
+        unsigned short tagLen;
+        if (fread(&tagLen, 2, 1, in) != 1) {
+            return -1;
+        }
+        tag = (char *)calloc(tagLen + 1, 1);
+        if ((tag == NULL) || (fread(tag, 1, tagLen, in) != tagLen)) {
+            free(tag);
+            return -1;
+        }
+    } else if (memcmp(magic, ACA_LOG_BINARY_MAGIC_V1, sizeof(magic)) != 0) {
+        return -1;
+    }
+    while (1) {
+        unsigned int id;
+        int          type = fgetc(in);
+        if (type == EOF) {
+            break;
+        }
+        if (fread(&id, 4, 1, in) != 1) {
+            ret = -1;
+            break;
+        }
+        if (type == 'S') {
+            unsigned char  level;
+            int            line;
+            unsigned short fileLen, fmtLen;
+            if ((fread(&level, 1, 1, in) != 1) || (fread(&line, 4, 1, in) != 1) ||
+                (fread(&fileLen, 2, 1, in) != 1)) {
+                ret = -1;
+                break;
+            }
+            char *file = (char *)calloc(fileLen + 1, 1);
+            if ((file == NULL) || (fread(file, 1, fileLen, in) != fileLen) ||
+                (fread(&fmtLen, 2, 1, in) != 1)) {
+                free(file);
+                ret = -1;
+                break;
+            }
+            char *fmt = (char *)calloc(fmtLen + 1, 1);
+            if ((fmt == NULL) || (fread(fmt, 1, fmtLen, in) != fmtLen)) {
+                free(file);
+                free(fmt);
+                ret = -1;
+                break;
+            }
+            // site ids are handed out in order and defined before use - one further ahead than
+            // the next new id can't come from a producer (and would blow up the site table)
+            if (id > lastId + 1) {
+                free(file);
+                free(fmt);
+                ret = -1;
+                break;
+            }
+            lastId = (id > lastId) ? id : lastId;
+            if (id >= capacity) {
+                size_t        newCapacity = ((size_t)id + 1) * 2;
+                decoded_site *newSites =
+                    (decoded_site *)realloc(sites, newCapacity * sizeof(decoded_site));
+                if (newSites == NULL) {
+                    free(file);
+                    free(fmt);
+                    ret = -1;
+                    break;
+                }
+                memset(&newSites[capacity], 0, (newCapacity - capacity) * sizeof(decoded_site));
+                sites    = newSites;
+                capacity = newCapacity;
+            }
+            free(sites[id].file);
+            free(sites[id].fmt);
+            sites[id].level = (aca_log_level)level;
+            sites[id].line  = line;
+            sites[id].file  = file;
+            sites[id].fmt   = fmt;
+        } else if (type == 'R') {
+            double         timestamp;
+            unsigned short argLen;
+            if ((fread(&timestamp, 8, 1, in) != 1) || (fread(&argLen, 2, 1, in) != 1) ||
+                (argLen > ACA_LOG_BINARY_RECORD_MAX) || (id >= capacity) ||
+                (sites[id].fmt == NULL)) {
+                ret = -1;
+                break;
+            }
+            if (count == slots) {
+                size_t                 newSlots = slots ? slots * 2 : 1024;
+                aca_log_binary_record *newRecords =
+                    (aca_log_binary_record *)realloc(records, newSlots * sizeof(*records));
+                if (newRecords == NULL) {
+                    ret = -1;
+                    break;
+                }
+                records = newRecords;
+                slots   = newSlots;
+            }
+            if (arenaCap - arenaLen < argLen) {
+                size_t         newCap   = arenaCap ? arenaCap * 2 : 64 * 1024;
+                unsigned char *newArena = (unsigned char *)realloc(arena, newCap);
+                if (newArena == NULL) {
+                    ret = -1;
+                    break;
+                }
+                arena    = newArena;
+                arenaCap = newCap;
+            }
+            if (fread(&arena[arenaLen], 1, argLen, in) != argLen) {
+                ret = -1;
+                break;
+            }
+            records[count].timestamp = timestamp;
+            records[count].order     = count;
+            records[count].id        = id;
+            records[count].argOffset = arenaLen;
+            records[count].argLen    = argLen;
+            arenaLen += argLen;
+            ++count;
+        } else {
+            ret = -1;
+            break;
+        }
+    }
+
+    if (count > 0) {
+        qsort(records, count, sizeof(*records), acaLogBinaryRecordCompare);
+    }
+#if defined(ACA_LOG_TAG)
+    const char *prefixTag = (tag != NULL) ? tag : ACA_LOG_TAG; // "ACALOGB1" files have no tag
+#else
+    const char *prefixTag = tag;
+#endif // ACA_LOG_TAG
+    for (size_t i = 0; i < count; ++i) {
+        const decoded_site *site = &sites[records[i].id];
+        size_t              len  = acaLogStandardPrefixFormatTag(tl_acaLogLineBuffer,
+                                                                 sizeof(tl_acaLogLineBuffer),
+                                                                 prefixTag,
+                                                                 out == stdout,
+                                                                 site->level,
+                                                                 site->file,
+                                                                 site->line,
+                                                                 records[i].timestamp);
+        fwrite(tl_acaLogLineBuffer, 1, len, out);
+        acaLogBinaryRender(out, site->fmt, &arena[records[i].argOffset], records[i].argLen);
+        fputc('\n', out);
+    }
+
+    for (size_t i = 0; i < capacity; ++i) {
+        free(sites[i].file);
+        free(sites[i].fmt);
+    }
+    free(sites);
+    free(records);
+    free(arena);
+    free(tag);
+    return ret;
+}
+
+// structured encoder - appends into a fixed buffer (never allocates), a field that doesn't fit is
+// rolled back and the record is marked as truncated
+typedef struct aca_log_kv_writer {
+    char  *buf;
+    size_t len;
+    size_t cap; // usable bytes - the record terminator is reserved on top of this
+    bool   full;
+} aca_log_kv_writer;
+
+// set by acaLogKv for the structured handlers
+static THREAD_LOCAL const aca_log_kv *tl_acaLogKvFields = NULL;
+static THREAD_LOCAL size_t            tl_acaLogKvCount  = 0;
+// logfmt-encoded fields for handlers that only understand fmt strings
+static THREAD_LOCAL char tl_acaLogKvBuffer[ACA_LOG_LINE_BUFFER_SIZE];
+
+static inline bool acaLogKvPut(aca_log_kv_writer *w, const char *str, size_t len) {
+    if (w->full || (w->len > w->cap) || (len > w->cap - w->len)) {
+        w->full = true;
+        return false;
+    }
+    memcpy(&w->buf[w->len], str, len);
+    w->len += len;
+    return true;
+}
+
+static inline bool acaLogKvPutChar(aca_log_kv_writer *w, char c) {
+    if (w->full || (w->len >= w->cap)) {
+        w->full = true;
+        return false;
+    }
+    w->buf[w->len++] = c;
+    return true;
+}
+
+static bool acaLogKvPutUint(aca_log_kv_writer *w, unsigned long long value) {
+    char  tmp[24];
+    char *end = &tmp[sizeof(tmp)];
+    char *p   = acaLogFormatDecimal(end, value);
+    return acaLogKvPut(w, p, (size_t)(end - p));
+}
+
+static bool acaLogKvPutInt(aca_log_kv_writer *w, long long value) {
+    if (value < 0) {
+        return acaLogKvPutChar(w, '-') && acaLogKvPutUint(w, 0ULL - (unsigned long long)value);
+    }
+    return acaLogKvPutUint(w, (unsigned long long)value);
+}
+
+// up to 6 decimals with trailing zeros trimmed, integer math in the common range and %g outside
+// of it - non-finite values are written as null (JSON has no NaN/Inf)
+static bool acaLogKvPutDouble(aca_log_kv_writer *w, double value) {
+    if (value != value || value > 1.7976931348623157e308 || value < -1.7976931348623157e308) {
+        return acaLogKvPut(w, "null", 4);
+    }
+    double mag = (value < 0) ? -value : value;
+    if ((mag != 0.0) && ((mag < 1e-3) || (mag >= 1e15))) {
+        char tmp[32];
+        int  n = snprintf(tmp, sizeof(tmp), "%.6g", value);
+        return acaLogKvPut(w, tmp, (n > 0) ? (size_t)n : 0);
+    }
+    // whole and fraction apart - mag * 1e6 overflows unsigned long long from ~1.8e13 up
+    unsigned long long whole = (unsigned long long)mag;
+    unsigned int       frac  = (unsigned int)((mag - (double)whole) * 1000000.0 + 0.5);
+    if (frac >= 1000000) {
+        ++whole;
+        frac -= 1000000;
+    }
+    if ((value < 0) && ((whole != 0) || (frac != 0)) && !acaLogKvPutChar(w, '-')) {
+        return false;
+    }
+    if (!acaLogKvPutUint(w, whole)) {
+        return false;
+    }
+    if (frac == 0) {
+        return true;
+    }
+    char digits[7];
+    int  ndigits = 6;
+    for (int i = 5; i >= 0; --i) {
+        digits[i] = (char)('0' + frac % 10);
+        frac /= 10;
+    }
+    while (digits[ndigits - 1] == '0') {
+        --ndigits;
+    }
+    return acaLogKvPutChar(w, '.') && acaLogKvPut(w, digits, (size_t)ndigits);
+}
+
+// seconds with fixed microsecond precision
+static bool acaLogKvPutTimestamp(aca_log_kv_writer *w, double timestamp) {
+    unsigned long long usec = (unsigned long long)(timestamp * 1000000.0);
+    unsigned int       frac = (unsigned int)(usec % 1000000);
+    char               digits[7];
+    digits[0] = '.';
+    for (int i = 6; i > 0; --i) {
+        digits[i] = (char)('0' + frac % 10);
+        frac /= 10;
+    }
+    return acaLogKvPutUint(w, usec / 1000000) && acaLogKvPut(w, digits, sizeof(digits));
+}
+
+// writes a quoted JSON string - if truncate is set the string is cut short (and closed) instead of
+// failing when it doesn't fit
+static bool acaLogKvPutJsonString(aca_log_kv_writer *w, const char *str, bool truncate) {
+    static const char hex[] = "0123456789abcdef";
+    size_t            start = w->len;
+    if (!acaLogKvPutChar(w, '"')) {
+        return false;
+    }
+    w->cap -= 1; // keep room for the closing quote
+    for (const char *p = str ? str : ""; *p != 0; ++p) {
+        unsigned char c = (unsigned char)*p;
+        // plain runs are copied in one go
+        const char *run = p;
+        while ((c >= 0x20) && (c != '"') && (c != '\\')) {
+            c = (unsigned char)*++p;
+        }
+        if ((p != run) && !acaLogKvPut(w, run, (size_t)(p - run))) {
+            if (truncate && (w->len < w->cap)) { // copy whatever still fits
+                size_t runStart = w->len;
+                w->full         = false;
+                acaLogKvPut(w, run, w->cap - w->len);
+                w->full = true;
+                // don't leave a partial UTF-8 sequence behind
+                while ((w->len > runStart) &&
+                       (((unsigned char)w->buf[w->len - 1] & 0xc0) == 0x80)) {
+                    --w->len;
+                }
+                if ((w->len > runStart) && ((unsigned char)w->buf[w->len - 1] >= 0xc0)) {
+                    --w->len;
+                }
+            }
+            break;
+        }
+        if (c == 0) {
+            break;
+        }
+        char   esc[6] = {'\\', 0, '0', '0', 0, 0};
+        size_t escLen = 2;
+        switch (c) {
+            case '"':
+                esc[1] = '"';
+                break;
+            case '\\':
+                esc[1] = '\\';
+                break;
+            case '\n':
+                esc[1] = 'n';
+                break;
+            case '\r':
+                esc[1] = 'r';
+                break;
+            case '\t':
+                esc[1] = 't';
+                break;
+            default:
+                esc[1] = 'u';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0xf];
+                escLen = 6;
+                break;
+        }
+        if (!acaLogKvPut(w, esc, escLen)) {
+            break;
+        }
+    }
+    w->cap += 1;
+    if (w->full && !truncate) {
+        w->len = start;
+        return false;
+    }
+    bool full = w->full;
+    w->full   = false;
+    acaLogKvPutChar(w, '"');
+    w->full = full;
+    return !full;
+}
+
+// writes a logfmt value - bare if it only has safe characters, otherwise quoted and escaped
+static bool acaLogKvPutLogfmtString(aca_log_kv_writer *w, const char *str, bool truncate) {
+    const char *p     = str ? str : "";
+    bool        quote = (*p == 0);
+    for (const char *q = p; *q != 0 && !quote; ++q) {
+        quote = ((unsigned char)*q <= ' ') || (*q == '=') || (*q == '"') || (*q == '\\');
+    }
+    if (!quote) {
+        size_t start = w->len;
+        size_t len   = strlen(p);
+        if (acaLogKvPut(w, p, len)) {
+            return true;
+        }
+        if (truncate && (w->len < w->cap)) {
+            w->full = false;
+            acaLogKvPut(w, p, w->cap - w->len);
+            w->full = true;
+        } else if (!truncate) {
+            w->len = start;
+        }
+        return false;
+    }
+    return acaLogKvPutJsonString(w, p, truncate); // same escaping rules
+}
+
+static bool acaLogKvPutValue(aca_log_kv_writer *w, const aca_log_kv *field, bool json) {
+    switch (field->type) {
+        case ACA_LOG_KV_TYPE_INT:
+            return acaLogKvPutInt(w, field->i);
+        case ACA_LOG_KV_TYPE_UINT:
+            return acaLogKvPutUint(w, (unsigned long long)field->i);
+        case ACA_LOG_KV_TYPE_DOUBLE:
+            return acaLogKvPutDouble(w, field->d);
+        case ACA_LOG_KV_TYPE_BOOL:
+            return field->i ? acaLogKvPut(w, "true", 4) : acaLogKvPut(w, "false", 5);
+        case ACA_LOG_KV_TYPE_STR:
+            return json ? acaLogKvPutJsonString(w, field->s, false)
+                        : acaLogKvPutLogfmtString(w, field->s, false);
+        default:
+            assert(false && "invalid kv type!");
+            return false;
+    }
+}
+
+// appends one key/value pair - rolled back entirely if it doesn't fit
+static bool acaLogKvPutField(aca_log_kv_writer *w, const aca_log_kv *field, bool json) {
+    size_t start = w->len;
+    bool   ok    = false;
+    if (json) {
+        ok = acaLogKvPutChar(w, ',') && acaLogKvPutJsonString(w, field->key, false) &&
+             acaLogKvPutChar(w, ':') && acaLogKvPutValue(w, field, true);
+    } else {
+        ok = acaLogKvPutChar(w, ' ') && acaLogKvPut(w, field->key, strlen(field->key)) &&
+             acaLogKvPutChar(w, '=') && acaLogKvPutValue(w, field, false);
+    }
+    if (!ok) {
+        w->len  = start;
+        w->full = true;
+    }
+    return ok;
+}
+
+// file path as shown in structured records (honours ACA_LOG_CHOP_FILEPATH)
+static inline const char *acaLogKvFile(const char *file) {
+#if defined(ACA_LOG_CHOP_FILEPATH)
+    const char *leaf = strrchr(file, '/') ? strrchr(file, '/') + 1 : file;
+#if defined(_WIN32)
+    if (leaf == file) {
+        leaf = strrchr(file, '\\') ? strrchr(file, '\\') + 1 : file;
+    }
+#endif // _WIN32
+    return leaf;
+#else
+    return file;
+#endif // ACA_LOG_CHOP_FILEPATH
+}
+
+// encodes a whole structured record (JSON object or logfmt line, newline terminated) into buf -
+// returns its length
+static size_t acaLogKvEncode(char             *buf,
+                             size_t            size,
+                             bool              json,
+                             aca_log_level     level,
+                             const char       *file,
+                             int               line,
+                             const char       *msg,
+                             const aca_log_kv *fields,
+                             size_t            count) {
+    static const char truncatedJson[]   = ",\"truncated\":true";
+    static const char truncatedLogfmt[] = " truncated=true";
+    // reserve room for the truncation marker, closing brace and newline
+    aca_log_kv_writer w = {buf, 0, size - sizeof(truncatedJson) - 2, false};
+    const char       *levelStr;
+    ACA_LOG_SET_LEVEL(level, levelStr);
+
+    if (json) {
+        acaLogKvPutChar(&w, '{');
+#if defined(ACA_LOG_TAG)
+        acaLogKvPut(&w, "\"tag\":", 6);
+        acaLogKvPutJsonString(&w, ACA_LOG_TAG, false);
+        acaLogKvPutChar(&w, ',');
+#endif // ACA_LOG_TAG
+#if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP)
+        acaLogKvPut(&w, "\"ts\":", 5);
+        acaLogKvPutTimestamp(&w, GetTimestamp());
+        acaLogKvPutChar(&w, ',');
+#endif // ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP
+        acaLogKvPut(&w, "\"level\":\"", 9);
+        acaLogKvPut(&w, levelStr, strlen(levelStr));
+        acaLogKvPut(&w, "\",\"file\":", 9);
+        acaLogKvPutJsonString(&w, acaLogKvFile(file), false);
+        acaLogKvPut(&w, ",\"line\":", 8);
+        acaLogKvPutInt(&w, line);
+        acaLogKvPut(&w, ",\"msg\":", 7);
+    } else {
+#if defined(ACA_LOG_TAG)
+        acaLogKvPut(&w, "tag=", 4);
+        acaLogKvPutLogfmtString(&w, ACA_LOG_TAG, false);
+        acaLogKvPutChar(&w, ' ');
+#endif // ACA_LOG_TAG
+#if !defined(ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP)
+        acaLogKvPut(&w, "ts=", 3);
+        acaLogKvPutTimestamp(&w, GetTimestamp());
+        acaLogKvPutChar(&w, ' ');
+#endif // ACA_LOG_DISABLE_STANDARD_HANDLER_TIMESTAMP
+        acaLogKvPut(&w, "level=", 6);
+        acaLogKvPut(&w, levelStr, strlen(levelStr));
+        acaLogKvPut(&w, " file=", 6);
+        acaLogKvPutLogfmtString(&w, acaLogKvFile(file), false);
+        acaLogKvPut(&w, " line=", 6);
+        acaLogKvPutInt(&w, line);
+        acaLogKvPut(&w, " msg=", 5);
+    }
+
+    // the message may be cut short, fields are all-or-nothing
+    // (leave a bit of room so an oversized message doesn't starve every field)
+    bool   truncated = false;
+    size_t msgCap    = w.cap;
+    if (count > 0 && w.cap - w.len > 256) {
+        w.cap -= 128;
+    }
+    if (json) {
+        truncated = !acaLogKvPutJsonString(&w, msg, true);
+    } else {
+        truncated = !acaLogKvPutLogfmtString(&w, msg, true);
+    }
+    w.cap  = msgCap;
+    w.full = false;
+    for (size_t i = 0; (i < count) && !w.full; ++i) {
+        truncated |= !acaLogKvPutField(&w, &fields[i], json);
+    }
+
+    // the reserved tail always fits
+    w.cap  = size;
+    w.full = false;
+    if (truncated) {
+        if (json) {
+            acaLogKvPut(&w, truncatedJson, sizeof(truncatedJson) - 1);
+        } else {
+            acaLogKvPut(&w, truncatedLogfmt, sizeof(truncatedLogfmt) - 1);
+        }
+    }
+    if (json) {
+        acaLogKvPutChar(&w, '}');
+    }
+    acaLogKvPutChar(&w, '\n');
+    return w.len;
+}
+
+// logs a message with key/value fields - the structured handlers encode the fields natively, any
+// other handler gets them appended to the message as logfmt
+void acaLogKv(aca_log_level     level,
+              const char       *file,
+              int               line,
+              const char       *msg,
+              const aca_log_kv *fields,
+              size_t            count) {
+    if ((int)level < ACA_LOG_LEVEL_LOAD()) {
+        return;
+    }
+    aca_log_handler *handler = acaLogGetHandler();
+    if ((handler == acaLogJsonHandler) || (handler == acaLogLogfmtHandler)) {
+        tl_acaLogKvFields = fields;
+        tl_acaLogKvCount  = count;
+        acaLog(level, file, line, "%s", msg);
+        tl_acaLogKvFields = NULL;
+        tl_acaLogKvCount  = 0;
+        return;
+    }
+
+    aca_log_kv_writer w = {tl_acaLogKvBuffer, 0, sizeof(tl_acaLogKvBuffer) - 1, false};
+    for (size_t i = 0; (i < count) && !w.full; ++i) {
+        acaLogKvPutField(&w, &fields[i], false);
+    }
+    w.buf[w.len] = 0;
+    acaLog(level, file, line, "%s%s", msg, tl_acaLogKvBuffer);
+}
+
+// shared by both structured handlers - plain acaLog records become a message without fields
+static void acaLogKvHandlerImpl(bool          json,
+                                aca_log_level level,
+                                const char   *file,
+                                int           line,
+                                const char   *fmt,
+                                va_list       args) {
+    const char *msg = NULL;
+    if ((tl_acaLogKvFields != NULL) || (strcmp(fmt, "%s") == 0)) {
+        msg = va_arg(args, const char *); // already formatted - skip a copy
+    } else {
+        acaLogFormat(tl_acaLogKvBuffer, sizeof(tl_acaLogKvBuffer), fmt, args);
+        msg = tl_acaLogKvBuffer;
+    }
+    size_t len = acaLogKvEncode(tl_acaLogLineBuffer,
+                                sizeof(tl_acaLogLineBuffer),
+                                json,
+                                level,
+                                file,
+                                line,
+                                msg,
+                                tl_acaLogKvFields,
+                                tl_acaLogKvCount);
+    fwrite(tl_acaLogLineBuffer, 1, len, stdout);
+}
+
+// one JSON object per line (JSON Lines) to stdout
+ACA_LOG_HANDLER(acaLogJsonHandler) {
+    acaLogKvHandlerImpl(true, level, file, line, fmt, args);
+}
+
+// one logfmt line to stdout
+ACA_LOG_HANDLER(acaLogLogfmtHandler) {
+    acaLogKvHandlerImpl(false, level, file, line, fmt, args);
+}
+
+// tracing - events are staged per thread as raw ticks (file/name pointers and a short message for
+// instant events) and only converted to JSON when a staging buffer is handed to the file
+typedef struct aca_log_trace_event {
+    uint64_t       ticks;
+    const char    *name;   // span/counter name, source file for instant events
+    double         value;  // counter value
+    int            line;   // instant events
+    char           phase;  // 'B', 'E', 'C' or 'i'
+    unsigned char  level;  // instant events
+    unsigned short msgLen; // instant events - message bytes follow the event
+} aca_log_trace_event;
+
+// every live staging buffer is in a registry so flush/close can reach the events other threads
+// still hold, busy keeps the owner's appends and those flushes apart
+typedef struct aca_log_trace_buffer {
+    struct aca_log_trace_buffer *next;
+    volatile size_t              busy;
+    size_t                       used;
+    unsigned int                 tid;
+    unsigned char                data[ACA_LOG_TRACE_BUFFER_SIZE];
+} aca_log_trace_buffer;
+
+static struct {
+    aca_log_mutex   lock;
+    FILE           *fp;
+    unsigned long   pid;
+    bool            opened; // a trace was opened at least once - the handler only opens the first
+    volatile size_t nextTid;
+} gAcaLogTrace = {ACA_LOG_MUTEX_INIT};
+
+volatile int gAcaLogTraceEnabled = 0;
+
+// lock order: gAcaLogTraceBuffersLock -> buffer busy -> gAcaLogTrace.lock
+static aca_log_mutex         gAcaLogTraceBuffersLock = ACA_LOG_MUTEX_INIT;
+static aca_log_trace_buffer *gAcaLogTraceBuffers     = NULL;
+
+static THREAD_LOCAL aca_log_trace_buffer *tl_acaLogTraceBuffer = NULL;
+
+// one trace-event object, comma and newline terminated (the JSON array is closed on close)
+static size_t acaLogTraceEncode(char                      *buf,
+                                size_t                     size,
+                                const aca_log_trace_event *event,
+                                const char                *msg,
+                                unsigned int               tid) {
+    aca_log_kv_writer w = {buf, 0, size - 256, false}; // the tail after the name always fits
+    acaLogKvPut(&w, "{\"name\":", 8);
+    if (event->phase == 'i') {
+        char   text[ACA_LOG_TRACE_MSG_SIZE + 1];
+        size_t len = (event->msgLen < ACA_LOG_TRACE_MSG_SIZE) ? event->msgLen
+                                                              : ACA_LOG_TRACE_MSG_SIZE;
+        memcpy(text, msg, len);
+        text[len] = 0;
+        acaLogKvPutJsonString(&w, text, true);
+    } else {
+        acaLogKvPutJsonString(&w, event->name, true);
+    }
+
+    w.cap  = size;
+    w.full = false;
+    acaLogKvPut(&w, ",\"ph\":\"", 7);
+    acaLogKvPutChar(&w, event->phase);
+    acaLogKvPut(&w, "\",\"ts\":", 7);
+    acaLogKvPutDouble(&w, acaLogClockSeconds(event->ticks) * 1000000.0);
+    acaLogKvPut(&w, ",\"pid\":", 7);
+    acaLogKvPutUint(&w, gAcaLogTrace.pid);
+    acaLogKvPut(&w, ",\"tid\":", 7);
+    acaLogKvPutUint(&w, tid);
+    if (event->phase == 'C') {
+        acaLogKvPut(&w, ",\"args\":{\"value\":", 17);
+        acaLogKvPutDouble(&w, event->value);
+        acaLogKvPutChar(&w, '}');
+    } else if (event->phase == 'i') {
+        const char *levelStr;
+        ACA_LOG_SET_LEVEL((aca_log_level)event->level, levelStr);
+        acaLogKvPut(&w, ",\"s\":\"t\",\"args\":{\"level\":\"", 26);
+        acaLogKvPut(&w, levelStr, strlen(levelStr));
+        acaLogKvPut(&w, "\",\"file\":", 9);
+        w.cap = size - 32; // keep room for the line and the closing braces
+        acaLogKvPutJsonString(&w, acaLogKvFile(event->name), true);
+        w.cap  = size;
+        w.full = false;
+        acaLogKvPut(&w, ",\"line\":", 8);
+        acaLogKvPutInt(&w, event->line);
+        acaLogKvPutChar(&w, '}');
+    }
+    acaLogKvPut(&w, "},\n", 3);
+    return w.len;
+}
+
+static inline void acaLogTraceBufferLock(aca_log_trace_buffer *buffer) {
+    while (acaLogAtomicExchange(&buffer->busy, 1) != 0) {
+        acaLogThreadYield();
+    }
+}
+
+static inline void acaLogTraceBufferUnlock(aca_log_trace_buffer *buffer) {
+    acaLogAtomicStore(&buffer->busy, 0);
+}
+
+// the caller holds the buffer's busy flag (or owns it exclusively)
+static void acaLogTraceFlushBuffer(aca_log_trace_buffer *buffer) {
+    if ((buffer == NULL) || (buffer->used == 0)) {
+        return;
+    }
+    char line[ACA_LOG_TRACE_MSG_SIZE + 768];
+    acaLogMutexLock(&gAcaLogTrace.lock);
+    if (gAcaLogTrace.fp != NULL) {
+        for (size_t offset = 0; offset < buffer->used;) {
+            aca_log_trace_event event;
+            memcpy(&event, &buffer->data[offset], sizeof(event));
+            const char *msg = (const char *)&buffer->data[offset + sizeof(event)];
+            size_t      len = acaLogTraceEncode(line, sizeof(line), &event, msg, buffer->tid);
+            fwrite(line, 1, len, gAcaLogTrace.fp);
+            offset += sizeof(event) + event.msgLen;
+        }
+    }
+    acaLogMutexUnlock(&gAcaLogTrace.lock);
+    buffer->used = 0;
+}
+
+#ifndef _WIN32
+static pthread_key_t  gAcaLogTraceKey;
+static pthread_once_t gAcaLogTraceKeyOnce = PTHREAD_ONCE_INIT;
+
+// thread exit hook - hands the exiting thread's staged events to the file
+static void acaLogTraceThreadExit(void *arg) {
+    aca_log_trace_buffer *buffer = (aca_log_trace_buffer *)arg;
+    acaLogMutexLock(&gAcaLogTraceBuffersLock);
+    aca_log_trace_buffer **link = &gAcaLogTraceBuffers;
+    while ((*link != NULL) && (*link != buffer)) {
+        link = &(*link)->next;
+    }
+    if (*link != NULL) {
+        *link = buffer->next;
+    }
+    acaLogMutexUnlock(&gAcaLogTraceBuffersLock);
+    acaLogTraceFlushBuffer(buffer);
+    free(buffer);
+}
+static void acaLogTraceKeyCreate(void) {
+    pthread_key_create(&gAcaLogTraceKey, acaLogTraceThreadExit);
+}
+#endif // _WIN32
+
+static aca_log_trace_buffer *acaLogTraceGetBuffer(void) {
+    if (tl_acaLogTraceBuffer == NULL) {
+        tl_acaLogTraceBuffer = (aca_log_trace_buffer *)malloc(sizeof(aca_log_trace_buffer));
+        if (tl_acaLogTraceBuffer == NULL) {
+            return NULL;
+        }
+        tl_acaLogTraceBuffer->busy = 0;
+        tl_acaLogTraceBuffer->used = 0;
+        tl_acaLogTraceBuffer->tid  = (unsigned int)acaLogAtomicAdd(&gAcaLogTrace.nextTid, 1) + 1;
+        acaLogMutexLock(&gAcaLogTraceBuffersLock);
+        tl_acaLogTraceBuffer->next = gAcaLogTraceBuffers;
+        gAcaLogTraceBuffers        = tl_acaLogTraceBuffer;
+        acaLogMutexUnlock(&gAcaLogTraceBuffersLock);
+#ifndef _WIN32
+        pthread_once(&gAcaLogTraceKeyOnce, acaLogTraceKeyCreate);
+        pthread_setspecific(gAcaLogTraceKey, tl_acaLogTraceBuffer);
+#endif // _WIN32
+    }
+    return tl_acaLogTraceBuffer;
+}
+
+static void acaLogTraceRecord(char          phase,
+                              const char   *name,
+                              double        value,
+                              aca_log_level level,
+                              int           line,
+                              const char   *msg,
+                              size_t        msgLen) {
+    aca_log_trace_buffer *buffer = acaLogTraceGetBuffer();
+    if (buffer == NULL) {
+        return;
+    }
+    msgLen = (msgLen < ACA_LOG_TRACE_MSG_SIZE) ? msgLen : ACA_LOG_TRACE_MSG_SIZE;
+    acaLogTraceBufferLock(buffer);
+    if (ACA_LOG_TRACE_BUFFER_SIZE - buffer->used < sizeof(aca_log_trace_event) + msgLen) {
+        acaLogTraceFlushBuffer(buffer);
+    }
+    aca_log_trace_event event;
+    event.ticks  = acaLogClockTicks();
+    event.name   = name;
+    event.value  = value;
+    event.line   = line;
+    event.phase  = phase;
+    event.level  = (unsigned char)level;
+    event.msgLen = (unsigned short)msgLen;
+    memcpy(&buffer->data[buffer->used], &event, sizeof(event));
+    if (msgLen != 0) {
+        memcpy(&buffer->data[buffer->used + sizeof(event)], msg, msgLen);
+    }
+    buffer->used += sizeof(event) + msgLen;
+    acaLogTraceBufferUnlock(buffer);
+}
+
+// hands every thread's staged events to the current file
+static void acaLogTraceFlushBuffers(void) {
+    acaLogMutexLock(&gAcaLogTraceBuffersLock);
+    aca_log_trace_buffer *buffer = gAcaLogTraceBuffers;
+    for (; buffer != NULL; buffer = buffer->next) {
+        acaLogTraceBufferLock(buffer);
+        acaLogTraceFlushBuffer(buffer);
+        acaLogTraceBufferUnlock(buffer);
+    }
+    acaLogMutexUnlock(&gAcaLogTraceBuffersLock);
+}
+
+// names the process and closes the JSON array
+static void acaLogTraceCloseLocked(void) {
+    gAcaLogTraceEnabled = 0;
+    if (gAcaLogTrace.fp != NULL) {
+#if defined(ACA_LOG_TAG)
+        const char *processName = ACA_LOG_TAG;
+#else
+        const char *processName = "aca_log";
+#endif // ACA_LOG_TAG
+        fprintf(gAcaLogTrace.fp,
+                "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,"
+                "\"args\":{\"name\":\"%s\"}}\n]\n",
+                gAcaLogTrace.pid,
+                processName);
+        fclose(gAcaLogTrace.fp);
+        gAcaLogTrace.fp = NULL;
+    }
+}
+
+static int acaLogTraceOpenLocked(const char *path) {
+    static bool registeredAtExit = false;
+    acaLogTraceCloseLocked();
+    gAcaLogTrace.opened = true;
+    gAcaLogTrace.fp     = fopen((path != NULL) ? path : "trace.json", "w");
+    if (gAcaLogTrace.fp == NULL) {
+        return -1;
+    }
+#if defined(_WIN32)
+    gAcaLogTrace.pid = (unsigned long)GetCurrentProcessId();
+#else
+    gAcaLogTrace.pid = (unsigned long)getpid();
+#endif // _WIN32
+    fputs("[\n", gAcaLogTrace.fp);
+    gAcaLogTraceEnabled = 1;
+    if (!registeredAtExit) {
+        atexit(acaLogTraceClose);
+        registeredAtExit = true;
+    }
+    return 0;
+}
+
+// starts a trace file (JSON array format), closing the current one first - spans and counters are
+// dropped while no trace is open, the trace handler opens trace.json on its first record
+int acaLogTraceOpen(const char *path) {
+    acaLogTraceFlushBuffers();
+    acaLogMutexLock(&gAcaLogTrace.lock);
+    int ret = acaLogTraceOpenLocked(path);
+    acaLogMutexUnlock(&gAcaLogTrace.lock);
+    return ret;
+}
+
+// hands every thread's staged events to the file and flushes it
+void acaLogTraceFlush(void) {
+    acaLogTraceFlushBuffers();
+    acaLogMutexLock(&gAcaLogTrace.lock);
+    if (gAcaLogTrace.fp != NULL) {
+        fflush(gAcaLogTrace.fp);
+    }
+    acaLogMutexUnlock(&gAcaLogTrace.lock);
+}
+
+// writes out every thread's staged events and closes the JSON array
+void acaLogTraceClose(void) {
+    acaLogTraceFlushBuffers();
+    acaLogMutexLock(&gAcaLogTrace.lock);
+    acaLogTraceCloseLocked();
+    acaLogMutexUnlock(&gAcaLogTrace.lock);
+}
+
+// the handler's lazy open - checked and done under the lock so racing first records can't
+// truncate a trace another thread just started, and never repeated after a close
+static void acaLogTraceOpenOnce(void) {
+    acaLogMutexLock(&gAcaLogTrace.lock);
+    int ret = gAcaLogTrace.opened ? 0 : acaLogTraceOpenLocked(NULL);
+    acaLogMutexUnlock(&gAcaLogTrace.lock);
+    if (ret != 0) {
+        assert(false && "failed to open trace file!");
+    }
+}
+
+void acaLogTraceBegin(const char *name) {
+    if (gAcaLogTraceEnabled) {
+        acaLogTraceRecord('B', name, 0.0, ACA_LOG_TRACE, 0, NULL, 0);
+    }
+}
+
+void acaLogTraceEnd(const char *name) {
+    if (gAcaLogTraceEnabled) {
+        acaLogTraceRecord('E', name, 0.0, ACA_LOG_TRACE, 0, NULL, 0);
+    }
+}
+
+void acaLogTraceCounter(const char *name, double value) {
+    if (gAcaLogTraceEnabled) {
+        acaLogTraceRecord('C', name, value, ACA_LOG_TRACE, 0, NULL, 0);
+    }
+}
+
+// log records become thread-scoped instant events on the trace timeline
+ACA_LOG_HANDLER(acaLogTraceHandler) {
+    if (!gAcaLogTraceEnabled) {
+        acaLogTraceOpenOnce();
+    }
+    char msg[ACA_LOG_TRACE_MSG_SIZE + 1];
+    int  len = acaLogFormat(msg, sizeof(msg), fmt, args);
+    if (len < 0) {
+        return;
+    }
+    acaLogTraceRecord('i', file, 0.0, level, line, msg, strlen(msg)); // msg may be truncated
+}
+
+// flight recorder internals - one ring per thread, linked into a global list that is only ever
+// pushed to (rings of exited threads are handed to new threads). each slot is a tiny seqlock so a
+// dump running while the owner keeps logging skips the slot being overwritten
+typedef struct aca_log_flight_slot {
+    volatile size_t seq;   // 2n+1 while record n is being written, 2n+2 once it is complete
+    uint64_t        ticks; // converted when the rings are dumped
+    aca_log_level   level;
+    const char     *file;
+    int             line;
+    size_t          msgLen;
+    char            msg[ACA_LOG_FLIGHT_MSG_SIZE];
+} aca_log_flight_slot;
+
+typedef struct aca_log_flight_ring {
+    struct aca_log_flight_ring *next;
+    unsigned int                id;
+    volatile size_t             owned;
+    void                       *altStack; // signal stack of the owning thread (POSIX)
+    volatile size_t             head;     // records written so far
+    size_t                      cursor;   // dump merge position
+    size_t                      dumpHead; // head snapshot taken by the dump
+    aca_log_flight_slot         slots[ACA_LOG_FLIGHT_RECORDS];
+} aca_log_flight_ring;
+
+static struct {
+    aca_log_flight_config         config;
+    aca_log_flight_ring *volatile rings;
+    volatile size_t               ringCount;
+    volatile size_t               dumping;
+    char                          line[ACA_LOG_FLIGHT_MSG_SIZE + 128];
+} gAcaLogFlight = {ACA_LOG_FLIGHT_CONFIG_INIT};
+
+static THREAD_LOCAL aca_log_flight_ring *tl_acaLogFlightRing = NULL;
+
+#ifndef _WIN32
+#define ACA_LOG_FLIGHT_ALT_STACK_SIZE ((SIGSTKSZ > 65536) ? (size_t)SIGSTKSZ : (size_t)65536)
+
+static pthread_key_t  gAcaLogFlightKey;
+static pthread_once_t gAcaLogFlightKeyOnce = PTHREAD_ONCE_INIT;
+
+// thread exit hook - the ring (and its records) stays around for the next thread to reuse, along
+// with its signal stack
+static void acaLogFlightThreadExit(void *arg) {
+    aca_log_flight_ring *ring = (aca_log_flight_ring *)arg;
+    stack_t              current;
+    if ((sigaltstack(NULL, &current) == 0) && (current.ss_sp == ring->altStack) &&
+        !(current.ss_flags & SS_ONSTACK)) {
+        stack_t disable;
+        memset(&disable, 0, sizeof(disable));
+        disable.ss_flags = SS_DISABLE;
+        sigaltstack(&disable, NULL);
+    }
+    acaLogAtomicStore(&ring->owned, 0);
+}
+static void acaLogFlightKeyCreate(void) {
+    pthread_key_create(&gAcaLogFlightKey, acaLogFlightThreadExit);
+}
+
+// the fatal signal handlers run on an alternate stack so a stack overflow can still be dumped -
+// installed for every recording thread that doesn't have one yet
+static void acaLogFlightAltStack(aca_log_flight_ring *ring) {
+    stack_t current;
+    if (!gAcaLogFlight.config.signalHandler || (sigaltstack(NULL, &current) != 0) ||
+        !(current.ss_flags & SS_DISABLE)) {
+        return;
+    }
+    if (ring->altStack == NULL) {
+        ring->altStack = malloc(ACA_LOG_FLIGHT_ALT_STACK_SIZE);
+        if (ring->altStack == NULL) {
+            return;
+        }
+    }
+    stack_t stack;
+    memset(&stack, 0, sizeof(stack));
+    stack.ss_sp   = ring->altStack;
+    stack.ss_size = ACA_LOG_FLIGHT_ALT_STACK_SIZE;
+    sigaltstack(&stack, NULL);
+}
+#else
+static volatile size_t gAcaLogFlightFls = 0; // FLS index + 1
+
+// thread exit hook (fiber local storage callbacks also run when a thread exits)
+static void WINAPI acaLogFlightThreadExit(void *ring) {
+    if (ring != NULL) {
+        acaLogAtomicStore(&((aca_log_flight_ring *)ring)->owned, 0);
+    }
+}
+#endif // _WIN32
+
+static aca_log_flight_ring *acaLogFlightGetRing(void) {
+    if (tl_acaLogFlightRing != NULL) {
+        return tl_acaLogFlightRing;
+    }
+    aca_log_flight_ring *ring =
+        (aca_log_flight_ring *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogFlight.rings);
+    for (; ring != NULL; ring = ring->next) {
+        if (acaLogAtomicCas(&ring->owned, 0, 1)) {
+            break;
+        }
+    }
+    if (ring == NULL) {
+        ring = (aca_log_flight_ring *)calloc(1, sizeof(aca_log_flight_ring));
+        if (ring == NULL) {
+            return NULL;
+        }
+        ring->owned = 1;
+        ring->id    = (unsigned int)acaLogAtomicAdd(&gAcaLogFlight.ringCount, 1);
+        do {
+            ring->next =
+                (aca_log_flight_ring *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogFlight.rings);
+        } while (!acaLogAtomicCasPtr((void *volatile *)&gAcaLogFlight.rings, ring->next, ring));
+    }
+#ifndef _WIN32
+    pthread_once(&gAcaLogFlightKeyOnce, acaLogFlightKeyCreate);
+    pthread_setspecific(gAcaLogFlightKey, ring);
+    acaLogFlightAltStack(ring);
+#else
+    if (acaLogAtomicLoad(&gAcaLogFlightFls) == 0) {
+        DWORD index = FlsAlloc(acaLogFlightThreadExit);
+        if ((index != FLS_OUT_OF_INDEXES) &&
+            !acaLogAtomicCas(&gAcaLogFlightFls, 0, (size_t)index + 1)) {
+            FlsFree(index);
+        }
+    }
+    if (acaLogAtomicLoad(&gAcaLogFlightFls) != 0) {
+        FlsSetValue((DWORD)(acaLogAtomicLoad(&gAcaLogFlightFls) - 1), ring);
+    }
+#endif // _WIN32
+    tl_acaLogFlightRing = ring;
+    return ring;
+}
+
+// async-signal-safe write of the whole buffer
+static void acaLogFlightWrite(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+#ifdef _WIN32
+        int n = _write(fd, buf, (unsigned int)len);
+#else
+        ssize_t n = write(fd, buf, len);
+#endif // _WIN32
+        if (n <= 0) {
+            return;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+// writes every ring's records to fd, oldest first across all threads - only uses memory copies and
+// write(), so it is safe to call from a signal handler. returns the number of records written
+// (concurrent dumps are skipped)
+size_t acaLogFlightDump(int fd) {
+    static const char header[] = "---- flight recorder ----\n";
+    static const char footer[] = "---- flight recorder end ----\n";
+    if (!acaLogAtomicCas(&gAcaLogFlight.dumping, 0, 1)) {
+        return 0;
+    }
+    aca_log_flight_ring *rings =
+        (aca_log_flight_ring *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogFlight.rings);
+    for (aca_log_flight_ring *ring = rings; ring != NULL; ring = ring->next) {
+        ring->dumpHead = acaLogAtomicLoad(&ring->head);
+        ring->cursor =
+            (ring->dumpHead > ACA_LOG_FLIGHT_RECORDS) ? ring->dumpHead - ACA_LOG_FLIGHT_RECORDS : 0;
+    }
+    acaLogFlightWrite(fd, header, sizeof(header) - 1);
+
+    size_t count = 0;
+    while (1) {
+        // k-way merge - each ring is already in timestamp order
+        aca_log_flight_ring *next = NULL;
+        for (aca_log_flight_ring *ring = rings; ring != NULL; ring = ring->next) {
+            if ((ring->cursor < ring->dumpHead) &&
+                ((next == NULL) ||
+                 (ring->slots[ring->cursor % ACA_LOG_FLIGHT_RECORDS].ticks <
+                  next->slots[next->cursor % ACA_LOG_FLIGHT_RECORDS].ticks))) {
+                next = ring;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        size_t               index = next->cursor++;
+        aca_log_flight_slot *slot  = &next->slots[index % ACA_LOG_FLIGHT_RECORDS];
+        size_t               seq   = 2 * index + 2;
+        if (acaLogAtomicLoad(&slot->seq) != seq) {
+            continue; // overwritten since the snapshot
+        }
+
+        // [timestamp] [tN] [LEVEL] [file:line] msg
+        const char       *levelStr;
+        aca_log_kv_writer w = {gAcaLogFlight.line, 0, sizeof(gAcaLogFlight.line) - 1, false};
+        ACA_LOG_SET_LEVEL(slot->level, levelStr);
+        acaLogKvPutChar(&w, '[');
+        acaLogKvPutTimestamp(&w, acaLogClockSeconds(slot->ticks));
+        acaLogKvPut(&w, "] [t", 4);
+        acaLogKvPutUint(&w, next->id);
+        acaLogKvPut(&w, "] [", 3);
+        acaLogKvPut(&w, levelStr, strlen(levelStr));
+        acaLogKvPut(&w, "] [", 3);
+        acaLogKvPut(&w, acaLogKvFile(slot->file), strlen(acaLogKvFile(slot->file)));
+        acaLogKvPutChar(&w, ':');
+        acaLogKvPutInt(&w, slot->line);
+        acaLogKvPut(&w, "] ", 2);
+        acaLogKvPut(&w, slot->msg, (slot->msgLen < sizeof(slot->msg)) ? slot->msgLen : 0);
+        acaLogAtomicFenceAcquire(); // the copies above complete before seq is checked again
+        if (acaLogAtomicLoad(&slot->seq) != seq) {
+            continue; // torn by the owner thread while copying
+        }
+        w.buf[w.len++] = '\n';
+        acaLogFlightWrite(fd, w.buf, w.len);
+        ++count;
+    }
+
+    acaLogFlightWrite(fd, footer, sizeof(footer) - 1);
+    acaLogAtomicStore(&gAcaLogFlight.dumping, 0);
+    return count;
+}
+
+static void acaLogFlightSignalHandler(int sig) {
+    acaLogFlightDump(gAcaLogFlight.config.fd);
+#ifdef _WIN32
+    signal(sig, SIG_DFL);
+#endif // _WIN32
+    raise(sig); // default action (the POSIX handler is installed with SA_RESETHAND)
+}
+
+// configures the flight recorder (the handler works with the defaults as well) - note that records
+// below the runtime level never reach a handler, so lower it (acaLogSetLevel) to record them
+void acaLogFlightStart(const aca_log_flight_config *config) {
+    aca_log_flight_config defaults  = ACA_LOG_FLIGHT_CONFIG_INIT;
+    static const int      signals[] = {
+        SIGSEGV,
+        SIGABRT,
+        SIGFPE,
+        SIGILL,
+#ifndef _WIN32
+        SIGBUS,
+#endif // _WIN32
+    };
+    gAcaLogFlight.config = config ? *config : defaults;
+    if (!gAcaLogFlight.config.signalHandler) {
+        return;
+    }
+#ifndef _WIN32
+    aca_log_flight_ring *ring = acaLogFlightGetRing(); // threads recording later get theirs then
+    if (ring != NULL) {
+        acaLogFlightAltStack(ring);
+    }
+#endif // _WIN32
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); ++i) {
+#ifdef _WIN32
+        signal(signals[i], acaLogFlightSignalHandler);
+#else
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = acaLogFlightSignalHandler;
+        action.sa_flags   = SA_RESETHAND | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        sigaction(signals[i], &action, NULL);
+#endif // _WIN32
+    }
+}
+
+// records into the calling thread's ring, forwards records at/above forwardLevel and dumps every
+// ring on FATAL
+ACA_LOG_HANDLER(acaLogFlightHandler) {
+    aca_log_flight_ring *ring = acaLogFlightGetRing();
+    if (ring != NULL) {
+        size_t               index = ring->head;
+        aca_log_flight_slot *slot  = &ring->slots[index % ACA_LOG_FLIGHT_RECORDS];
+        acaLogAtomicStore(&slot->seq, 2 * index + 1);
+        acaLogAtomicFenceRelease(); // a dump that sees the new fields sees the odd seq as well
+        slot->ticks = acaLogClockTicks();
+        slot->level = level;
+        slot->file  = file;
+        slot->line  = line;
+        va_list argsCopy;
+        va_copy(argsCopy, args);
+        int n = acaLogFormat(slot->msg, sizeof(slot->msg), fmt, argsCopy);
+        va_end(argsCopy);
+        slot->msgLen = (n < 0) ? 0 : (size_t)n;
+        if (slot->msgLen >= sizeof(slot->msg)) {
+            slot->msgLen = sizeof(slot->msg) - 1;
+        }
+        acaLogAtomicStore(&slot->seq, 2 * index + 2);
+        acaLogAtomicStore(&ring->head, index + 1);
+    }
+
+    aca_log_handler *forward = gAcaLogFlight.config.forward;
+    if ((forward != NULL) && (forward != acaLogFlightHandler) &&
+        (level >= gAcaLogFlight.config.forwardLevel)) {
+        forward(level, file, line, fmt, args);
+    }
+    if (level == ACA_LOG_FATAL) {
+        acaLogFlightDump(gAcaLogFlight.config.fd);
+    }
+}
+
+// dedup internals - a small table keyed by call site and message hash, probed once per record under
+// a mutex. a slot with repeats owes a summary, paid when its window has passed (checked on the
+// next record), when a different record takes the slot, or on acaLogDedupFlush
+typedef struct aca_log_dedup_slot {
+    const char   *file; // NULL = unused
+    int           line;
+    aca_log_level level;
+    uint64_t      hash;
+    double        first; // first occurrence of the current window
+    double        last;
+    size_t        repeats;
+    size_t        msgLen;
+    char          msg[ACA_LOG_DEDUP_MSG_SIZE];
+} aca_log_dedup_slot;
+
+#define ACA_LOG_DEDUP_SUMMARIES 8 // summaries collected per pass
+
+static struct {
+    aca_log_mutex        lock;
+    aca_log_dedup_config config;
+    double               nextSweep;
+    volatile size_t      suppressed;
+    bool                 registeredAtExit;
+    aca_log_dedup_slot   slots[ACA_LOG_DEDUP_SLOTS];
+} gAcaLogDedup = {ACA_LOG_MUTEX_INIT, ACA_LOG_DEDUP_CONFIG_INIT};
+
+static inline uint64_t acaLogDedupHash(const char *msg, size_t len) {
+    uint64_t hash = 14695981039346656037ULL; // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ (unsigned char)msg[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void acaLogDedupForward(aca_log_handler *forward,
+                               aca_log_level    level,
+                               const char      *file,
+                               int              line,
+                               const char      *fmt,
+                               ...) {
+    va_list args;
+    va_start(args, fmt);
+    forward(level, file, line, fmt, args);
+    va_end(args);
+}
+
+// moves owed summaries into out (expired ones only, unless all is set) - returns how many
+static size_t acaLogDedupCollectLocked(double now, bool all, aca_log_dedup_slot *out, size_t max) {
+    size_t count = 0;
+    for (size_t i = 0; (i < ACA_LOG_DEDUP_SLOTS) && (count < max); ++i) {
+        aca_log_dedup_slot *slot = &gAcaLogDedup.slots[i];
+        if ((slot->repeats != 0) && (all || (now - slot->first >= gAcaLogDedup.config.window))) {
+            out[count++]  = *slot;
+            slot->repeats = 0;
+            slot->first   = -gAcaLogDedup.config.window; // the next occurrence starts a new window
+        }
+    }
+    return count;
+}
+
+static void acaLogDedupSummarize(const aca_log_dedup_slot *slots, size_t count) {
+    aca_log_handler *forward = gAcaLogDedup.config.forward;
+    for (size_t i = 0; i < count; ++i) {
+        acaLogDedupForward(forward,
+                           slots[i].level,
+                           slots[i].file,
+                           slots[i].line,
+                           "%.*s [repeated %lu times over %.3f s]",
+                           (int)slots[i].msgLen,
+                           slots[i].msg,
+                           (unsigned long)slots[i].repeats,
+                           slots[i].last - slots[i].first);
+    }
+}
+
+// registers the exit flush once - called with the lock held
+static void acaLogDedupRegisterLocked(void) {
+    if (!gAcaLogDedup.registeredAtExit) {
+        atexit(acaLogDedupFlush);
+        gAcaLogDedup.registeredAtExit = true;
+    }
+}
+
+// flushes the summaries owed to the previous forward handler and starts with an empty table
+void acaLogDedupStart(const aca_log_dedup_config *config) {
+    aca_log_dedup_config defaults = ACA_LOG_DEDUP_CONFIG_INIT;
+    acaLogDedupFlush();
+    acaLogMutexLock(&gAcaLogDedup.lock);
+    gAcaLogDedup.config    = config ? *config : defaults;
+    gAcaLogDedup.nextSweep = 0.0;
+    memset(gAcaLogDedup.slots, 0, sizeof(gAcaLogDedup.slots));
+    acaLogDedupRegisterLocked();
+    acaLogMutexUnlock(&gAcaLogDedup.lock);
+}
+
+void acaLogDedupFlush(void) {
+    aca_log_dedup_slot owed[ACA_LOG_DEDUP_SUMMARIES];
+    size_t             count;
+    do {
+        acaLogMutexLock(&gAcaLogDedup.lock);
+        count = acaLogDedupCollectLocked(0.0, true, owed, ACA_LOG_DEDUP_SUMMARIES);
+        acaLogMutexUnlock(&gAcaLogDedup.lock);
+        acaLogDedupSummarize(owed, count);
+    } while (count == ACA_LOG_DEDUP_SUMMARIES);
+}
+
+size_t acaLogDedupSuppressed(void) {
+    return acaLogAtomicLoad(&gAcaLogDedup.suppressed);
+}
+
+// repeats only cost a format, a hash and a table probe - no forward handler I/O
+ACA_LOG_HANDLER(acaLogDedupHandler) {
+    aca_log_handler *forward = gAcaLogDedup.config.forward;
+    if ((forward == NULL) || (forward == acaLogDedupHandler)) {
+        return;
+    }
+    if (level >= gAcaLogDedup.config.passLevel) {
+        forward(level, file, line, fmt, args);
+        return;
+    }
+    char    msg[ACA_LOG_LINE_BUFFER_SIZE];
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int n = acaLogFormat(msg, sizeof(msg), fmt, argsCopy);
+    va_end(argsCopy);
+    size_t   msgLen = (n < 0) ? 0 : ((size_t)n < sizeof(msg)) ? (size_t)n : sizeof(msg) - 1;
+    uint64_t hash   = acaLogDedupHash(msg, msgLen);
+    size_t   index  = 0;
+    if (!gAcaLogDedup.config.consecutive) {
+        uint64_t key = hash ^ (uint64_t)(uintptr_t)file ^ ((uint64_t)line * 0x9e3779b97f4a7c15ULL);
+        index        = (size_t)(key ^ (key >> 29)) & (ACA_LOG_DEDUP_SLOTS - 1);
+    }
+
+    aca_log_dedup_slot owed[ACA_LOG_DEDUP_SUMMARIES + 1];
+    size_t             count = 0;
+    double             now   = GetTimestamp();
+    acaLogMutexLock(&gAcaLogDedup.lock);
+    acaLogDedupRegisterLocked(); // without acaLogDedupStart the table is still the zeroed static one
+    aca_log_dedup_slot *slot   = &gAcaLogDedup.slots[index];
+    bool                repeat = (slot->file == file) && (slot->line == line) &&
+                  (slot->level == level) && (slot->hash == hash) &&
+                  (now - slot->first < gAcaLogDedup.config.window);
+    if (repeat) {
+        slot->repeats += 1;
+        slot->last = now;
+    } else {
+        if (slot->repeats != 0) { // a different record (or a new window) takes the slot
+            owed[count++] = *slot;
+        }
+        slot->file    = file;
+        slot->line    = line;
+        slot->level   = level;
+        slot->hash    = hash;
+        slot->first   = now;
+        slot->last    = now;
+        slot->repeats = 0;
+        slot->msgLen  = (msgLen < sizeof(slot->msg)) ? msgLen : sizeof(slot->msg);
+        memcpy(slot->msg, msg, slot->msgLen);
+    }
+    if (now >= gAcaLogDedup.nextSweep) {
+        count += acaLogDedupCollectLocked(now, false, &owed[count], ACA_LOG_DEDUP_SUMMARIES);
+        gAcaLogDedup.nextSweep = now + gAcaLogDedup.config.window;
+    }
+    acaLogMutexUnlock(&gAcaLogDedup.lock);
+
+    acaLogDedupSummarize(owed, count);
+    if (repeat) {
+        acaLogAtomicAdd(&gAcaLogDedup.suppressed, 1);
+    } else {
+        forward(level, file, line, fmt, args);
+    }
+}
+
+// dispatcher internals - readers only load the current sink table, writers (serialized by the
+// mutex) publish a modified copy with one pointer store. replaced tables are retired rather than
+// freed since readers hold no reference to them - sink changes are rare, so they are kept on a
+// list hanging off the live table and never released (not even at exit, where threads that
+// outlive main may still be walking one)
+typedef struct aca_log_sink_entry {
+    aca_log_sink *sink;
+    void         *user;
+    aca_log_level minLevel;
+} aca_log_sink_entry;
+
+typedef struct aca_log_sink_table {
+    struct aca_log_sink_table *retired;  // older tables (only touched under the mutex)
+    aca_log_level              minLevel; // lowest level any sink wants
+    size_t                     count;
+    aca_log_sink_entry         entries[1];
+} aca_log_sink_table;
+
+static struct {
+    aca_log_mutex               lock;
+    aca_log_sink_table *volatile table;
+} gAcaLogSinks = {ACA_LOG_MUTEX_INIT};
+
+// per-thread message buffer for the dispatcher (oversized messages go through a heap buffer)
+static THREAD_LOCAL char tl_acaLogRecordBuffer[ACA_LOG_LINE_BUFFER_SIZE];
+
+// publishes a copy of the current table with the entry matching sink/user added, updated or
+// removed (minLevel < 0) - returns 0 on success, -1 if missing/out of memory
+static int acaLogSinkUpdate(aca_log_sink *sink, void *user, int minLevel, bool add) {
+    acaLogMutexLock(&gAcaLogSinks.lock);
+    aca_log_sink_table *old =
+        (aca_log_sink_table *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogSinks.table);
+    size_t count = old ? old->count : 0;
+    size_t found = count;
+    for (size_t i = 0; i < count; ++i) {
+        if ((old->entries[i].sink == sink) && (old->entries[i].user == user)) {
+            found = i;
+            break;
+        }
+    }
+    if ((found == count) && !add) {
+        acaLogMutexUnlock(&gAcaLogSinks.lock);
+        return -1;
+    }
+
+    size_t              capacity = count + 1;
+    aca_log_sink_table *table    = (aca_log_sink_table *)malloc(
+        sizeof(aca_log_sink_table) + (capacity - 1) * sizeof(aca_log_sink_entry));
+    if (table == NULL) {
+        acaLogMutexUnlock(&gAcaLogSinks.lock);
+        return -1;
+    }
+    table->count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i != found) {
+            table->entries[table->count++] = old->entries[i];
+        } else if (minLevel >= 0) {
+            table->entries[table->count]            = old->entries[i];
+            table->entries[table->count++].minLevel = (aca_log_level)minLevel;
+        }
+    }
+    if (found == count) {
+        table->entries[table->count].sink       = sink;
+        table->entries[table->count].user       = user;
+        table->entries[table->count++].minLevel = (aca_log_level)minLevel;
+    }
+    table->minLevel = ACA_LOG_FATAL;
+    for (size_t i = 0; i < table->count; ++i) {
+        if (table->entries[i].minLevel < table->minLevel) {
+            table->minLevel = table->entries[i].minLevel;
+        }
+    }
+    if (table->count == 0) {
+        table->minLevel = (aca_log_level)(ACA_LOG_FATAL + 1);
+    }
+    table->retired = old;
+    acaLogAtomicStorePtr((void *volatile *)&gAcaLogSinks.table, table);
+    acaLogMutexUnlock(&gAcaLogSinks.lock);
+    return 0;
+}
+
+// registers a sink (or updates the level of an already registered sink/user pair) - returns 0 on
+// success
+int acaLogSinkAdd(aca_log_sink *sink, void *user, aca_log_level minLevel) {
+    assert(sink != NULL && "invalid log sink!");
+    return acaLogSinkUpdate(sink, user, (int)minLevel, true);
+}
+
+// changes the minimum level of a registered sink - returns -1 if it isn't registered
+int acaLogSinkSetLevel(aca_log_sink *sink, void *user, aca_log_level minLevel) {
+    return acaLogSinkUpdate(sink, user, (int)minLevel, false);
+}
+
+// unregisters a sink - returns -1 if it isn't registered
+int acaLogSinkRemove(aca_log_sink *sink, void *user) {
+    return acaLogSinkUpdate(sink, user, -1, false);
+}
+
+// writes a record as a standard log line with a single fwrite
+static void acaLogWriteRecord(FILE *fp, const aca_log_record *record) {
+    size_t prefixLen = acaLogStandardPrefixFormat(tl_acaLogLineBuffer,
+                                                  sizeof(tl_acaLogLineBuffer),
+                                                  fp == stdout,
+                                                  record->level,
+                                                  record->file,
+                                                  record->line,
+                                                  record->timestamp);
+    acaLogWriteLinef(fp, prefixLen, "%.*s", (int)record->msgLen, record->msg);
+}
+
+void acaLogStdoutSink(const aca_log_record *record, void *user) {
+    (void)user;
+    acaLogWriteRecord(stdout, record);
+}
+
+void acaLogFileSink(const aca_log_record *record, void *user) {
+    if (user != NULL) {
+        acaLogWriteRecord((FILE *)user, record);
+    }
+}
+
+// formats the message once and hands the record to every sink whose level it meets - with no
+// sinks registered, records go to stdout as with the standard handler
+ACA_LOG_HANDLER(acaLogDispatchHandler) {
+    aca_log_sink_table *table =
+        (aca_log_sink_table *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogSinks.table);
+    if (table == NULL) {
+        acaLogStandardHandler(level, file, line, fmt, args);
+        return;
+    }
+    if (level < table->minLevel) {
+        return; // nobody wants it - skip formatting
+    }
+
+    aca_log_record record;
+    char          *heap = NULL;
+    va_list        argsCopy;
+    va_copy(argsCopy, args);
+    int n = acaLogFormat(tl_acaLogRecordBuffer, sizeof(tl_acaLogRecordBuffer), fmt, args);
+
+    record.level     = level;
+    record.file      = file;
+    record.line      = line;
+    record.timestamp = GetTimestamp();
+    record.msg       = tl_acaLogRecordBuffer;
+    record.msgLen    = (n > 0) ? (size_t)n : 0;
+    if (record.msgLen >= sizeof(tl_acaLogRecordBuffer)) {
+        heap = (char *)malloc(record.msgLen + 1);
+        if (heap != NULL) {
+            acaLogFormat(heap, record.msgLen + 1, fmt, argsCopy);
+            record.msg = heap;
+        } else {
+            record.msgLen = sizeof(tl_acaLogRecordBuffer) - 1;
+        }
+    }
+    va_end(argsCopy);
+
+    for (size_t i = 0; i < table->count; ++i) {
+        if (level >= table->entries[i].minLevel) {
+            table->entries[i].sink(&record, table->entries[i].user);
+        }
+    }
+    free(heap);
+}
+
+// call site registry - sites are pushed onto a lock-free list on their first call and never
+// removed. enable/disable rules are kept so sites that haven't run yet pick them up on registration
+typedef struct aca_log_site_rule {
+    char file[128];
+    int  line; // 0 = every line of the file
+    int  enabled;
+} aca_log_site_rule;
+
+static struct {
+    aca_log_mutex          lock;
+    aca_log_site *volatile sites;
+    aca_log_site_rule      rules[ACA_LOG_SITE_RULES];
+    size_t                 ruleCount;
+} gAcaLogSites = {ACA_LOG_MUTEX_INIT};
+
+// matches file against the site's path - a full path, or any trailing part of it ("net/rx.c")
+static bool acaLogSiteMatches(const aca_log_site *site, const char *file, int line) {
+    size_t siteLen = strlen(site->file);
+    size_t fileLen = strlen(file);
+    if (((line != 0) && (line != site->line)) || (fileLen > siteLen) ||
+        (strcmp(&site->file[siteLen - fileLen], file) != 0)) {
+        return false;
+    }
+    return (fileLen == siteLen) || (site->file[siteLen - fileLen - 1] == '/') ||
+           (site->file[siteLen - fileLen - 1] == '\\');
+}
+
+static void acaLogSiteRegister(aca_log_site *site, const char *fmt) {
+    if (!acaLogAtomicCas(&site->state, 0, 1)) {
+        return; // another thread is registering it
+    }
+    site->fmt = fmt;
+#if defined(ACA_LOG_CHOP_FILEPATH)
+    if (site->fileName == NULL) {
+        const char *leaf = strrchr(site->file, '/') ? strrchr(site->file, '/') + 1 : site->file;
+#if defined(_WIN32)
+        if (leaf == site->file) {
+            leaf = strrchr(site->file, '\\') ? strrchr(site->file, '\\') + 1 : site->file;
+        }
+#endif // _WIN32
+        site->fileName = leaf;
+    }
+#else
+    site->fileName = site->file;
+#endif // ACA_LOG_CHOP_FILEPATH
+    snprintf(site->fileLine, sizeof(site->fileLine), "%s:%d", site->fileName, site->line);
+
+    acaLogMutexLock(&gAcaLogSites.lock);
+    for (size_t i = 0; i < gAcaLogSites.ruleCount; ++i) {
+        if (acaLogSiteMatches(site, gAcaLogSites.rules[i].file, gAcaLogSites.rules[i].line)) {
+            acaLogAtomicStore(&site->enabled, (size_t)gAcaLogSites.rules[i].enabled);
+        }
+    }
+    site->next = (aca_log_site *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogSites.sites);
+    acaLogAtomicStorePtr((void *volatile *)&gAcaLogSites.sites, site);
+    acaLogMutexUnlock(&gAcaLogSites.lock);
+    acaLogAtomicStore(&site->state, 2);
+}
+
+// log entrypoint for the macros - same as acaLog, with file/line taken from the call site
+void acaLogAt(aca_log_site *site, const char *fmt, ...) {
+    if (acaLogAtomicLoad(&site->state) != 2) {
+        acaLogSiteRegister(site, fmt);
+    }
+    if (((int)site->level < ACA_LOG_LEVEL_LOAD()) || !acaLogAtomicLoad(&site->enabled)) {
+        return;
+    }
+    va_list          args;
+    aca_log_handler *handler = acaLogGetHandler();
+    va_start(args, fmt);
+    assert(handler != NULL && "no log handler set for acaLog!");
+    if (acaLogAtomicLoad(&site->state) == 2) {
+        tl_acaLogSite = site;
+        handler(site->level, site->fileName, site->line, fmt, args);
+        tl_acaLogSite = NULL;
+    } else { // still being registered by another thread
+        handler(site->level, site->file, site->line, fmt, args);
+    }
+    va_end(args);
+}
+
+// returns the most recently registered site (follow site->next for the rest)
+aca_log_site *acaLogSites(void) {
+    return (aca_log_site *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogSites.sites);
+}
+
+// switches the sites of file (full path or trailing part of it) on/off - every line if line is 0.
+// also applies to matching sites that register later. returns the number of registered sites
+// changed, or (size_t)-1 without changing anything if all ACA_LOG_SITE_RULES rules are taken
+size_t acaLogSiteEnable(const char *file, int line, int enabled) {
+    size_t count = 0;
+    acaLogMutexLock(&gAcaLogSites.lock);
+    size_t i = 0;
+    for (; i < gAcaLogSites.ruleCount; ++i) { // replace an identical rule
+        if ((gAcaLogSites.rules[i].line == line) &&
+            (strcmp(gAcaLogSites.rules[i].file, file) == 0)) {
+            break;
+        }
+    }
+    if (i == ACA_LOG_SITE_RULES) {
+        acaLogMutexUnlock(&gAcaLogSites.lock);
+        return (size_t)-1;
+    }
+    snprintf(gAcaLogSites.rules[i].file, sizeof(gAcaLogSites.rules[i].file), "%s", file);
+    gAcaLogSites.rules[i].line    = line;
+    gAcaLogSites.rules[i].enabled = enabled ? 1 : 0;
+    gAcaLogSites.ruleCount += (i == gAcaLogSites.ruleCount) ? 1 : 0;
+    aca_log_site *site = (aca_log_site *)acaLogAtomicLoadPtr((void *volatile *)&gAcaLogSites.sites);
+    for (; site != NULL; site = site->next) {
+        if (acaLogSiteMatches(site, file, line)) {
+            acaLogAtomicStore(&site->enabled, enabled ? 1 : 0);
+            ++count;
+        }
+    }
+    acaLogMutexUnlock(&gAcaLogSites.lock);
+    return count;
+}
+
+// "{}" field of acaLogFormatArgs with the default format for the argument type
+static void acaLogFormatArgDefault(aca_log_format_out *out, const aca_log_arg *arg) {
+    char              tmp[32];
+    char             *end = &tmp[sizeof(tmp)];
+    char             *p   = end;
+    aca_log_kv_writer w   = {tmp, 0, sizeof(tmp), false};
+    switch (arg->type) {
+        case ACA_LOG_ARG_TYPE_INT:
+            p = acaLogFormatDecimal(end, (arg->i < 0) ? 0ULL - (unsigned long long)arg->i
+                                                      : (unsigned long long)arg->i);
+            if (arg->i < 0) {
+                *--p = '-';
+            }
+            acaLogFormatPut(out, p, (size_t)(end - p));
+            break;
+        case ACA_LOG_ARG_TYPE_UINT:
+            p = acaLogFormatDecimal(end, (unsigned long long)arg->i);
+            acaLogFormatPut(out, p, (size_t)(end - p));
+            break;
+        case ACA_LOG_ARG_TYPE_DOUBLE:
+            if ((arg->d != arg->d) || (arg->d > 1.7976931348623157e308) ||
+                (arg->d < -1.7976931348623157e308)) {
+                w.len = (size_t)acaLogFormatf(tmp, sizeof(tmp), "%f", arg->d); // nan, inf
+            } else {
+                acaLogKvPutDouble(&w, arg->d);
+            }
+            acaLogFormatPut(out, tmp, w.len);
+            break;
+        case ACA_LOG_ARG_TYPE_CHAR:
+            tmp[0] = (char)arg->i;
+            acaLogFormatPut(out, tmp, 1);
+            break;
+        case ACA_LOG_ARG_TYPE_BOOL:
+            acaLogFormatPut(out, arg->i ? "true" : "false", arg->i ? 4 : 5);
+            break;
+        case ACA_LOG_ARG_TYPE_STR:
+            if (arg->p == NULL) {
+                acaLogFormatPut(out, "(null)", 6);
+            } else {
+                acaLogFormatPut(out, (const char *)arg->p, arg->len);
+            }
+            break;
+        case ACA_LOG_ARG_TYPE_PTR:
+            w.len = (size_t)acaLogFormatf(tmp, sizeof(tmp), "%p", arg->p);
+            acaLogFormatPut(out, tmp, (w.len < sizeof(tmp)) ? w.len : sizeof(tmp) - 1);
+            break;
+    }
+}
+
+// "{:spec}" field of acaLogFormatArgs - the spec goes through acaLogFormat as "%<spec>", with the
+// length modifier and (if not given) the conversion picked from the argument type. returns false if
+// the conversion doesn't fit the argument
+static bool acaLogFormatArgSpec(aca_log_format_out     *out,
+                                const aca_log_arg      *arg,
+                                const aca_log_fmt_spec *spec,
+                                char                    conv) {
+    char        specFmt[48];
+    size_t      n         = (size_t)acaLogFormatf(specFmt, sizeof(specFmt), "%%%s", spec->flags);
+    bool        isInteger = (arg->type == ACA_LOG_ARG_TYPE_INT) ||
+                     (arg->type == ACA_LOG_ARG_TYPE_UINT) ||
+                     (arg->type == ACA_LOG_ARG_TYPE_CHAR) || (arg->type == ACA_LOG_ARG_TYPE_BOOL);
+    const char *str    = NULL;
+    int         strLen = 0;
+    if (spec->width >= 0) {
+        n += (size_t)acaLogFormatf(&specFmt[n], sizeof(specFmt) - n, "%d", spec->width);
+    }
+    if ((arg->type == ACA_LOG_ARG_TYPE_STR) && ((conv == 0) || (conv == 's'))) {
+        str    = (arg->p != NULL) ? (const char *)arg->p : "(null)";
+        strLen = (arg->p != NULL) ? (int)arg->len : 6;
+        if ((spec->precision >= 0) && (spec->precision < strLen)) {
+            strLen = spec->precision;
+        }
+        conv = 's';
+    } else if ((arg->type == ACA_LOG_ARG_TYPE_BOOL) && ((conv == 0) || (conv == 's'))) {
+        str    = arg->i ? "true" : "false";
+        strLen = arg->i ? 4 : 5;
+        if ((spec->precision >= 0) && (spec->precision < strLen)) {
+            strLen = spec->precision;
+        }
+        conv = 's';
+    } else if (spec->precision >= 0) {
+        n += (size_t)acaLogFormatf(&specFmt[n], sizeof(specFmt) - n, ".%d", spec->precision);
+    }
+
+    size_t room = (out->len < out->size) ? out->size - out->len : 0;
+    char  *dst  = (room > 0) ? &out->buf[out->len] : NULL;
+    size_t size = (room > 0) ? room + 1 : 0; // out->size already keeps a byte for the terminator
+    int    len  = -1;
+    if ((conv == 's') && (str != NULL)) {
+        acaLogFormatf(&specFmt[n], sizeof(specFmt) - n, ".*s");
+        len = acaLogFormatf(dst, size, specFmt, strLen, str);
+    } else if (isInteger && ((conv == 0) || (strchr("diuxXo", conv) != NULL))) {
+        if (conv == 0) {
+            conv = (arg->type == ACA_LOG_ARG_TYPE_INT)    ? 'd'
+                   : (arg->type == ACA_LOG_ARG_TYPE_CHAR) ? 'c'
+                                                          : 'u';
+        }
+        acaLogFormatf(&specFmt[n], sizeof(specFmt) - n, (conv == 'c') ? "c" : "ll%c", conv);
+        len = (conv == 'c') ? acaLogFormatf(dst, size, specFmt, (int)arg->i)
+                            : acaLogFormatf(dst, size, specFmt, arg->i);
+    } else if ((conv == 'c') && isInteger) {
+        acaLogFormatf(&specFmt[n], sizeof(specFmt) - n, "c");
+        len = acaLogFormatf(dst, size, specFmt, (int)arg->i);
+    } else if ((arg->type == ACA_LOG_ARG_TYPE_DOUBLE) &&
+               ((conv == 0) || (strchr("fFeEgGaA", conv) != NULL))) {
+        acaLogFormatf(&specFmt[n], sizeof(specFmt) - n, "%c", (conv != 0) ? conv : 'f');
+        len = acaLogFormatf(dst, size, specFmt, arg->d);
+    } else if (((arg->type == ACA_LOG_ARG_TYPE_PTR) && ((conv == 0) || (conv == 'p'))) ||
+               ((arg->type == ACA_LOG_ARG_TYPE_STR) && (conv == 'p'))) {
+        acaLogFormatf(&specFmt[n], sizeof(specFmt) - n, "p");
+        len = acaLogFormatf(dst, size, specFmt, arg->p);
+    }
+    if (len < 0) {
+        return false;
+    }
+    out->len += (size_t)len;
+    return true;
+}
+
+// renders a "{}" format (see aca_log_arg) - vsnprintf semantics like acaLogFormat. fields without
+// a matching argument are copied as they are
+int acaLogFormatArgs(
+    char *buf, size_t size, const char *fmt, const aca_log_arg *args, size_t count) {
+    aca_log_format_out out   = {buf, (size > 0) ? size - 1 : 0, 0};
+    size_t             index = 0;
+    const char        *p     = fmt;
+    while (*p != 0) {
+        const char *literal = p;
+        while ((*p != 0) && (*p != '{') && (*p != '}')) {
+            ++p;
+        }
+        acaLogFormatPut(&out, literal, (size_t)(p - literal));
+        if (*p == 0) {
+            break;
+        }
+        if ((p[1] == *p) || (*p == '}')) { // "{{", "}}" or a stray '}'
+            acaLogFormatPut(&out, p, 1);
+            p += (p[1] == *p) ? 2 : 1;
+            continue;
+        }
+
+        const char *field = p;
+        const char *close = strchr(field, '}');
+        if (close == NULL) {
+            acaLogFormatPut(&out, field, strlen(field));
+            break;
+        }
+        p = close + 1;
+        if ((index < count) && (field[1] == '}')) {
+            acaLogFormatArgDefault(&out, &args[index++]);
+            continue;
+        }
+        if ((index < count) && (field[1] == ':')) {
+            aca_log_fmt_spec spec;
+            const char      *specEnd = acaLogParseFmtSpec(&field[2], &spec);
+            char             conv    = spec.conv;
+            if (conv == '}') { // no conversion given
+                conv = 0;
+                --specEnd;
+            }
+            if ((specEnd == close) && !spec.widthStar && !spec.precisionStar &&
+                (spec.length[0] == 0) && acaLogFormatArgSpec(&out, &args[index], &spec, conv)) {
+                ++index;
+                continue;
+            }
+        }
+        acaLogFormatPut(&out, field, (size_t)(p - field));
+    }
+    if (size > 0) {
+        buf[(out.len < out.size) ? out.len : out.size] = 0;
+    }
+    return (int)out.len;
+}
+
+// per-thread buffer for rendered "{}" messages
+static THREAD_LOCAL char tl_acaLogArgsBuffer[ACA_LOG_LINE_BUFFER_SIZE];
+
+// returns the rendered message (the args buffer, or a heap buffer for oversized ones that must be
+// freed)
+static char *acaLogArgsMessage(const char *fmt, const aca_log_arg *args, size_t count) {
+    int n = acaLogFormatArgs(tl_acaLogArgsBuffer, sizeof(tl_acaLogArgsBuffer), fmt, args, count);
+    if ((n > 0) && ((size_t)n >= sizeof(tl_acaLogArgsBuffer))) {
+        char *heap = (char *)malloc((size_t)n + 1);
+        if (heap != NULL) {
+            acaLogFormatArgs(heap, (size_t)n + 1, fmt, args, count);
+            return heap;
+        }
+    }
+    return tl_acaLogArgsBuffer;
+}
+
+// log entrypoint for "{}" formats - the message is rendered once and handed to the handler as "%s"
+void acaLogArgs(aca_log_level      level,
+                const char        *file,
+                int                line,
+                const char        *fmt,
+                const aca_log_arg *args,
+                size_t             count) {
+    if ((int)level < ACA_LOG_LEVEL_LOAD()) {
+        return;
+    }
+    char *msg = acaLogArgsMessage(fmt, args, count);
+    acaLog(level, file, line, "%s", msg);
+    if (msg != tl_acaLogArgsBuffer) {
+        free(msg);
+    }
+}
+
+// same as acaLogArgs for ACA_LOG_FMT call sites (the site registers with the "{}" format)
+void acaLogArgsAt(aca_log_site *site, const char *fmt, const aca_log_arg *args, size_t count) {
+    if (acaLogAtomicLoad(&site->state) != 2) {
+        acaLogSiteRegister(site, fmt);
+    }
+    if (((int)site->level < ACA_LOG_LEVEL_LOAD()) || !acaLogAtomicLoad(&site->enabled)) {
+        return;
+    }
+    char *msg = acaLogArgsMessage(fmt, args, count);
+    acaLogAt(site, "%s", msg);
+    if (msg != tl_acaLogArgsBuffer) {
+        free(msg);
+    }
+}
+
 #endif // ACA_LOG_IMPLEMENTATION
 
 #endif // ACA_LOG_H
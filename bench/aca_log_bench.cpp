@@ -0,0 +1,418 @@
+// per-call latency (p50/p99/max) and throughput of the aca_log handlers across message sizes,
+// argument counts and thread counts - records go to /dev/null, a tmpfs file or a pipe
+#define ACA_LOG_CHOP_FILEPATH
+#define ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS
+#define ACA_LOG_IMPLEMENTATION
+#include "aca_log.h"
+#define ACA_ARGPARSE_IMPLEMENTATION
+#include "aca_argparse.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock bench_clock;
+
+struct BenchHandler {
+    const char      *name;
+    aca_log_handler *handler;
+};
+
+static const BenchHandler g_handlers[] = {
+    {"standard", acaLogStandardHandler},
+    {"basic", acaLogBasicHandler},
+    {"null", acaLogNullHandler},
+    {"standard_file", acaLogStandardFileHandler},
+    {"buffered_file", acaLogBufferedFileHandler},
+    {"async", acaLogAsyncHandler},
+    {"lz", acaLogLzHandler},
+    {"net", acaLogNetHandler},
+    {"shm", acaLogShmHandler},
+};
+
+static const char *g_dests[] = {"null", "tmpfs", "pipe"};
+
+struct BenchResult {
+    double   callsPerSec;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t max;
+};
+
+static FILE       *g_out = NULL; // results (stdout itself is redirected to the destination)
+static std::string g_dir;        // scratch dir - the handlers' dump.log lives here
+
+// drains the read end of a pipe (or a FIFO that gets reopened by the standard file handler)
+struct PipeDrain {
+    std::atomic<bool> done;
+    std::thread       thread;
+};
+
+static void DrainFd(int fd, PipeDrain *drain) {
+    char buffer[64 * 1024];
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+    (void)drain;
+}
+
+static void DrainFifo(const std::string &path, PipeDrain *drain) {
+    while (!drain->done.load()) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        DrainFd(fd, drain);
+        close(fd);
+    }
+}
+
+// stand-in collector for the net handler - a Unix datagram socket drained by a thread
+struct NetReceiver {
+    int               fd;
+    std::atomic<bool> done;
+    std::thread       thread;
+};
+
+static NetReceiver *StartReceiver(const std::string &address) {
+    NetReceiver *receiver = new NetReceiver();
+    receiver->fd          = acaLogNetBind(address.c_str());
+    receiver->done        = false;
+    struct timeval timeout = {0, 100000}; // lets the drain thread notice done
+    setsockopt(receiver->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    receiver->thread = std::thread([receiver]() {
+        static char buffer[65536];
+        while (!receiver->done.load()) {
+            recv(receiver->fd, buffer, sizeof(buffer), 0);
+        }
+    });
+    return receiver;
+}
+
+static void StopReceiver(NetReceiver *receiver, const std::string &address) {
+    receiver->done = true;
+    receiver->thread.join();
+    close(receiver->fd);
+    unlink(address.c_str() + 5); // past "unix:"
+    delete receiver;
+}
+
+// stand-in collector for the shm handler - a thread draining the ring to the destination
+struct ShmCollector {
+    std::atomic<bool> done;
+    std::thread       thread;
+};
+
+static ShmCollector *StartCollector(const aca_log_shm_config *config) {
+    ShmCollector *collector = new ShmCollector();
+    collector->done         = false;
+    acaLogShmCreate(config);
+    collector->thread = std::thread([collector]() {
+        while (!collector->done.load()) {
+            if (acaLogShmDrain(stdout) == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+        acaLogShmDrain(stdout);
+    });
+    return collector;
+}
+
+static void StopCollector(ShmCollector *collector, const aca_log_shm_config *config) {
+    collector->done = true;
+    collector->thread.join();
+    acaLogShmDetach();
+    unlink(config->path);
+    delete collector;
+}
+
+static void LogOnce(int args, const char *payload, int i) {
+    switch (args) {
+        case 0:
+            ACA_LOG_INFO("%s", payload);
+            break;
+        case 2:
+            ACA_LOG_INFO("%s %d %d", payload, i, i + 1);
+            break;
+        default:
+            ACA_LOG_INFO("%s %d %d %d %d %.3f %.3f %s %p",
+                         payload,
+                         i,
+                         i + 1,
+                         i + 2,
+                         i + 3,
+                         i * 0.5,
+                         i * 0.25,
+                         "str",
+                         (void *)payload);
+            break;
+    }
+}
+
+static BenchResult Run(
+    aca_log_handler *handler, int threads, size_t msgBytes, int args, int calls) {
+    std::string           payload(msgBytes, 'x');
+    int                   perThread = std::max(100, calls / threads);
+    std::vector<uint64_t> latencies((size_t)perThread * threads);
+    std::atomic<int>      ready(0);
+    std::atomic<bool>     go(false);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            acaLogSetHandler(handler);
+            uint64_t *out = &latencies[(size_t)t * perThread];
+            ++ready;
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < perThread; ++i) {
+                bench_clock::time_point start = bench_clock::now();
+                LogOnce(args, payload.c_str(), i);
+                out[i] = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             bench_clock::now() - start)
+                             .count();
+            }
+        });
+    }
+    while (ready.load() != threads) {
+        std::this_thread::yield();
+    }
+    bench_clock::time_point start = bench_clock::now();
+    go.store(true);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (handler == acaLogAsyncHandler) {
+        acaLogAsyncFlush(); // throughput includes the writer catching up
+    }
+    fflush(stdout);
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    BenchResult result;
+    result.callsPerSec = (double)latencies.size() / seconds;
+    result.p50         = latencies[latencies.size() / 2];
+    result.p99         = latencies[(latencies.size() * 99) / 100];
+    result.max         = latencies.back();
+    return result;
+}
+
+// points stdout and dump.log at the destination - returns the drain to stop afterwards (pipe)
+static PipeDrain *OpenDest(const char *dest, int *stdoutFd) {
+    std::string dumpPath = g_dir + "/dump.log";
+    unlink(dumpPath.c_str());
+    PipeDrain *drain = NULL;
+    if (strcmp(dest, "null") == 0) {
+        *stdoutFd = open("/dev/null", O_WRONLY);
+        if (symlink("/dev/null", dumpPath.c_str()) != 0) {
+            perror("symlink");
+        }
+    } else if (strcmp(dest, "tmpfs") == 0) {
+        *stdoutFd = open((g_dir + "/stdout.log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    } else {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            exit(1);
+        }
+        *stdoutFd   = fds[1];
+        drain       = new PipeDrain();
+        drain->done = false;
+        mkfifo(dumpPath.c_str(), 0644);
+        int readFd    = fds[0];
+        drain->thread = std::thread([readFd, dumpPath, drain]() {
+            std::thread fifo(DrainFifo, dumpPath, drain);
+            DrainFd(readFd, drain);
+            close(readFd);
+            fifo.join();
+        });
+    }
+    fflush(stdout);
+    dup2(*stdoutFd, STDOUT_FILENO);
+    return drain;
+}
+
+static void CloseDest(PipeDrain *drain, int stdoutFd, int savedStdout) {
+    fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(stdoutFd);
+    if (drain != NULL) {
+        drain->done = true;
+        int fd      = open((g_dir + "/dump.log").c_str(), O_WRONLY); // unblocks the FIFO reader
+        if (fd >= 0) {
+            close(fd);
+        }
+        drain->thread.join();
+        delete drain;
+    }
+    unlink((g_dir + "/dump.log").c_str());
+    unlink((g_dir + "/stdout.log").c_str());
+}
+
+static void Report(const char        *handler,
+                   const char        *dest,
+                   int                threads,
+                   size_t             msg,
+                   int                args,
+                   const BenchResult &r) {
+    fprintf(g_out,
+            "%-14s %-6s %7d %8zu %5d %14.0f %10llu %10llu %12llu\n",
+            handler,
+            dest,
+            threads,
+            msg,
+            args,
+            r.callsPerSec,
+            (unsigned long long)r.p50,
+            (unsigned long long)r.p99,
+            (unsigned long long)r.max);
+    fflush(g_out);
+}
+
+int main(int argc, char *argv[]) {
+    ACA_ARGPARSE_OPT(help, "h", "help", 0, "Print out help and exit.");
+    ACA_ARGPARSE_OPT(callsOpt, "n", "calls", 1, "Log calls per run, split across threads (20000).");
+    ACA_ARGPARSE_OPT(threadsOpt, "t", "threads", 1, "Max threads for the thread sweep (64).");
+    ACA_ARGPARSE_OPT(handlerOpt, "", "handler", 1, "Only run this handler (e.g. standard).");
+    ACA_ARGPARSE_OPT(destOpt, "", "dest", 1, "Only run this destination (null, tmpfs, pipe).");
+    ACA_ARGPARSE_OPT(clockOpt, "", "clock", 1, "Timestamp source (monotonic, coarse, tsc).");
+    int unknownOption = acaArgparseParse(argc, argv);
+    if (unknownOption > 0) {
+        fprintf(stderr, "ERROR - Unknown option [ %s ] used.\n", argv[unknownOption]);
+        return 1;
+    }
+    if (help.infoBits.used) {
+        printf("[Usage]: aca_log_bench [OPTIONS]\n\nOPTIONS:\n");
+        acaArgparsePrint();
+        return 0;
+    }
+    int calls      = callsOpt.infoBits.used ? atoi(callsOpt.value) : 20000;
+    int maxThreads = threadsOpt.infoBits.used ? atoi(threadsOpt.value) : 64;
+    if (clockOpt.infoBits.used) {
+        static const char *kClocks[] = {"monotonic", "coarse", "tsc"};
+        int                clock     = 0;
+        while ((clock < 3) && (strcmp(clockOpt.value, kClocks[clock]) != 0)) {
+            ++clock;
+        }
+        if (clock == 3) {
+            fprintf(stderr, "ERROR - Unknown clock [ %s ].\n", clockOpt.value);
+            return 1;
+        }
+        if ((int)acaLogSetClock((aca_log_clock)clock) != clock) {
+            fprintf(stderr, "WARNING - %s clock unavailable, using monotonic\n", clockOpt.value);
+        }
+    }
+
+    // tmpfs scratch dir (falls back to /tmp) - the file handlers log to dump.log in the cwd
+    char dir[] = "/dev/shm/aca_log_bench.XXXXXX";
+    char alt[] = "/tmp/aca_log_bench.XXXXXX";
+    g_dir      = mkdtemp(dir) ? dir : (mkdtemp(alt) ? alt : "");
+    if (g_dir.empty() || (chdir(g_dir.c_str()) != 0)) {
+        fprintf(stderr, "ERROR - failed to create a scratch directory\n");
+        return 1;
+    }
+    int savedStdout = dup(STDOUT_FILENO);
+    g_out           = fdopen(dup(STDOUT_FILENO), "w");
+    fprintf(g_out,
+            "%-14s %-6s %7s %8s %5s %14s %10s %10s %12s\n",
+            "handler",
+            "dest",
+            "threads",
+            "msg",
+            "args",
+            "calls/s",
+            "p50(ns)",
+            "p99(ns)",
+            "max(ns)");
+
+    aca_log_async_config asyncConfig = {4096, ACA_LOG_ASYNC_BLOCK, 8, NULL};
+    aca_log_lz_config    lzConfig    = ACA_LOG_LZ_CONFIG_INIT;
+    lzConfig.path                    = "dump.log";
+    std::string        netAddress    = "unix:" + g_dir + "/net.sock";
+    aca_log_net_config netConfig     = ACA_LOG_NET_CONFIG_INIT;
+    netConfig.address                = netAddress.c_str();
+    netConfig.flushInterval          = 0.0;
+    std::string        shmPath       = g_dir + "/bench.ring";
+    aca_log_shm_config shmConfig     = ACA_LOG_SHM_CONFIG_INIT;
+    shmConfig.path                   = shmPath.c_str();
+    shmConfig.capacity               = 16384;
+    for (const BenchHandler &h : g_handlers) {
+        if (handlerOpt.infoBits.used && (strcmp(handlerOpt.value, h.name) != 0)) {
+            continue;
+        }
+        for (const char *dest : g_dests) {
+            if (destOpt.infoBits.used && (strcmp(destOpt.value, dest) != 0)) {
+                continue;
+            }
+            if ((h.handler == acaLogNetHandler) && (strcmp(dest, "null") != 0)) {
+                continue; // records go to the receiver, not stdout
+            }
+            int        stdoutFd = -1;
+            PipeDrain *drain    = OpenDest(dest, &stdoutFd);
+            if (h.handler == acaLogAsyncHandler) {
+                asyncConfig.fp = stdout;
+                acaLogAsyncStart(&asyncConfig);
+            }
+            if (h.handler == acaLogLzHandler) {
+                acaLogLzOpen(&lzConfig);
+            }
+            NetReceiver *receiver = NULL;
+            if (h.handler == acaLogNetHandler) {
+                receiver = StartReceiver(netAddress);
+                acaLogNetOpen(&netConfig);
+            }
+            ShmCollector *collector = NULL;
+            if (h.handler == acaLogShmHandler) {
+                collector = StartCollector(&shmConfig);
+            }
+
+            static const size_t kSizes[] = {16, 128, 1024};
+            static const int    kArgs[]  = {0, 2, 8};
+            for (size_t msg : kSizes) {
+                Report(h.name, dest, 1, msg, 0, Run(h.handler, 1, msg, 0, calls));
+            }
+            for (int args : kArgs) {
+                Report(h.name, dest, 1, 64, args, Run(h.handler, 1, 64, args, calls));
+            }
+            for (int threads = 2; threads <= maxThreads; threads *= 2) {
+                Report(h.name, dest, threads, 64, 2, Run(h.handler, threads, 64, 2, calls));
+            }
+
+            if (h.handler == acaLogAsyncHandler) {
+                acaLogAsyncStop();
+            }
+            if (h.handler == acaLogBufferedFileHandler) {
+                acaLogFileClose();
+            }
+            if (h.handler == acaLogLzHandler) {
+                acaLogLzClose();
+            }
+            if (receiver != NULL) {
+                acaLogNetClose();
+                StopReceiver(receiver, netAddress);
+                fprintf(g_out, "(net: %zu record(s) dropped)\n", acaLogNetDropped());
+            }
+            if (collector != NULL) {
+                fprintf(g_out, "(shm: %zu record(s) dropped)\n", acaLogShmDropped());
+                StopCollector(collector, &shmConfig);
+            }
+            CloseDest(drain, stdoutFd, savedStdout);
+        }
+    }
+
+    fclose(g_out);
+    rmdir(g_dir.c_str());
+    return 0;
+}
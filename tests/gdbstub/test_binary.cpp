@@ -0,0 +1,57 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "gtest/gtest.h"
+
+#include "aca_gdbstub.h"
+
+// Replies to a session of packets, acks left out
+static std::vector<std::string> runSession(const std::vector<std::string> &payloads) {
+    aca_gdbstub_context      gdbstubCtx = {0};
+    std::vector<std::string> replies;
+    for (const std::string &write : testRunSession(&gdbstubCtx, payloads)) {
+        if (write != "+") {
+            replies.push_back(write);
+        }
+    }
+    return replies;
+}
+
+TEST(gdbstub, test_X_x) {
+    std::vector<unsigned char> dummyMem(64);
+    g_memHandle = &dummyMem;
+
+    // Bytes that must be escaped (and a NUL) in the binary data
+    const std::string raw     = std::string("a#b$c}d*e\0f\xff", 13);
+    std::string       escaped = "";
+    for (char c : raw) {
+        if ((c == '#') || (c == '$') || (c == '}') || (c == '*')) {
+            escaped += '}';
+            c ^= 0x20;
+        }
+        escaped += c;
+    }
+    ASSERT_EQ(escaped.size(), raw.size() + 4);
+
+    std::vector<std::string> replies = runSession({"X10,0:",
+                                                   "X10,d:" + escaped,
+                                                   "x10,d",
+                                                   "x10,0",
+                                                   "m10,2",
+                                                   "X10,4:ab",
+                                                   "x10",
+                                                   "x0,ffffffffffffffff",
+                                                   "x0,ffc"});
+    ASSERT_EQ(replies.size(), 9U);
+    EXPECT_EQ(replies[0], "$OK#9a"); // 'X' probe
+    EXPECT_EQ(replies[1], "$OK#9a");
+    EXPECT_EQ(std::string(dummyMem.begin() + 0x10, dummyMem.begin() + 0x10 + 13), raw);
+    EXPECT_EQ(replies[2], testPacket("b" + escaped));
+    EXPECT_EQ(replies[3], testPacket("b"));
+    EXPECT_EQ(replies[4], testPacket("6123"));
+    EXPECT_EQ(replies[5], "$E00#96"); // data shorter than length
+    EXPECT_EQ(replies[6], "$E00#96"); // malformed
+    EXPECT_EQ(replies[7], "$E00#96"); // length wraps the buffer size
+    EXPECT_EQ(replies[8], "$E00#96"); // reply larger than PacketSize
+}
@@ -1,5 +1,10 @@
 #include "test_common.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
 // Test globals
 std::vector<char>          *g_getcharPktHandle = nullptr, *g_putcharPktHandle = nullptr;
 std::vector<unsigned char> *g_memHandle       = nullptr;
@@ -53,3 +58,41 @@ void acaGdbstubProcessBreakpointStub(int type, size_t addr, void *usrData) {
 void acaGdbstubKillSessionStub(void *usrData) {
     return;
 }
+
+void testBlockWrite(const char *buf, size_t len, void *usrData) {
+    ((TestTransport *)usrData)->writes.push_back(std::string(buf, len));
+}
+
+size_t testBlockRead(char *buf, size_t maxLen, void *usrData) {
+    TestTransport *transport = (TestTransport *)usrData;
+    size_t         len       = transport->input.size() - transport->inputOffset;
+    len                      = std::min(len, std::min(maxLen, transport->chunkSize));
+    memcpy(buf, &transport->input[transport->inputOffset], len);
+    transport->inputOffset += len;
+    ++transport->reads;
+    return len;
+}
+
+std::string testPacket(const std::string &payload) {
+    char checksum[8];
+    acaGdbstubComputeChecksum(const_cast<char *>(payload.data()), payload.size(), checksum);
+    return "$" + payload + "#" + std::string(checksum, 2);
+}
+
+std::vector<std::string> testRunSession(aca_gdbstub_context            *gdbstubCtx,
+                                        const std::vector<std::string> &payloads) {
+    TestTransport transport = {"", 0, 16, 0, {}};
+    for (const std::string &payload : payloads) {
+        transport.input += testPacket(payload) + "+";
+    }
+    transport.input += testPacket("k");
+
+    gdbstubCtx->usrData        = &transport;
+    gdbstubCtx->blockOps.write = testBlockWrite;
+    gdbstubCtx->blockOps.read  = testBlockRead;
+    acaGdbstubProcess(gdbstubCtx);
+    EXPECT_EQ(gdbstubCtx->err, ACA_GDBSTUB_SUCCESS);
+    EXPECT_EQ(transport.inputOffset, transport.input.size());
+    gdbstubCtx->usrData = NULL;
+    return transport.writes;
+}
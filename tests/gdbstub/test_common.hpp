@@ -4,6 +4,7 @@
 #include "aca_gdbstub.h"
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #define GTEST_COUT std::cerr << "\033[0;32m[ INFO     ] \033[0;37m"
@@ -23,6 +24,16 @@ struct TestBreak {
     size_t addr;
 };
 
+// Mock transport for the block I/O callbacks - block reads hand out at most chunkSize bytes of
+// input per call
+struct TestTransport {
+    std::string              input;
+    size_t                   inputOffset;
+    size_t                   chunkSize;
+    size_t                   reads;
+    std::vector<std::string> writes;
+};
+
 // Test globals
 extern std::vector<char>          *g_getcharPktHandle, *g_putcharPktHandle;
 extern std::vector<unsigned char> *g_memHandle;
@@ -40,4 +51,14 @@ void          acaGdbstubStepStub(void *usrData);
 void          acaGdbstubProcessBreakpointStub(int type, size_t addr, void *usrData);
 void          acaGdbstubKillSessionStub(void *usrData);
 
+// Test block I/O callbacks (usrData is a TestTransport) and packet framing helper
+void        testBlockWrite(const char *buf, size_t len, void *usrData);
+size_t      testBlockRead(char *buf, size_t maxLen, void *usrData);
+std::string testPacket(const std::string &payload);
+
+// Run a session of packets (+ a final kill) through acaGdbstubProcess over the block I/O
+// callbacks, GDB acking every reply - returns everything the stub wrote
+std::vector<std::string> testRunSession(aca_gdbstub_context            *gdbstubCtx,
+                                        const std::vector<std::string> &payloads);
+
 #endif // MINIGDBSTUB_TEST_COMMON_HPP
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "gtest/gtest.h"
+
+#include "aca_gdbstub.h"
+
+TEST(gdbstub, test_block_write) {
+    TestTransport       transport  = {"", 0, 0, 0, {}};
+    aca_gdbstub_context gdbstubCtx = {0};
+    gdbstubCtx.usrData             = &transport;
+    gdbstubCtx.blockOps.write      = testBlockWrite;
+
+    // Whole 'm' reply goes out in a single write
+    std::vector<unsigned char> dummyMem(256);
+    for (size_t i = 0; i < dummyMem.size(); ++i) {
+        dummyMem[i] = (unsigned char)i;
+    }
+    g_memHandle = &dummyMem;
+
+    aca_gdb_packet mockPkt = {0};
+    GTEST_FAIL_IF_ERR(acaDynamicCharBufferInit(&mockPkt.pktData, 32));
+    const char *packet = "m10,80";
+    for (size_t i = 0; i <= strlen(packet); ++i) {
+        GTEST_FAIL_IF_ERR(acaDynamicCharBufferInsert(&mockPkt.pktData, packet[i]));
+    }
+    acaGdbstubReadMem(&gdbstubCtx, &mockPkt);
+    GTEST_FAIL_IF_ERR(gdbstubCtx.err);
+
+    ASSERT_EQ(transport.writes.size(), 1U);
+    const std::string &reply = transport.writes[0];
+    ASSERT_EQ(reply.size(), 1 + (0x80 * 2) + 3);
+    EXPECT_EQ(reply.substr(0, 7), "$101112");
+    EXPECT_EQ(reply.substr(reply.size() - 5, 2), "8f");
+    EXPECT_EQ(reply[reply.size() - 3], '#');
+    acaDynamicCharBufferFree(&mockPkt.pktData);
+}
+
+TEST(gdbstub, test_block_read) {
+    // Two packets (w/ ack noise in between) arriving in odd-sized chunks
+    for (size_t chunkSize : {1, 3, 7, 64}) {
+        TestTransport       transport  = {"+$g#67+$Ga700467f#46", 0, chunkSize, 0, {}};
+        aca_gdbstub_context gdbstubCtx = {0};
+        gdbstubCtx.usrData             = &transport;
+        gdbstubCtx.blockOps.write      = testBlockWrite;
+        gdbstubCtx.blockOps.read       = testBlockRead;
+
+        aca_gdb_packet gdbPkt = {0};
+        GTEST_FAIL_IF_ERR(acaDynamicCharBufferInit(&gdbPkt.pktData, 64));
+        acaGdbstubRecv(&gdbstubCtx, &gdbPkt);
+        GTEST_FAIL_IF_ERR(gdbstubCtx.err);
+        EXPECT_EQ(gdbPkt.commandType, 'g');
+        EXPECT_STREQ(gdbPkt.pktData.buffer, "g");
+        acaDynamicCharBufferFree(&gdbPkt.pktData);
+
+        // The rest of the input stays buffered for the next packet
+        GTEST_FAIL_IF_ERR(acaDynamicCharBufferInit(&gdbPkt.pktData, 64));
+        acaGdbstubRecv(&gdbstubCtx, &gdbPkt);
+        GTEST_FAIL_IF_ERR(gdbstubCtx.err);
+        EXPECT_EQ(gdbPkt.commandType, 'G');
+        EXPECT_STREQ(gdbPkt.pktData.buffer, "Ga700467f");
+        acaDynamicCharBufferFree(&gdbPkt.pktData);
+
+        EXPECT_EQ(transport.inputOffset, transport.input.size());
+        EXPECT_EQ(transport.reads, (transport.input.size() + chunkSize - 1) / chunkSize);
+        EXPECT_EQ(transport.writes, std::vector<std::string>({"+", "+"}));
+    }
+}
+
+TEST(gdbstub, test_block_read_disconnect) {
+    // Transport runs dry in the middle of a packet - a 0 byte read is a disconnect
+    TestTransport       transport  = {"+$g#6", 0, 4, 0, {}};
+    aca_gdbstub_context gdbstubCtx = {0};
+    gdbstubCtx.usrData             = &transport;
+    gdbstubCtx.blockOps.write      = testBlockWrite;
+    gdbstubCtx.blockOps.read       = testBlockRead;
+
+    aca_gdb_packet gdbPkt = {0};
+    GTEST_FAIL_IF_ERR(acaDynamicCharBufferInit(&gdbPkt.pktData, 64));
+    acaGdbstubRecv(&gdbstubCtx, &gdbPkt);
+    EXPECT_EQ(gdbstubCtx.err, ACA_GDBSTUB_DISCONNECTED);
+    EXPECT_EQ(transport.reads, 3U);
+    EXPECT_TRUE(transport.writes.empty());
+    acaDynamicCharBufferFree(&gdbPkt.pktData);
+
+    // The session ends after replying to the packets that did arrive
+    transport                 = {testPacket("vMustReplyEmpty") + "+", 0, 16, 0, {}};
+    gdbstubCtx                = {0};
+    gdbstubCtx.usrData        = &transport;
+    gdbstubCtx.blockOps.write = testBlockWrite;
+    gdbstubCtx.blockOps.read  = testBlockRead;
+    acaGdbstubProcess(&gdbstubCtx);
+    EXPECT_EQ(gdbstubCtx.err, ACA_GDBSTUB_DISCONNECTED);
+    EXPECT_EQ(transport.inputOffset, transport.input.size());
+    EXPECT_EQ(transport.writes, std::vector<std::string>({"+", "$#00"}));
+}
@@ -81,6 +81,7 @@ TEST(gdbstub, test_M) {
 
     acaGdbstubWriteMem(&gdbstubCtx, &mockPkt);
     GTEST_FAIL_IF_ERR(gdbstubCtx.err);
+    EXPECT_EQ(std::string(putcharHandle.begin(), putcharHandle.end()), "$OK#9a");
 
     const unsigned char expectedValue[] = {(unsigned char)222,
                                            (unsigned char)173,
@@ -90,4 +91,94 @@ TEST(gdbstub, test_M) {
     for (int i = 0; i < 4; ++i) {
         EXPECT_EQ(dummyMem[4 + i], expectedValue[i]);
     }
-}
\ No newline at end of file
+}
+
+// Mock block memory - only [0, readable) can be read, writes past writable fail
+struct TestBlockMem {
+    std::vector<unsigned char> mem;
+    size_t                     readable;
+    size_t                     writable;
+    int                        calls;
+};
+
+static size_t testReadMemBlock(size_t addr, unsigned char *buf, size_t len, void *usrData) {
+    TestBlockMem *blockMem = (TestBlockMem *)usrData;
+    ++blockMem->calls;
+    if (addr >= blockMem->readable) {
+        return 0;
+    }
+    len = std::min(len, blockMem->readable - addr);
+    memcpy(buf, &blockMem->mem[addr], len);
+    return len;
+}
+
+static int testWriteMemBlock(size_t addr, const unsigned char *buf, size_t len, void *usrData) {
+    TestBlockMem *blockMem = (TestBlockMem *)usrData;
+    ++blockMem->calls;
+    if (addr + len > blockMem->writable) {
+        return -1;
+    }
+    memcpy(&blockMem->mem[addr], buf, len);
+    return ACA_GDBSTUB_SUCCESS;
+}
+
+static std::string runMemPacket(aca_gdbstub_context *gdbstubCtx, const char *packet) {
+    aca_gdb_packet mockPkt = {0};
+    EXPECT_EQ(acaDynamicCharBufferInit(&mockPkt.pktData, 32), ACA_GDBSTUB_SUCCESS);
+    for (size_t i = 0; i <= strlen(packet); ++i) {
+        EXPECT_EQ(acaDynamicCharBufferInsert(&mockPkt.pktData, packet[i]), ACA_GDBSTUB_SUCCESS);
+    }
+    std::vector<char> putcharHandle;
+    g_putcharPktHandle = &putcharHandle;
+    if (packet[0] == 'm') {
+        acaGdbstubReadMem(gdbstubCtx, &mockPkt);
+    } else {
+        acaGdbstubWriteMem(gdbstubCtx, &mockPkt);
+    }
+    EXPECT_EQ(gdbstubCtx->err, ACA_GDBSTUB_SUCCESS);
+    acaDynamicCharBufferFree(&mockPkt.pktData);
+    return std::string(putcharHandle.begin(), putcharHandle.end());
+}
+
+TEST(gdbstub, test_m_block) {
+    TestBlockMem blockMem = {std::vector<unsigned char>(64), 16, 64, 0};
+    for (size_t i = 0; i < blockMem.mem.size(); ++i) {
+        blockMem.mem[i] = (unsigned char)(0xa0 + i);
+    }
+    aca_gdbstub_context gdbstubCtx = {0};
+    gdbstubCtx.usrData             = &blockMem;
+    gdbstubCtx.blockOps.readMem    = testReadMemBlock;
+
+    // One call per packet
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "m8,4"), "$a8a9aaab#b8");
+    EXPECT_EQ(blockMem.calls, 1);
+
+    // Partial read is a shorter reply, unreadable memory is an error
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "me,8"), "$aeaf#8d");
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "m20,4"), "$E00#96");
+    EXPECT_EQ(blockMem.calls, 3);
+
+    // Negative lengths and lengths whose reply wouldn't fit in a packet are refused up front
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "m0,-1"), "$E00#96");
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "m0,800"), "$E00#96");
+    gdbstubCtx.packetSize = 12;
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "m8,5"), "$E00#96");
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "m8,4"), "$a8a9aaab#b8");
+    EXPECT_EQ(blockMem.calls, 4);
+}
+
+TEST(gdbstub, test_M_block) {
+    TestBlockMem        blockMem   = {std::vector<unsigned char>(64), 64, 8, 0};
+    aca_gdbstub_context gdbstubCtx = {0};
+    gdbstubCtx.usrData             = &blockMem;
+    gdbstubCtx.blockOps.writeMem   = testWriteMemBlock;
+
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "M4,4:deadbeef"), "$OK#9a");
+    EXPECT_EQ(blockMem.calls, 1);
+    const unsigned char expectedValue[] = {0xde, 0xad, 0xbe, 0xef};
+    EXPECT_EQ(memcmp(&blockMem.mem[4], expectedValue, 4), 0);
+
+    // Failed write is reported to GDB
+    EXPECT_EQ(runMemPacket(&gdbstubCtx, "M6,4:01020304"), "$E00#96");
+    EXPECT_EQ(blockMem.mem[6], 0xbe);
+}
@@ -0,0 +1,49 @@
+#include <string>
+#include <vector>
+
+#include "test_common.hpp"
+#include "gtest/gtest.h"
+
+#include "aca_gdbstub.h"
+
+static const char *kFeatures = "PacketSize=1000;QStartNoAckMode+;binary-upload+";
+
+TEST(gdbstub, test_qSupported) {
+    aca_gdbstub_context      gdbstubCtx = {0};
+    std::vector<std::string> writes     = testRunSession(
+        &gdbstubCtx, {"qSupported:multiprocess+;swbreak+;xmlRegisters=i386", "qC", "QFoo"});
+    std::vector<std::string> expected = {"+",
+                                         testPacket(kFeatures),
+                                         "+",
+                                         "$#00",
+                                         "+",
+                                         "$#00",
+                                         "+"};
+    EXPECT_EQ(writes, expected);
+
+    // Configured packet size
+    aca_gdbstub_context sizedCtx = {0};
+    sizedCtx.packetSize          = 0x20000;
+    writes                       = testRunSession(&sizedCtx, {"qSupported"});
+    ASSERT_EQ(writes.size(), 3U);
+    EXPECT_EQ(writes[1], testPacket("PacketSize=20000;QStartNoAckMode+;binary-upload+"));
+}
+
+TEST(gdbstub, test_QStartNoAckMode) {
+    std::vector<unsigned char> dummyMem(16);
+    dummyMem[2] = 0x5a;
+    g_memHandle = &dummyMem;
+
+    // Packets after the OK are no longer acked
+    aca_gdbstub_context      gdbstubCtx = {0};
+    std::vector<std::string> writes =
+        testRunSession(&gdbstubCtx, {"qSupported", "QStartNoAckMode", "m2,1", "qC"});
+    std::vector<std::string> expected = {"+",
+                                         testPacket(kFeatures),
+                                         "+",
+                                         "$OK#9a",
+                                         testPacket("5a"),
+                                         "$#00"};
+    EXPECT_EQ(writes, expected);
+    EXPECT_EQ(gdbstubCtx.noAckMode, 1);
+}
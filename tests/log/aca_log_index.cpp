@@ -0,0 +1,7 @@
+#define ACA_LOG_TO_STANDARD_FILE_HANDLER_FILENAME "aca_log_index_test.log"
+#define ACA_LOG_TO_STANDARD_FILE_HANDLER_ACCESS_STR "a"
+#define ACA_LOG_TO_STANDARD_FILE_HANDLER_INDEX_KB 1
+#define ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS
+
+#define ACA_LOG_IMPLEMENTATION
+#include "aca_log.h"
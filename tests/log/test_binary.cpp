@@ -0,0 +1,243 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static std::string DecodeToString(const std::string &path) {
+    FILE *in  = fopen(path.c_str(), "rb");
+    FILE *out = tmpfile();
+    EXPECT_NE(in, nullptr);
+    EXPECT_NE(out, nullptr);
+    EXPECT_EQ(acaLogBinaryDecode(in, out), 0);
+    fclose(in);
+
+    std::string decoded;
+    char        buf[512];
+    rewind(out);
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), out)) > 0) {
+        decoded.append(buf, n);
+    }
+    fclose(out);
+    return decoded;
+}
+
+static std::string ExpectedLine(const char *level, int line, const char *msg) {
+    char buf[512];
+    snprintf(buf,
+             sizeof(buf),
+             "[aca_log_test] [%5s] [%28s] %s\n",
+             level,
+             ("test_binary.cpp:" + std::to_string(line)).c_str(),
+             msg);
+    return buf;
+}
+
+TEST(log, binary_roundtrip) {
+    std::string path = testing::TempDir() + "aca_log_binary.bin";
+    ASSERT_EQ(acaLogBinaryOpen(path.c_str()), 0);
+
+    int         line[6];
+    std::string longInput(2000, 'z');
+    // clang-format off
+    line[0] = __LINE__; ACA_LOG_BINARY(ACA_LOG_INFO, "Hello World!");
+    line[1] = __LINE__; ACA_LOG_BINARY(ACA_LOG_WARN, "A: %f, B: %c, C: %u", 31.456, 'b', 555);
+    line[2] = __LINE__; ACA_LOG_BINARY(ACA_LOG_ERROR, "%d %ld %lld %zu %hhx %#X",
+                                       -1, 2L, -3LL, (size_t)4, 0x1ff, 255);
+    line[3] = __LINE__; ACA_LOG_BINARY(ACA_LOG_DEBUG, "[%*d] [%-6s] [%.3s] %.2f%%",
+                                       5, 42, "ab", "abcdef", 3.14159);
+    line[4] = __LINE__; ACA_LOG_BINARY(ACA_LOG_TRACE, "%s", longInput.c_str());
+    // clang-format on
+    for (int i = 0; i < 3; ++i) {
+        line[5] = __LINE__; ACA_LOG_BINARY(ACA_LOG_INFO, "loop %d", i);
+    }
+    acaLogBinaryClose();
+
+    std::string expected = ExpectedLine("INFO", line[0], "Hello World!") +
+                           ExpectedLine("WARN", line[1], "A: 31.456000, B: b, C: 555") +
+                           ExpectedLine("ERROR", line[2], "-1 2 -3 4 ff 0XFF") +
+                           ExpectedLine("DEBUG", line[3], "[   42] [ab    ] [abc] 3.14%");
+    std::string decoded = DecodeToString(path);
+    ASSERT_EQ(decoded.substr(0, expected.size()), expected);
+
+    // oversized strings are truncated to fit in a single record
+    std::string rest = decoded.substr(expected.size());
+    size_t      eol  = rest.find('\n');
+    ASSERT_NE(eol, std::string::npos);
+    EXPECT_EQ(rest.find("[TRACE]"), 15u);
+    size_t zCount = rest.find_last_of('z') - rest.find('z') + 1;
+    EXPECT_GT(zCount, 900u);
+    EXPECT_LT(zCount, 1024u);
+    EXPECT_EQ(rest.substr(eol + 1),
+              ExpectedLine("INFO", line[5], "loop 0") + ExpectedLine("INFO", line[5], "loop 1") +
+                  ExpectedLine("INFO", line[5], "loop 2"));
+    std::remove(path.c_str());
+}
+
+TEST(log, binary_threads) {
+    std::string path = testing::TempDir() + "aca_log_binary_threads.bin";
+    ASSERT_EQ(acaLogBinaryOpen(path.c_str()), 0);
+
+    // staged records from exiting threads are handed to the file
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 5000; ++i) {
+                ACA_LOG_BINARY(ACA_LOG_INFO, "thread %d record %d", t, i);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    acaLogBinaryClose();
+
+    std::string decoded = DecodeToString(path);
+    size_t      lines   = 0;
+    for (char c : decoded) {
+        lines += (c == '\n');
+    }
+    EXPECT_EQ(lines, 4u * 5000u);
+    EXPECT_NE(decoded.find("] thread 3 record 4999\n"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST(log, binary_merge_by_timestamp) {
+    std::string path = testing::TempDir() + "aca_log_binary_merge.bin";
+    ASSERT_EQ(acaLogBinaryOpen(path.c_str()), 0);
+
+    // two threads take turns, but each hands its records over in one chunk when it exits
+    std::atomic<int>         turn(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([t, &turn]() {
+            for (int i = 0; i < 4; ++i) {
+                while (turn != 2 * i + t) {
+                    std::this_thread::yield();
+                }
+                ACA_LOG_BINARY(ACA_LOG_INFO, "turn %d", 2 * i + t);
+                ++turn;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    acaLogBinaryClose();
+
+    std::string decoded = DecodeToString(path);
+    size_t      pos     = 0;
+    for (int i = 0; i < 8; ++i) {
+        size_t next = decoded.find("] turn " + std::to_string(i) + "\n");
+        ASSERT_NE(next, std::string::npos);
+        EXPECT_GE(next, pos);
+        pos = next;
+    }
+    std::remove(path.c_str());
+}
+
+TEST(log, binary_close_flushes_live_threads) {
+    std::string path = testing::TempDir() + "aca_log_binary_live.bin";
+    ASSERT_EQ(acaLogBinaryOpen(path.c_str()), 0);
+
+    // a thread that is still running keeps its records staged - close must collect them
+    std::atomic<int> state(0);
+    std::thread      worker([&state]() {
+        ACA_LOG_BINARY(ACA_LOG_INFO, "staged by a live thread");
+        state = 1;
+        while (state != 2) {
+            std::this_thread::yield();
+        }
+    });
+    while (state != 1) {
+        std::this_thread::yield();
+    }
+    acaLogBinaryClose();
+    state = 2;
+    worker.join();
+
+    EXPECT_NE(DecodeToString(path).find("] staged by a live thread\n"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST(log, binary_wide_strings) {
+    std::string path = testing::TempDir() + "aca_log_binary_wide.bin";
+    ASSERT_EQ(acaLogBinaryOpen(path.c_str()), 0);
+    int line = __LINE__ + 1;
+    ACA_LOG_BINARY(ACA_LOG_INFO, "[%ls] [%-5ls] [%s]", L"caf\u00e9 \u20ac", L"ab", "narrow");
+    acaLogBinaryClose();
+
+    EXPECT_EQ(DecodeToString(path),
+              ExpectedLine("INFO", line, "[caf\xc3\xa9 \xe2\x82\xac] [ab   ] [narrow]"));
+    std::remove(path.c_str());
+}
+
+TEST(log, binary_producer_tag) {
+    // the prefix carries the tag stored by the producer, not the decoder's own ACA_LOG_TAG
+    std::string path = testing::TempDir() + "aca_log_binary_tag.bin";
+    FILE       *fp   = fopen(path.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    const char    *tag = "producer", *file = "node.c", *fmt = "up %d";
+    unsigned short tagLen = 8, fileLen = 6, fmtLen = 5, argLen = 4;
+    unsigned int   id = 1;
+    unsigned char  level = ACA_LOG_WARN;
+    int            line = 7, arg = 3;
+    double         timestamp = 1.5;
+    fwrite("ACALOGB2", 1, 8, fp);
+    fwrite(&tagLen, 2, 1, fp);
+    fwrite(tag, 1, tagLen, fp);
+    fputc('S', fp);
+    fwrite(&id, 4, 1, fp);
+    fwrite(&level, 1, 1, fp);
+    fwrite(&line, 4, 1, fp);
+    fwrite(&fileLen, 2, 1, fp);
+    fwrite(file, 1, fileLen, fp);
+    fwrite(&fmtLen, 2, 1, fp);
+    fwrite(fmt, 1, fmtLen, fp);
+    fputc('R', fp);
+    fwrite(&id, 4, 1, fp);
+    fwrite(&timestamp, 8, 1, fp);
+    fwrite(&argLen, 2, 1, fp);
+    fwrite(&arg, 4, 1, fp);
+    fclose(fp);
+
+    char expected[128];
+    snprintf(expected, sizeof(expected), "[producer] [ WARN] [%28s] up 3\n", "node.c:7");
+    EXPECT_EQ(DecodeToString(path), expected);
+    std::remove(path.c_str());
+}
+
+TEST(log, binary_malformed_site_id) {
+    // a site id far past the ones defined so far is refused instead of sizing the site table
+    std::string path = testing::TempDir() + "aca_log_binary_bad_site.bin";
+    for (unsigned int id : {0xffffffffu, 0x7fffffffu, 3u}) {
+        FILE *fp = fopen(path.c_str(), "wb");
+        ASSERT_NE(fp, nullptr);
+        unsigned short tagLen = 0, fileLen = 1, fmtLen = 1;
+        unsigned char  level = ACA_LOG_INFO;
+        int            line  = 1;
+        fwrite("ACALOGB2", 1, 8, fp);
+        fwrite(&tagLen, 2, 1, fp);
+        fputc('S', fp);
+        fwrite(&id, 4, 1, fp);
+        fwrite(&level, 1, 1, fp);
+        fwrite(&line, 4, 1, fp);
+        fwrite(&fileLen, 2, 1, fp);
+        fputc('f', fp);
+        fwrite(&fmtLen, 2, 1, fp);
+        fputc('x', fp);
+        fclose(fp);
+
+        FILE *in  = fopen(path.c_str(), "rb");
+        FILE *out = tmpfile();
+        ASSERT_NE(in, nullptr);
+        EXPECT_EQ(acaLogBinaryDecode(in, out), -1);
+        EXPECT_EQ(ftell(out), 0);
+        fclose(out);
+        fclose(in);
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+// the clock can only be picked before the first timestamp, so every source is checked in a freshly
+// started copy of the test binary (threadsafe death tests re-run it) - exits with 0 if timestamps
+// from the clock keep up with wall time (within a coarse clock's tick)
+static void ExpectClockTracks(aca_log_clock clock) {
+    aca_log_clock inUse = acaLogSetClock(clock);
+    bool          ok    = (inUse == acaLogGetClock()) && (inUse == clock);
+#if defined(__x86_64__) || defined(__aarch64__)
+    // only falls back on CPUs without an invariant TSC
+    ok = ok || ((clock == ACA_LOG_CLOCK_TSC) && (inUse == ACA_LOG_CLOCK_MONOTONIC));
+#else
+    ok = ok || (inUse == ACA_LOG_CLOCK_MONOTONIC);
+#endif
+    double start = acaLogTimestamp();
+    ok           = ok && (start >= 0.0) && (start < 0.05);
+    double last  = start;
+    for (int i = 0; i < 1000; ++i) {
+        double now = acaLogTimestamp();
+        ok         = ok && (now >= last);
+        last       = now;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    double elapsed = acaLogTimestamp() - start;
+    ok             = ok && (elapsed > 0.035) && (elapsed < 0.5);
+
+    // too late to switch now
+    aca_log_clock other = (inUse == ACA_LOG_CLOCK_MONOTONIC) ? ACA_LOG_CLOCK_COARSE
+                                                             : ACA_LOG_CLOCK_MONOTONIC;
+    ok = ok && (acaLogSetClock(other) == inUse) && (acaLogGetClock() == inUse);
+    exit(ok ? 0 : 1);
+}
+
+TEST(log, clock_sources) {
+    std::string style = GTEST_FLAG_GET(death_test_style);
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT(ExpectClockTracks(ACA_LOG_CLOCK_MONOTONIC), testing::ExitedWithCode(0), "");
+    EXPECT_EXIT(ExpectClockTracks(ACA_LOG_CLOCK_COARSE), testing::ExitedWithCode(0), "");
+    EXPECT_EXIT(ExpectClockTracks(ACA_LOG_CLOCK_TSC), testing::ExitedWithCode(0), "");
+    GTEST_FLAG_SET(death_test_style, style);
+}
+
+// [timestamp] of the flight recorder dump line holding msg
+static double DumpedTimestamp(const std::string &dump, const char *msg) {
+    size_t end = dump.find(msg);
+    if (end == std::string::npos) {
+        return -1.0;
+    }
+    size_t start = dump.rfind('\n', end);
+    return atof(dump.c_str() + start + 2);
+}
+
+TEST(log, clock_deferred_conversion) {
+    // flight records carry raw ticks, the dump turns them into the [timestamp] field
+    aca_log_flight_config config = ACA_LOG_FLIGHT_CONFIG_INIT;
+    config.forward               = NULL;
+    config.signalHandler         = 0;
+    acaLogFlightStart(&config);
+    acaLogSetHandler(acaLogFlightHandler);
+    ACA_LOG_INFO("clock tick a");
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ACA_LOG_INFO("clock tick b");
+    acaLogSetHandler(acaLogStandardHandler);
+
+    FILE *fp = tmpfile();
+    ASSERT_NE(fp, nullptr);
+    acaLogFlightDump(fileno(fp));
+    std::string dump;
+    char        buffer[4096];
+    size_t      n;
+    rewind(fp);
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        dump.append(buffer, n);
+    }
+    fclose(fp);
+    double a = DumpedTimestamp(dump, "] clock tick a");
+    double b = DumpedTimestamp(dump, "] clock tick b");
+    EXPECT_GE(a, 0.0) << dump;
+    EXPECT_GT(b - a, 0.025) << dump;
+    EXPECT_LT(b - a, 0.5) << dump;
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static void StartDedup(double window, int consecutive) {
+    aca_log_dedup_config config = ACA_LOG_DEDUP_CONFIG_INIT;
+    config.forward              = acaLogBasicHandler;
+    config.window               = window;
+    config.consecutive          = consecutive;
+    config.passLevel            = ACA_LOG_ERROR;
+    acaLogDedupStart(&config);
+    acaLogSetHandler(acaLogDedupHandler);
+}
+
+static void StopDedup(void) {
+    acaLogSetHandler(acaLogStandardHandler);
+    acaLogDedupStart(NULL);
+}
+
+// summary line with the (timing dependent) duration cut off
+static std::string Summary(const std::string &line) {
+    size_t over = line.find(" over ");
+    return (over == std::string::npos) ? line : line.substr(0, over) + "]";
+}
+
+static std::vector<std::string> Lines(const std::string &text) {
+    std::vector<std::string> lines;
+    size_t                   start = 0;
+    for (size_t eol; (eol = text.find('\n', start)) != std::string::npos; start = eol + 1) {
+        lines.push_back(Summary(text.substr(start, eol - start)));
+    }
+    return lines;
+}
+
+TEST(log, dedup_storm) {
+    StartDedup(60.0, 0);
+    size_t suppressed = acaLogDedupSuppressed();
+    testing::internal::CaptureStdout();
+    for (int i = 0; i < 1000; ++i) {
+        ACA_LOG_WARN("link down on %s", "eth0");
+        ACA_LOG_WARN("link down on %s", (i < 500) ? "eth1" : "eth2");
+        ACA_LOG_ERROR("pass through %d", i / 999); // at/above passLevel
+    }
+    ACA_LOG_WARN("link down on %s", "eth0"); // same message, different call site
+    acaLogDedupFlush();
+    std::vector<std::string> lines = Lines(testing::internal::GetCapturedStdout());
+
+    ASSERT_EQ(lines.size(), 1007u);
+    EXPECT_EQ(lines[0], "[ WARN] link down on eth0");
+    EXPECT_EQ(lines[1], "[ WARN] link down on eth1");
+    EXPECT_EQ(lines[2], "[ERROR] pass through 0");
+    EXPECT_EQ(lines[3], "[ERROR] pass through 0");
+    EXPECT_EQ(lines[502], "[ WARN] link down on eth2");
+    EXPECT_EQ(lines[1002], "[ERROR] pass through 1");
+    EXPECT_EQ(lines[1003], "[ WARN] link down on eth0");
+    std::vector<std::string> summaries(lines.begin() + 1004, lines.end());
+    std::sort(summaries.begin(), summaries.end());
+    EXPECT_EQ(summaries[0], "[ WARN] link down on eth0 [repeated 999 times]");
+    EXPECT_EQ(summaries[1], "[ WARN] link down on eth1 [repeated 499 times]");
+    EXPECT_EQ(summaries[2], "[ WARN] link down on eth2 [repeated 499 times]");
+    EXPECT_EQ(acaLogDedupSuppressed() - suppressed, 999u + 499u + 499u);
+    StopDedup();
+}
+
+TEST(log, dedup_window) {
+    StartDedup(0.05, 0);
+    testing::internal::CaptureStdout();
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            ACA_LOG_INFO("retrying");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    }
+    ACA_LOG_DEBUG("idle"); // the next record pays the summary owed by the closed window
+    std::vector<std::string> lines = Lines(testing::internal::GetCapturedStdout());
+
+    std::vector<std::string> expected = {"[ INFO] retrying",
+                                         "[ INFO] retrying [repeated 9 times]",
+                                         "[ INFO] retrying",
+                                         "[ INFO] retrying [repeated 9 times]",
+                                         "[DEBUG] idle"};
+    EXPECT_EQ(lines, expected);
+    StopDedup();
+}
+
+TEST(log, dedup_consecutive) {
+    StartDedup(60.0, 1);
+    testing::internal::CaptureStdout();
+    const char *sequence[] = {"a", "a", "a", "b", "a", "a", "b", "b"};
+    for (const char *msg : sequence) {
+        ACA_LOG_INFO("%s", msg);
+    }
+    acaLogDedupFlush();
+    std::vector<std::string> lines = Lines(testing::internal::GetCapturedStdout());
+
+    std::vector<std::string> expected = {"[ INFO] a",
+                                         "[ INFO] a [repeated 2 times]",
+                                         "[ INFO] b",
+                                         "[ INFO] a",
+                                         "[ INFO] a [repeated 1 times]",
+                                         "[ INFO] b",
+                                         "[ INFO] b [repeated 1 times]"};
+    EXPECT_EQ(lines, expected);
+    StopDedup();
+}
+
+TEST(log, dedup_threads) {
+    StartDedup(60.0, 0);
+    acaLogSetDefaultHandler(acaLogDedupHandler);
+    testing::internal::CaptureStdout();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < 2500; ++i) {
+                ACA_LOG_WARN("queue full");
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    acaLogDedupFlush();
+    std::vector<std::string> lines = Lines(testing::internal::GetCapturedStdout());
+
+    std::vector<std::string> expected = {"[ WARN] queue full",
+                                         "[ WARN] queue full [repeated 9999 times]"};
+    EXPECT_EQ(lines, expected);
+    acaLogSetDefaultHandler(NULL);
+    StopDedup();
+}
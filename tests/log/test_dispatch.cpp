@@ -0,0 +1,125 @@
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+struct CaptureSink {
+    std::mutex                lock;
+    std::vector<std::string>  messages;
+    std::vector<const char *> buffers;
+};
+
+static void Capture(const aca_log_record *record, void *user) {
+    CaptureSink                *capture = (CaptureSink *)user;
+    std::lock_guard<std::mutex> guard(capture->lock);
+    capture->messages.push_back(std::string(record->msg, record->msgLen));
+    capture->buffers.push_back(record->msg);
+}
+
+TEST(log, dispatch_levels) {
+    CaptureSink verbose;
+    CaptureSink errors;
+    ASSERT_EQ(acaLogSinkAdd(Capture, &verbose, ACA_LOG_DEBUG), 0);
+    ASSERT_EQ(acaLogSinkAdd(Capture, &errors, ACA_LOG_ERROR), 0);
+    acaLogSetHandler(acaLogDispatchHandler);
+
+    ACA_LOG_TRACE("trace");
+    ACA_LOG_INFO("info %d", 1);
+    ACA_LOG_ERROR("error %s", "two");
+    EXPECT_EQ(verbose.messages, (std::vector<std::string>{"info 1", "error two"}));
+    EXPECT_EQ(errors.messages, (std::vector<std::string>{"error two"}));
+    // formatted once - both sinks saw the same buffer
+    EXPECT_EQ(verbose.buffers[1], errors.buffers[0]);
+
+    // levels can change and sinks can leave at runtime
+    EXPECT_EQ(acaLogSinkSetLevel(Capture, &errors, ACA_LOG_INFO), 0);
+    EXPECT_EQ(acaLogSinkRemove(Capture, &verbose), 0);
+    EXPECT_EQ(acaLogSinkRemove(Capture, &verbose), -1);
+    ACA_LOG_INFO("info %d", 3);
+    EXPECT_EQ(verbose.messages.size(), 2u);
+    EXPECT_EQ(errors.messages, (std::vector<std::string>{"error two", "info 3"}));
+
+    EXPECT_EQ(acaLogSinkRemove(Capture, &errors), 0);
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, dispatch_stdout_sink) {
+    ASSERT_EQ(acaLogSinkAdd(acaLogStdoutSink, NULL, ACA_LOG_WARN), 0);
+    acaLogSetHandler(acaLogDispatchHandler);
+
+    testing::internal::CaptureStdout();
+    ACA_LOG_INFO("hidden");
+    int line = __LINE__ + 1;
+    ACA_LOG_WARN("shown %d", 5);
+    char expected[128];
+    snprintf(expected,
+             sizeof(expected),
+             "[aca_log_test] [ WARN] [%28s] shown 5\n",
+             ("test_dispatch.cpp:" + std::to_string(line)).c_str());
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), expected);
+
+    EXPECT_EQ(acaLogSinkRemove(acaLogStdoutSink, NULL), 0);
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, dispatch_default_handler) {
+    CaptureSink capture;
+    ASSERT_EQ(acaLogSinkAdd(Capture, &capture, ACA_LOG_TRACE), 0);
+    EXPECT_EQ(acaLogGetDefaultHandler(), acaLogStandardHandler);
+
+    // threads that never set a handler use the process-wide default
+    acaLogSetDefaultHandler(acaLogDispatchHandler);
+    std::thread thread([]() {
+        EXPECT_EQ(acaLogGetHandler(), acaLogDispatchHandler);
+        ACA_LOG_INFO("from thread");
+    });
+    thread.join();
+    EXPECT_EQ(capture.messages, (std::vector<std::string>{"from thread"}));
+
+    // NULL hands the calling thread back to the default
+    acaLogSetHandler(NULL);
+    ACA_LOG_INFO("from main");
+    EXPECT_EQ(capture.messages.size(), 2u);
+
+    acaLogSetDefaultHandler(NULL);
+    EXPECT_EQ(acaLogGetHandler(), acaLogStandardHandler);
+    acaLogSetHandler(acaLogStandardHandler);
+    EXPECT_EQ(acaLogSinkRemove(Capture, &capture), 0);
+}
+
+TEST(log, dispatch_concurrent_updates) {
+    // sinks come and go while other threads log through the dispatcher
+    CaptureSink              sinks[4];
+    std::atomic<bool>        done(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&done]() {
+            acaLogSetHandler(acaLogDispatchHandler);
+            while (!done.load()) {
+                ACA_LOG_INFO("busy");
+            }
+            acaLogSetHandler(acaLogStandardHandler);
+        });
+    }
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_EQ(acaLogSinkAdd(Capture, &sinks[i % 4], ACA_LOG_INFO), 0);
+        if (i >= 2) {
+            EXPECT_EQ(acaLogSinkRemove(Capture, &sinks[(i - 2) % 4]), 0);
+        }
+    }
+    done.store(true);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(acaLogSinkRemove(Capture, &sinks[198 % 4]), 0);
+    EXPECT_EQ(acaLogSinkRemove(Capture, &sinks[199 % 4]), 0);
+    for (auto &sink : sinks) {
+        for (auto &message : sink.messages) {
+            EXPECT_EQ(message, "busy");
+        }
+    }
+}
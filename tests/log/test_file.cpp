@@ -0,0 +1,185 @@
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static std::string ReadFile(const std::string &path) {
+    std::ifstream     in(path.c_str());
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static bool FileExists(const std::string &path) {
+    std::ifstream in(path.c_str());
+    return in.good();
+}
+
+static size_t CountLines(const std::string &str) {
+    size_t count = 0;
+    for (char c : str) {
+        count += (c == '\n');
+    }
+    return count;
+}
+
+TEST(log, buffered_file_handler_flush) {
+    std::string path = testing::TempDir() + "aca_log_buffered.log";
+    std::remove(path.c_str());
+
+    aca_log_file_config config = ACA_LOG_FILE_CONFIG_INIT;
+    config.path                = path.c_str();
+    config.flushInterval       = 0.0;
+    ASSERT_EQ(acaLogFileOpen(&config), 0);
+    acaLogSetHandler(acaLogBufferedFileHandler);
+
+    // records below flushLevel stay in the user-space buffer
+    ACA_LOG_INFO("first");
+    ACA_LOG_WARN("second");
+    EXPECT_EQ(ReadFile(path), "");
+
+    // an ERROR record pushes everything out - earlier lines are kept (no truncation)
+    ACA_LOG_ERROR("third");
+    std::string contents = ReadFile(path);
+    EXPECT_EQ(CountLines(contents), 3u);
+    EXPECT_NE(contents.find("] first\n"), std::string::npos);
+    EXPECT_NE(contents.find("] second\n"), std::string::npos);
+    EXPECT_NE(contents.find("] third\n"), std::string::npos);
+
+    ACA_LOG_DEBUG("fourth");
+    acaLogFileFlush();
+    EXPECT_EQ(CountLines(ReadFile(path)), 4u);
+
+    acaLogFileClose();
+    acaLogSetHandler(acaLogStandardHandler);
+    std::remove(path.c_str());
+}
+
+TEST(log, buffered_file_handler_idle_flush) {
+    std::string path = testing::TempDir() + "aca_log_buffered_idle.log";
+    std::remove(path.c_str());
+
+    aca_log_file_config config = ACA_LOG_FILE_CONFIG_INIT;
+    config.path                = path.c_str();
+    config.flushInterval       = 0.05;
+    ASSERT_EQ(acaLogFileOpen(&config), 0);
+    acaLogSetHandler(acaLogBufferedFileHandler);
+    ACA_LOG_WARN("last words");
+    acaLogSetHandler(acaLogStandardHandler);
+
+    // no further record arrives - the flusher pushes the buffer out on its own
+    for (int i = 0; (i < 200) && ReadFile(path).empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_NE(ReadFile(path).find("] last words\n"), std::string::npos);
+    acaLogFileClose();
+    std::remove(path.c_str());
+}
+
+TEST(log, buffered_file_handler_rotate_size) {
+    std::string path = testing::TempDir() + "aca_log_rotate.log";
+    for (int i = 0; i <= 3; ++i) {
+        std::remove((i == 0 ? path : path + "." + std::to_string(i)).c_str());
+    }
+
+    aca_log_file_config config = ACA_LOG_FILE_CONFIG_INIT;
+    config.path                = path.c_str();
+    config.rotateBytes         = 1024;
+    config.maxFiles            = 2;
+    ASSERT_EQ(acaLogFileOpen(&config), 0);
+    acaLogSetHandler(acaLogBufferedFileHandler);
+
+    for (int i = 0; i < 100; ++i) {
+        ACA_LOG_INFO("rotating record %d", i);
+    }
+    acaLogFileClose();
+    acaLogSetHandler(acaLogStandardHandler);
+
+    // only maxFiles rotated files are retained, each one is rotated right after crossing the limit
+    EXPECT_TRUE(FileExists(path + ".1"));
+    EXPECT_TRUE(FileExists(path + ".2"));
+    EXPECT_FALSE(FileExists(path + ".3"));
+    std::string newest = ReadFile(path + ".1");
+    EXPECT_GE(newest.size(), 1024u);
+    EXPECT_LT(newest.size(), 1024u + 128u);
+    EXPECT_NE(ReadFile(path).find("rotating record 99\n"), std::string::npos);
+
+    for (int i = 0; i <= 2; ++i) {
+        std::remove((i == 0 ? path : path + "." + std::to_string(i)).c_str());
+    }
+}
+
+static double gFakeNow = 0.0;
+
+static double FakeNow(void) {
+    return gFakeNow;
+}
+
+TEST(log, buffered_file_handler_rotate_interval) {
+    std::string path = testing::TempDir() + "aca_log_rotate_interval.log";
+    for (int i = 0; i <= 3; ++i) {
+        std::remove((i == 0 ? path : path + "." + std::to_string(i)).c_str());
+    }
+
+    gFakeNow = 100.0;
+    acaLogSetIntervalClock(FakeNow);
+    aca_log_file_config config = ACA_LOG_FILE_CONFIG_INIT;
+    config.path                = path.c_str();
+    config.flushInterval       = 0.0;
+    config.rotateInterval      = 60.0;
+    config.maxFiles            = 2;
+    ASSERT_EQ(acaLogFileOpen(&config), 0);
+    acaLogSetHandler(acaLogBufferedFileHandler);
+
+    // the file rotates on the first record once it has been open rotateInterval seconds
+    ACA_LOG_INFO("minute 0");
+    gFakeNow += 59.0;
+    ACA_LOG_INFO("minute 1");
+    EXPECT_FALSE(FileExists(path + ".1"));
+    gFakeNow += 1.0;
+    ACA_LOG_INFO("minute 2");
+    gFakeNow += 30.0;
+    ACA_LOG_INFO("minute 2.5");
+    gFakeNow += 30.0;
+    ACA_LOG_INFO("minute 3");
+    acaLogFileClose();
+    acaLogSetHandler(acaLogStandardHandler);
+    acaLogSetIntervalClock(NULL);
+
+    EXPECT_EQ(CountLines(ReadFile(path + ".2")), 2u);
+    EXPECT_NE(ReadFile(path + ".2").find("] minute 1\n"), std::string::npos);
+    EXPECT_EQ(CountLines(ReadFile(path + ".1")), 2u);
+    EXPECT_NE(ReadFile(path + ".1").find("] minute 2.5\n"), std::string::npos);
+    EXPECT_EQ(CountLines(ReadFile(path)), 1u);
+    EXPECT_NE(ReadFile(path).find("] minute 3\n"), std::string::npos);
+
+    for (int i = 0; i <= 2; ++i) {
+        std::remove((i == 0 ? path : path + "." + std::to_string(i)).c_str());
+    }
+}
+
+TEST(log, buffered_file_handler_reopen_keeps_config) {
+    std::string path = testing::TempDir() + "aca_log_reopen.log";
+    std::remove(path.c_str());
+
+    aca_log_file_config config = ACA_LOG_FILE_CONFIG_INIT;
+    config.path                = path.c_str();
+    ASSERT_EQ(acaLogFileOpen(&config), 0);
+    acaLogSetHandler(acaLogBufferedFileHandler);
+    ACA_LOG_INFO("before close");
+    acaLogFileClose();
+
+    // a record after the file was closed opens it again with the same config, not the defaults
+    ACA_LOG_INFO("after close");
+    acaLogFileClose();
+    acaLogSetHandler(acaLogStandardHandler);
+
+    std::string contents = ReadFile(path);
+    EXPECT_EQ(CountLines(contents), 2u);
+    EXPECT_NE(contents.find("] after close\n"), std::string::npos);
+    std::remove(path.c_str());
+}
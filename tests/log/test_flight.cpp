@@ -0,0 +1,171 @@
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+// dumps the flight recorder into a temporary file and returns what was written
+static std::string Dump(size_t *count) {
+    FILE *fp = tmpfile();
+    EXPECT_NE(fp, nullptr);
+    *count = acaLogFlightDump(fileno(fp));
+    std::string contents;
+    char        buffer[4096];
+    size_t      n;
+    rewind(fp);
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        contents.append(buffer, n);
+    }
+    fclose(fp);
+    return contents;
+}
+
+static size_t CountOf(const std::string &str, const std::string &needle) {
+    size_t count = 0;
+    for (size_t pos = str.find(needle); pos != std::string::npos; pos = str.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+TEST(log, flight_recorder_forward) {
+    aca_log_flight_config config = ACA_LOG_FLIGHT_CONFIG_INIT;
+    config.forward               = acaLogBasicHandler;
+    config.forwardLevel          = ACA_LOG_WARN;
+    config.signalHandler         = 0;
+    acaLogFlightStart(&config);
+    acaLogSetHandler(acaLogFlightHandler);
+
+    // everything is recorded, only WARN+ is printed
+    testing::internal::CaptureStdout();
+    ACA_LOG_TRACE("fwd trace %d", 1);
+    ACA_LOG_DEBUG("fwd debug %d", 2);
+    ACA_LOG_WARN("fwd warn %d", 3);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ WARN] fwd warn 3\n");
+
+    size_t      count = 0;
+    std::string dump  = Dump(&count);
+    EXPECT_GE(count, 3u);
+    size_t trace = dump.find("[TRACE] [test_flight.cpp:");
+    size_t debug = dump.find("] fwd debug 2\n");
+    size_t warn  = dump.find("] fwd warn 3\n");
+    EXPECT_EQ(dump.find("---- flight recorder ----\n"), 0u);
+    EXPECT_NE(trace, std::string::npos);
+    EXPECT_LT(trace, debug);
+    EXPECT_LT(debug, warn);
+    EXPECT_NE(warn, std::string::npos);
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, flight_recorder_merge) {
+    aca_log_flight_config config = ACA_LOG_FLIGHT_CONFIG_INIT;
+    config.forward               = NULL;
+    config.signalHandler         = 0;
+    acaLogFlightStart(&config);
+
+    // two threads take turns - the dump interleaves them back in timestamp order
+    std::atomic<int>         turn(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([t, &turn]() {
+            acaLogSetHandler(acaLogFlightHandler);
+            for (int i = 0; i < 10; ++i) {
+                while (turn.load() != (i * 2) + t) {
+                    std::this_thread::yield();
+                }
+                ACA_LOG_DEBUG("merge %02d", (i * 2) + t);
+                turn.store((i * 2) + t + 1);
+            }
+            acaLogSetHandler(acaLogStandardHandler);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    size_t      count = 0;
+    std::string dump  = Dump(&count);
+    size_t      last  = 0;
+    for (int i = 0; i < 20; ++i) {
+        char needle[32];
+        snprintf(needle, sizeof(needle), "] merge %02d\n", i);
+        size_t pos = dump.find(needle);
+        ASSERT_NE(pos, std::string::npos) << needle;
+        EXPECT_GT(pos, last);
+        last = pos;
+    }
+}
+
+TEST(log, flight_recorder_overwrite) {
+    aca_log_flight_config config = ACA_LOG_FLIGHT_CONFIG_INIT;
+    config.forward               = NULL;
+    config.signalHandler         = 0;
+    acaLogFlightStart(&config);
+
+    // the ring keeps the newest records only (default: 2048 per thread)
+    std::thread thread([]() {
+        acaLogSetHandler(acaLogFlightHandler);
+        for (int i = 0; i < 5000; ++i) {
+            ACA_LOG_TRACE("overwrite %d", i);
+        }
+        acaLogSetHandler(acaLogStandardHandler);
+    });
+    thread.join();
+
+    size_t      count = 0;
+    std::string dump  = Dump(&count);
+    EXPECT_EQ(CountOf(dump, "] overwrite "), 2048u);
+    EXPECT_EQ(dump.find("] overwrite 2951\n"), std::string::npos);
+    EXPECT_NE(dump.find("] overwrite 2952\n"), std::string::npos);
+    EXPECT_NE(dump.find("] overwrite 4999\n"), std::string::npos);
+}
+
+#if !defined(_WIN32)
+static void CrashWithFlightRecorder() {
+    aca_log_flight_config config = ACA_LOG_FLIGHT_CONFIG_INIT;
+    config.forward               = NULL;
+    acaLogFlightStart(&config);
+    acaLogSetHandler(acaLogFlightHandler);
+    ACA_LOG_DEBUG("before the crash");
+    raise(SIGABRT);
+}
+
+TEST(log, flight_recorder_signal) {
+    EXPECT_EXIT(CrashWithFlightRecorder(),
+                testing::KilledBySignal(SIGABRT),
+                "\\[DEBUG\\] \\[test_flight.cpp:[0-9]+\\] before the crash\n"
+                "---- flight recorder end");
+}
+
+static volatile size_t gRecurseLimit = ~(size_t)0; // never reached - the stack runs out first
+
+static int Recurse(volatile char *previous, size_t depth) {
+    volatile char frame[4096];
+    frame[0] = (previous != NULL) ? previous[0] : 1;
+    if (depth >= gRecurseLimit) {
+        return frame[0];
+    }
+    return Recurse(frame, depth + 1) + frame[1];
+}
+
+static void OverflowWithFlightRecorder() {
+    aca_log_flight_config config = ACA_LOG_FLIGHT_CONFIG_INIT;
+    config.forward               = NULL;
+    acaLogFlightStart(&config);
+    acaLogSetHandler(acaLogFlightHandler);
+    ACA_LOG_DEBUG("before the overflow");
+    Recurse(NULL, 0);
+}
+
+// the dump runs on the alternate signal stack
+TEST(log, flight_recorder_stack_overflow) {
+    EXPECT_EXIT(OverflowWithFlightRecorder(),
+                testing::KilledBySignal(SIGSEGV),
+                "\\[DEBUG\\] \\[test_flight.cpp:[0-9]+\\] before the overflow\n"
+                "---- flight recorder end");
+}
+#endif // _WIN32
@@ -0,0 +1,106 @@
+#include <cstring>
+#include <string>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+// format checks are constant expressions
+using aca::log::detail::ArgTypes;
+static_assert(ArgTypes<int, double, const char *>::Check("{} {:.2f} {:>}") == false, "bad spec");
+static_assert(ArgTypes<int, double, std::string>::Check("{} {:.2f} {:-8}"), "");
+static_assert(ArgTypes<unsigned, char, bool>::Check("{:#x} {:d} {:s} {{}}"), "");
+static_assert(!ArgTypes<int>::Check("{} {}"), "too few arguments");
+static_assert(!ArgTypes<int, int>::Check("{}"), "too many arguments");
+static_assert(!ArgTypes<int>::Check("{:f}"), "conversion doesn't fit the type");
+static_assert(!ArgTypes<int>::Check("{} }"), "stray brace");
+static_assert(!ArgTypes<int>::Check("{"), "unterminated field");
+static_assert(ArgTypes<>::Check("no fields"), "");
+
+enum Mode { MODE_IDLE, MODE_RUN };
+
+TEST(log, fmt_functions) {
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    std::string name  = "eth0";
+    const char *state = "up";
+    aca::log::info("{} is {} ({} pkts, {} drops, load {})", name, state, 1200u, -1, 0.25);
+    aca::log::warn("flag={} ch={} mode={} ptr={}", true, 'x', MODE_RUN, (void *)nullptr);
+    aca::log::debug("no fields {{}}");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[ INFO] eth0 is up (1200 pkts, -1 drops, load 0.25)\n"
+              "[ WARN] flag=true ch=x mode=1 ptr=(nil)\n"
+              "[DEBUG] no fields {}\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, fmt_large_doubles) {
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    aca::log::info("big {} mid {} small {}", 1e14, 2e13, 1e12);
+    aca::log::info("neg {} frac {}", -5e13, 123456789012.25);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[ INFO] big 100000000000000 mid 20000000000000 small 1000000000000\n"
+              "[ INFO] neg -50000000000000 frac 123456789012.25\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, fmt_specs) {
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    aca::log::info("[{:5}] [{:-5}] [{:05}] [{:+}]", 42, 42, -42, 7);
+    aca::log::info("{:#x} {:X} {:o} {:d} {:c}", 255u, 255, 8, 'A', 66);
+    aca::log::info("{:.3f} {:10.2f} {:e} {:.2}", 3.14159, -2.5, 1e6, 1.0 / 3.0);
+    aca::log::info(
+        "[{:8}] [{:-8}] [{:.3}] [{:s}] [{:d}]", "abc", std::string("ab"), "abcdef", false, true);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[ INFO] [   42] [42   ] [-0042] [+7]\n"
+              "[ INFO] 0xff FF 10 65 B\n"
+              "[ INFO] 3.142      -2.50 1.000000e+06 0.33\n"
+              "[ INFO] [     abc] [ab      ] [abc] [false] [1]\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+static void LogFromFmtSite(int code) {
+    ACA_LOG_FMT(ACA_LOG_ERROR, "code {} from {}", code, "server");
+}
+
+TEST(log, fmt_macro_site) {
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    LogFromFmtSite(404);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ERROR] code 404 from server\n");
+
+    // the site registers with its "{}" format and can be switched off like any other
+    const aca_log_site *site = acaLogSites();
+    while ((site != NULL) && ((site->fmt == NULL) || (strcmp(site->fmt, "code {} from {}") != 0))) {
+        site = site->next;
+    }
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(site->level, ACA_LOG_ERROR);
+    EXPECT_STREQ(site->fileName, "test_fmt.cpp");
+    EXPECT_EQ(acaLogSiteEnable("test_fmt.cpp", site->line, 0), 1u);
+    testing::internal::CaptureStdout();
+    LogFromFmtSite(500);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_EQ(acaLogSiteEnable("test_fmt.cpp", site->line, 1), 1u);
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, fmt_render) {
+    // the C renderer works without the front-end, unmatched fields are copied as they are
+    char        buffer[64];
+    aca_log_arg args[2] = {{ACA_LOG_ARG_TYPE_INT, -12, 0.0, NULL, 0},
+                           {ACA_LOG_ARG_TYPE_STR, 0, 0.0, "abcdef", 3}};
+    EXPECT_EQ(acaLogFormatArgs(buffer, sizeof(buffer), "{} {} {} {x} }", args, 2), 16);
+    EXPECT_STREQ(buffer, "-12 abc {} {x} }");
+    EXPECT_EQ(acaLogFormatArgs(buffer, 4, "{:08}", args, 1), 8);
+    EXPECT_STREQ(buffer, "-00");
+
+    // oversized messages are still delivered in full
+    std::string big(3000, 'y');
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    aca::log::info("{}!", big);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ INFO] " + big + "!\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
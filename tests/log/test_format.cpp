@@ -0,0 +1,95 @@
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+// formats with both acaLogFormat and vsnprintf and expects identical results
+static void ExpectSame(const char *fmt, ...) {
+    char    fast[256];
+    char    libc[256];
+    va_list args;
+    va_start(args, fmt);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int fastLen = acaLogFormat(fast, sizeof(fast), fmt, args);
+    int libcLen = vsnprintf(libc, sizeof(libc), fmt, argsCopy);
+    va_end(argsCopy);
+    va_end(args);
+    EXPECT_EQ(fastLen, libcLen) << fmt;
+    EXPECT_STREQ(fast, libc) << fmt;
+}
+
+TEST(log, format_integers) {
+    ExpectSame("%d %i %u", 0, -42, 4000000000u);
+    ExpectSame("[%5d] [%-5d] [%05d] [%+d] [% d] [%+05d]", 42, 42, -42, 42, 42, -42);
+    ExpectSame("[%.3d] [%8.3d] [%-8.3d] [%.0d] [%08.3d]", 7, -7, 7, 0, 7);
+    ExpectSame("%x %X %#x %#X %#08x %#x", 0xbeefu, 0xbeefu, 0xbeefu, 0xbeefu, 0xbeefu, 0u);
+    ExpectSame("%o %#o %#o %#.0o %#.5o", 8u, 8u, 0u, 0u, 8u);
+    ExpectSame("%hhd %hd %hhu %hu %hhx", 300, 70000, 300, 70000, 511);
+    ExpectSame("%ld %lu %lld %llu %llx", -1L, 1UL, -9223372036854775807LL - 1, ~0ULL, ~0ULL);
+    ExpectSame("%zu %zd %jd %td", (size_t)12345, (ptrdiff_t)-5, (intmax_t)-6, (ptrdiff_t)7);
+    ExpectSame("[%*d] [%-*d] [%.*d] [%*d]", 6, 1, 6, 2, 4, 3, -6, 4);
+    int value = 0;
+    ExpectSame("%p [%20p] [%-20p]", (void *)&value, (void *)&value, (void *)&value);
+}
+
+TEST(log, format_strings) {
+    ExpectSame("%s|%10s|%-10s|%.3s|%5.2s|%.*s", "hello", "hi", "hi", "hello", "hello", 2, "hello");
+    ExpectSame("%c|%3c|%-3c|%%|100%%", 'x', 'y', 'z');
+    ExpectSame("[%10.4f] [%5s] [%28s] ", 1.5, "INFO", "test_format.cpp:42");
+    // not NUL terminated within the precision
+    const char chars[3] = {'a', 'b', 'c'};
+    ExpectSame("%.3s", chars);
+}
+
+TEST(log, format_doubles) {
+    ExpectSame("%f %F %.0f %.1f %.2f %.15f", 3.14159, 2.5, 2.5, 0.05, -1.005, 0.1);
+    ExpectSame("[%10.4f] [%-10.2f] [%+f] [% f]", 12.5, -3.25, 1.0, 1.0);
+    ExpectSame("[%012.3f] [%#.0f] [%-+9.1f]", -2.5, 7.0, 0.25);
+    // exact ties round to even, values just above/below a tie round accordingly
+    ExpectSame("%.0f %.0f %.0f %.0f %.2f %.2f %.2f", 0.5, 1.5, 2.5, -3.5, 0.125, 0.375, 0.135);
+    ExpectSame("%f %.3f %f", -0.0, -0.0001, 999999999999.9999);
+    ExpectSame("%.*f %.*f", 3, 1.0 / 3.0, 0, 9.5);
+
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t bits = rng();
+        double   value;
+        memcpy(&value, &bits, sizeof(value));
+        if ((i % 2) == 0) {
+            value = (double)(int64_t)rng() / (double)(1ULL << (rng() % 60));
+        }
+        ExpectSame("%.*f", (int)(rng() % 16), value);
+    }
+}
+
+TEST(log, format_fallback) {
+    // specifiers the fast path doesn't cover still come out exactly like vsnprintf
+    ExpectSame("%e %g %a %G", 12345.678, 0.0001, 1.0, 1e20);
+    ExpectSame("%p %s", (void *)NULL, (const char *)NULL);
+    ExpectSame("%f %f %f %.20f %f", 1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0, 0.1, 1e300);
+    ExpectSame("%d then %Lf", 1, (long double)2.5);
+    ExpectSame("%05s %lc", "ab", (wint_t)'w');
+}
+
+TEST(log, format_truncation) {
+    char buffer[8];
+    EXPECT_EQ(acaLogFormatf(buffer, sizeof(buffer), "%d-%s", 123456, "abc"), 10);
+    EXPECT_STREQ(buffer, "123456-");
+    EXPECT_EQ(acaLogFormatf(buffer, 1, "%s", "abc"), 3);
+    EXPECT_STREQ(buffer, "");
+    EXPECT_EQ(acaLogFormatf(NULL, 0, "%10.4f", 1.0), 10);
+
+    // oversized messages still reach the handlers in full
+    std::string big(3000, 'x');
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    ACA_LOG_INFO("%s %d", big.c_str(), 1);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ INFO] " + big + " 1\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <string>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static const char *kLevels[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+// writes count standard lines 10 ms apart - every 1000th record is a WARN spanning two lines
+static void WriteRecords(FILE *fp, int first, int count) {
+    for (int i = first; i < first + count; ++i) {
+        int level = ((i % 1000) == 0) ? ACA_LOG_WARN : (i % 3);
+        fprintf(fp,
+                "[app] [%10.4f] [%5s] [%28s] record %d%s\n",
+                i * 0.01,
+                kLevels[level],
+                "main.c:42",
+                i,
+                (level == ACA_LOG_WARN) ? "\n  [continued] detail" : "");
+    }
+    fflush(fp);
+}
+
+static std::string Query(FILE *log, FILE *index, double from, double to, aca_log_level minLevel,
+                         long *records, size_t *scanned) {
+    FILE *out = tmpfile();
+    *records  = acaLogIndexQuery(log, index, from, to, minLevel, out, scanned);
+    std::string text;
+    char        buffer[256];
+    rewind(out);
+    while (fgets(buffer, sizeof(buffer), out) != NULL) {
+        text += buffer;
+    }
+    fclose(out);
+    return text;
+}
+
+static long FileSize(FILE *fp) {
+    fseek(fp, 0, SEEK_END);
+    return ftell(fp);
+}
+
+TEST(log, index_query) {
+    FILE *log   = tmpfile();
+    FILE *index = tmpfile();
+    WriteRecords(log, 0, 20000);
+    ASSERT_EQ(acaLogIndexBuild(log, index, 4096), 0);
+    EXPECT_GT(FileSize(index), 16);
+
+    // the index narrows the scan down to the blocks around the window
+    long        records = 0;
+    size_t      scanned = 0;
+    std::string text    = Query(log, index, 100.0, 100.5, ACA_LOG_TRACE, &records, &scanned);
+    EXPECT_EQ(records, 51);
+    EXPECT_EQ(text.find("[  100.0000] [ WARN] "), 6u);
+    EXPECT_NE(text.find("record 10000\n  [continued] detail\n[app]"), std::string::npos);
+    EXPECT_NE(text.find("record 10050\n"), std::string::npos);
+    EXPECT_EQ(text.find("record 10051\n"), std::string::npos);
+    EXPECT_LT(scanned, 3u * 4096u);
+
+    // same records as a scan of the whole log
+    size_t      fullScan = 0;
+    std::string full     = Query(log, NULL, 100.0, 100.5, ACA_LOG_TRACE, &records, &fullScan);
+    EXPECT_EQ(full, text);
+    EXPECT_EQ(fullScan, (size_t)FileSize(log));
+
+    // level filter - only blocks holding a WARN (or worse) record are read
+    text = Query(log, index, 0.0, 1000.0, ACA_LOG_WARN, &records, &scanned);
+    EXPECT_EQ(records, 20);
+    EXPECT_EQ(text.find("[ WARN] [                   main.c:42] record 0\n  [continued]"), 19u);
+    EXPECT_LT(scanned, (size_t)FileSize(log) / 2);
+    text = Query(log, index, 0.0, 1000.0, ACA_LOG_ERROR, &records, &scanned);
+    EXPECT_EQ(records, 0);
+    EXPECT_EQ(scanned, 0u);
+    fclose(index);
+    fclose(log);
+}
+
+TEST(log, index_unindexed) {
+    FILE *log   = tmpfile();
+    FILE *index = tmpfile();
+    WriteRecords(log, 0, 1000);
+    ASSERT_EQ(acaLogIndexBuild(log, index, 1024), 0);
+
+    // records appended after the index was written are found in the unindexed tail
+    WriteRecords(log, 1000, 10);
+    long        records = 0;
+    size_t      scanned = 0;
+    std::string text    = Query(log, index, 10.0, 10.1, ACA_LOG_TRACE, &records, &scanned);
+    EXPECT_EQ(records, 10);
+    EXPECT_NE(text.find("record 1000\n"), std::string::npos);
+    EXPECT_NE(text.find("record 1009\n"), std::string::npos);
+
+    // an index that runs past the end of the log is refused
+    FILE *other = tmpfile();
+    WriteRecords(other, 0, 10);
+    EXPECT_EQ(Query(other, index, 0.0, 1.0, ACA_LOG_TRACE, &records, &scanned), "");
+    EXPECT_EQ(records, -1);
+    FILE *bogus = tmpfile();
+    fputs("not an index", bogus);
+    Query(log, bogus, 0.0, 1.0, ACA_LOG_TRACE, &records, &scanned);
+    EXPECT_EQ(records, -1);
+    fclose(bogus);
+    fclose(other);
+    fclose(index);
+    fclose(log);
+}
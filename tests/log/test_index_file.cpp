@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static const char *kLog   = "aca_log_index_test.log";
+static const char *kIndex = "aca_log_index_test.log.idx";
+
+static double UnixNow() {
+    using namespace std::chrono;
+    return duration<double>(system_clock::now().time_since_epoch()).count();
+}
+
+// one run of a program logging through the indexed standard file handler - the index is
+// completed by the exit handler
+static void LogRun(int run) {
+    acaLogSetHandler(acaLogStandardFileHandler);
+    for (int i = 0; i < 100; ++i) {
+        if ((i % 10) == 0) {
+            ACA_LOG_WARN("run %d record %d", run, i);
+        } else {
+            ACA_LOG_INFO("run %d record %d", run, i);
+        }
+    }
+    exit(0);
+}
+
+static std::string Query(double from, double to, aca_log_level minLevel, long *records) {
+    FILE *log   = fopen(kLog, "rb");
+    FILE *index = fopen(kIndex, "rb");
+    FILE *out   = tmpfile();
+    *records    = -1;
+    if ((log != NULL) && (index != NULL) && (out != NULL)) {
+        *records = acaLogIndexQuery(log, index, from, to, minLevel, out, NULL);
+    }
+    std::string text;
+    char        buffer[256];
+    rewind(out);
+    while (fgets(buffer, sizeof(buffer), out) != NULL) {
+        text += buffer;
+    }
+    fclose(out);
+    if (index != NULL) {
+        fclose(index);
+    }
+    if (log != NULL) {
+        fclose(log);
+    }
+    return text;
+}
+
+TEST(log, index_file_handler) {
+    std::remove(kLog);
+    std::remove(kIndex);
+
+    // two runs append to the same log, both restart their timestamps at 0
+    double start = UnixNow();
+    EXPECT_EXIT(LogRun(1), testing::ExitedWithCode(0), "");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    double between = UnixNow();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EXIT(LogRun(2), testing::ExitedWithCode(0), "");
+    double end = UnixNow();
+
+    // the handler's index is queried in unix time, which tells the runs apart
+    long        records = 0;
+    std::string text    = Query(start - 1.0, end + 1.0, ACA_LOG_TRACE, &records);
+    EXPECT_EQ(records, 200);
+    text = Query(between, end + 1.0, ACA_LOG_WARN, &records);
+    EXPECT_EQ(records, 10);
+    EXPECT_EQ(text.find("run 1 "), std::string::npos);
+    EXPECT_NE(text.find("[ WARN] "), std::string::npos);
+    EXPECT_NE(text.find("run 2 record 90\n"), std::string::npos);
+    text = Query(start - 1.0, between, ACA_LOG_TRACE, &records);
+    EXPECT_EQ(records, 100);
+    EXPECT_EQ(text.find("run 2 "), std::string::npos);
+
+    // the log's own timestamps are near 0 in both runs
+    Query(0.0, 1000.0, ACA_LOG_TRACE, &records);
+    EXPECT_EQ(records, 0);
+    std::remove(kLog);
+    std::remove(kIndex);
+}
@@ -0,0 +1,109 @@
+#include <string>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static std::string Expected(const char *fmt, int line) {
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), fmt, line);
+    return buffer;
+}
+
+TEST(log, kv_json) {
+    acaLogSetHandler(acaLogJsonHandler);
+
+    testing::internal::CaptureStdout();
+    int line = __LINE__ + 1;
+    ACA_LOG_KV(ACA_LOG_INFO,
+               "user \"bob\" logged in",
+               ACA_LOG_KV_STR("user", "bob\n"),
+               ACA_LOG_KV_INT("id", -42),
+               ACA_LOG_KV_UINT("bytes", 18446744073709551615ULL),
+               ACA_LOG_KV_DOUBLE("load", 0.75),
+               ACA_LOG_KV_BOOL("admin", 1));
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              Expected("{\"tag\":\"aca_log_test\",\"level\":\"INFO\",\"file\":\"test_kv.cpp\","
+                       "\"line\":%d,\"msg\":\"user \\\"bob\\\" logged in\",\"user\":\"bob\\n\","
+                       "\"id\":-42,\"bytes\":18446744073709551615,\"load\":0.75,\"admin\":true}\n",
+                       line));
+
+    // plain records become a message without fields
+    testing::internal::CaptureStdout();
+    line = __LINE__ + 1;
+    ACA_LOG_WARN("tab\there %d", 7);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              Expected("{\"tag\":\"aca_log_test\",\"level\":\"WARN\",\"file\":\"test_kv.cpp\","
+                       "\"line\":%d,\"msg\":\"tab\\there 7\"}\n",
+                       line));
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, kv_logfmt) {
+    acaLogSetHandler(acaLogLogfmtHandler);
+
+    testing::internal::CaptureStdout();
+    int line = __LINE__ + 1;
+    ACA_LOG_KV(ACA_LOG_ERROR,
+               "disk full",
+               ACA_LOG_KV_STR("path", "/var/log"),
+               ACA_LOG_KV_STR("reason", "no space"),
+               ACA_LOG_KV_STR("empty", ""),
+               ACA_LOG_KV_DOUBLE("pct", 99.5),
+               ACA_LOG_KV_DOUBLE("tiny", 0.0000125));
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              Expected("tag=aca_log_test level=ERROR file=test_kv.cpp line=%d msg=\"disk full\" "
+                       "path=/var/log reason=\"no space\" empty=\"\" pct=99.5 tiny=1.25e-05\n",
+                       line));
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, kv_large_doubles) {
+    // fixed notation up to 1e15 without overflowing the scaled integer, %g above
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    ACA_LOG_KV(ACA_LOG_INFO,
+               "big",
+               ACA_LOG_KV_DOUBLE("a", 5e13),
+               ACA_LOG_KV_DOUBLE("b", 1e14),
+               ACA_LOG_KV_DOUBLE("c", 9.99e14),
+               ACA_LOG_KV_DOUBLE("d", -123456789012.5),
+               ACA_LOG_KV_DOUBLE("e", 2.9999999),
+               ACA_LOG_KV_DOUBLE("f", 1e15));
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[ INFO] big a=50000000000000 b=100000000000000 c=999000000000000 "
+              "d=-123456789012.5 e=3 f=1e+15\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, kv_text_handler) {
+    // non-structured handlers get the fields appended as logfmt
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    ACA_LOG_KV(
+        ACA_LOG_INFO, "connected", ACA_LOG_KV_STR("host", "a b"), ACA_LOG_KV_INT("port", 80));
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ INFO] connected host=\"a b\" port=80\n");
+
+    acaLogSetLevel(ACA_LOG_ERROR);
+    testing::internal::CaptureStdout();
+    ACA_LOG_KV(ACA_LOG_INFO, "filtered", ACA_LOG_KV_INT("x", 1));
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    acaLogSetLevel(ACA_LOG_TRACE);
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, kv_truncated) {
+    // oversized records are cut short but stay valid JSON
+    acaLogSetHandler(acaLogJsonHandler);
+    std::string longMsg(4000, 'm');
+    std::string longValue(4000, 'v');
+    testing::internal::CaptureStdout();
+    ACA_LOG_KV(ACA_LOG_INFO,
+               longMsg.c_str(),
+               ACA_LOG_KV_INT("kept", 1),
+               ACA_LOG_KV_STR("dropped", longValue.c_str()));
+    std::string captured = testing::internal::GetCapturedStdout();
+    EXPECT_LE(captured.size(), 1024u);
+    EXPECT_NE(captured.find("\",\"kept\":1,\"truncated\":true}\n"), std::string::npos);
+    EXPECT_EQ(captured.find("dropped"), std::string::npos);
+    acaLogSetHandler(acaLogStandardHandler);
+}
@@ -0,0 +1,53 @@
+// compile-time cutoff only applies to this translation unit's macros
+#define ACA_LOG_MIN_LEVEL 2
+
+#include <string>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static int g_evalCount = 0;
+
+static int CountEval(int value) {
+    ++g_evalCount;
+    return value;
+}
+
+static std::string CaptureInfoAndDebug() {
+    testing::internal::CaptureStdout();
+    ACA_LOG_DEBUG("debug %d", CountEval(1));
+    ACA_LOG_INFO("info %d", CountEval(2));
+    ACA_LOG_ERROR("error %d", CountEval(3));
+    return testing::internal::GetCapturedStdout();
+}
+
+TEST(log, compile_time_level) {
+    acaLogSetHandler(acaLogBasicHandler);
+    acaLogSetLevel(ACA_LOG_TRACE);
+    g_evalCount = 0;
+
+    // DEBUG is below ACA_LOG_MIN_LEVEL - compiled away, args never evaluated
+    EXPECT_EQ(CaptureInfoAndDebug(), "[ INFO] info 2\n[ERROR] error 3\n");
+    EXPECT_EQ(g_evalCount, 2);
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, runtime_level) {
+    acaLogSetHandler(acaLogBasicHandler);
+    g_evalCount = 0;
+
+    acaLogSetLevel(ACA_LOG_WARN);
+    EXPECT_EQ(acaLogGetLevel(), ACA_LOG_WARN);
+    EXPECT_EQ(CaptureInfoAndDebug(), "[ERROR] error 3\n");
+    EXPECT_EQ(g_evalCount, 1);
+
+    // direct acaLog calls are filtered as well
+    testing::internal::CaptureStdout();
+    acaLog(ACA_LOG_INFO, __FILE__, __LINE__, "skipped");
+    acaLog(ACA_LOG_WARN, __FILE__, __LINE__, "kept");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ WARN] kept\n");
+
+    acaLogSetLevel(ACA_LOG_TRACE);
+    EXPECT_EQ(CaptureInfoAndDebug(), "[ INFO] info 2\n[ERROR] error 3\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
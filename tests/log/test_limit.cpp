@@ -0,0 +1,116 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static int CountLines(const std::string &str, const std::string &needle) {
+    int    count = 0;
+    size_t pos   = 0;
+    while ((pos = str.find(needle, pos)) != std::string::npos) {
+        ++count;
+        pos += needle.size();
+    }
+    return count;
+}
+
+TEST(log, limit_every_n) {
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    for (int i = 0; i < 10; ++i) {
+        ACA_LOG_EVERY_N(ACA_LOG_WARN, 4, "packet %d", i);
+    }
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[ WARN] packet 0\n"
+              "[ WARN] packet 4 [suppressed 3 message(s)]\n"
+              "[ WARN] packet 8 [suppressed 3 message(s)]\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, limit_first_n) {
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    for (int i = 0; i < 10; ++i) {
+        ACA_LOG_FIRST_N(ACA_LOG_INFO, 2, "startup %d", i);
+    }
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ INFO] startup 0\n[ INFO] startup 1\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+static double gFakeNow = 0.0;
+
+static double FakeNow(void) {
+    return gFakeNow;
+}
+
+TEST(log, limit_every_ms) {
+    gFakeNow = 1000.0;
+    acaLogSetIntervalClock(FakeNow);
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+            ACA_LOG_EVERY_MS(ACA_LOG_ERROR, 50, "storm");
+            gFakeNow += 0.00001; // the whole round takes 10 ms
+        }
+        gFakeNow += 0.05;
+    }
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[ERROR] storm\n[ERROR] storm [suppressed 999 message(s)]\n");
+    acaLogSetHandler(acaLogStandardHandler);
+    acaLogSetIntervalClock(NULL);
+}
+
+TEST(log, limit_tokens) {
+    gFakeNow = 1000.0;
+    acaLogSetIntervalClock(FakeNow);
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    for (int i = 0; i < 100; ++i) {
+        ACA_LOG_TOKENS(ACA_LOG_WARN, 10, 5, "burst");
+    }
+    std::string captured = testing::internal::GetCapturedStdout();
+    EXPECT_EQ(CountLines(captured, "burst"), 5);
+    EXPECT_EQ(CountLines(captured, "suppressed"), 0);
+
+    // after a refill the next record reports what was skipped in the meantime
+    gFakeNow += 0.15;
+    size_t        suppressed = 0;
+    aca_log_limit limit      = ACA_LOG_LIMIT_INIT;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(acaLogLimit(&limit, ACA_LOG_LIMIT_TOKENS, 10, 3, &suppressed));
+    }
+    EXPECT_FALSE(acaLogLimit(&limit, ACA_LOG_LIMIT_TOKENS, 10, 3, &suppressed));
+    gFakeNow += 0.09; // one token refills every 100 ms
+    EXPECT_FALSE(acaLogLimit(&limit, ACA_LOG_LIMIT_TOKENS, 10, 3, &suppressed));
+    gFakeNow += 0.011;
+    EXPECT_TRUE(acaLogLimit(&limit, ACA_LOG_LIMIT_TOKENS, 10, 3, &suppressed));
+    EXPECT_EQ(suppressed, 2u);
+    acaLogSetHandler(acaLogStandardHandler);
+    acaLogSetIntervalClock(NULL);
+}
+
+TEST(log, limit_threads) {
+    aca_log_limit            limit = ACA_LOG_LIMIT_INIT;
+    std::atomic<size_t>      emitted(0);
+    std::atomic<size_t>      skipped(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            size_t suppressed = 0;
+            for (int i = 0; i < 10000; ++i) {
+                if (acaLogLimit(&limit, ACA_LOG_LIMIT_EVERY_N, 100, 0, &suppressed)) {
+                    emitted += 1;
+                    skipped += suppressed;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(emitted.load(), 400u);
+    EXPECT_EQ(skipped.load(), 399u * 99u);
+}
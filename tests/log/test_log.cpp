@@ -1,4 +1,7 @@
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "aca_log.h"
 #include "gtest/gtest.h"
@@ -124,3 +127,45 @@ TEST(log, default_handler) {
     std::string longInput(256, 'z');
     LOG_TEST(INFO, EXPECTED11, "%s", longInput.c_str());
 }
+
+TEST(log, oversized_line) {
+    // lines longer than the per-thread line buffer go through the heap fallback
+    std::string longInput(3 * 4096, 'y');
+    acaLogSetHandler(acaLogBasicHandler);
+    LOG_TEST(INFO, ("[ INFO] " + longInput + "\n").c_str(), "%s", longInput.c_str());
+
+    acaLogSetHandler(acaLogStandardHandler);
+    std::string expected = "[aca_log_test] [ INFO] [            test_log.cpp:" +
+                           std::to_string(__LINE__ + 1) + "] " + longInput + "\n";
+    LOG_TEST(INFO, expected.c_str(), "%s", longInput.c_str());
+}
+
+TEST(log, atomic_lines) {
+    acaLogSetHandler(acaLogStandardHandler);
+
+    // each record is a single fwrite, so lines from different threads never interleave
+    testing::internal::CaptureStdout();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([t]() {
+            acaLogSetHandler(acaLogBasicHandler);
+            for (int i = 0; i < 500; ++i) {
+                ACA_LOG_INFO("thread %d record %d %s", t, i, "payload-payload-payload");
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    std::string        captured = testing::internal::GetCapturedStdout();
+    std::istringstream lines(captured);
+    std::string        line;
+    size_t             count = 0;
+    while (std::getline(lines, line)) {
+        int         t, i;
+        const char *pattern = "[ INFO] thread %d record %d payload-payload-payload";
+        EXPECT_EQ(sscanf(line.c_str(), pattern, &t, &i), 2) << line;
+        ++count;
+    }
+    EXPECT_EQ(count, 8u * 500u);
+}
@@ -0,0 +1,207 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static std::string RoundTrip(const std::string &raw) {
+    std::vector<char> packed(raw.size() + (raw.size() / 255) + 16); // incompressible worst case
+    size_t packedLen = acaLogLzCompress(raw.data(), raw.size(), packed.data(), packed.size());
+    EXPECT_NE(packedLen, 0u);
+    std::string out(raw.size(), '\0');
+    EXPECT_EQ(acaLogLzDecompress(packed.data(), packedLen, &out[0], out.size()), 0);
+    return out;
+}
+
+// decodes a whole compressed log file
+static std::string Decode(const std::string &path, int *ret) {
+    FILE *in  = fopen(path.c_str(), "rb");
+    FILE *out = tmpfile();
+    EXPECT_NE(in, nullptr);
+    *ret = acaLogLzDecode(in, out);
+    fclose(in);
+    std::string text;
+    char        buffer[4096];
+    size_t      n;
+    rewind(out);
+    while ((n = fread(buffer, 1, sizeof(buffer), out)) > 0) {
+        text.append(buffer, n);
+    }
+    fclose(out);
+    return text;
+}
+
+static size_t CountLines(const std::string &str) {
+    size_t count = 0;
+    for (char c : str) {
+        count += (c == '\n');
+    }
+    return count;
+}
+
+static long FileSize(const std::string &path) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+TEST(log, lz_round_trip) {
+    std::mt19937 rng(7);
+    std::string  random(100000, '\0');
+    for (char &c : random) {
+        c = (char)rng();
+    }
+    std::string runs(70000, 'a'); // overlapping matches and offsets past the 64 KiB window
+    for (size_t i = 0; i < runs.size(); i += 997) {
+        runs[i] = (char)('a' + (i % 26));
+    }
+    const std::string inputs[] = {"", "x", "abcabcabcabcabcabc", random, runs, random + runs};
+    for (const std::string &raw : inputs) {
+        EXPECT_EQ(RoundTrip(raw), raw);
+    }
+
+    // incompressible input doesn't fit a smaller buffer, corrupt input is rejected
+    char small[64];
+    EXPECT_EQ(acaLogLzCompress(random.data(), random.size(), small, sizeof(small)), 0u);
+    char out[32];
+    EXPECT_EQ(acaLogLzDecompress("\x10", 1, out, 1), -1);            // literals missing
+    EXPECT_EQ(acaLogLzDecompress("\x10x\x05\x00", 4, out, 5), -1);   // offset before the start
+    EXPECT_EQ(acaLogLzDecompress("\x10x\x01\x00", 4, out, 32), -1);  // too short
+}
+
+TEST(log, lz_handler) {
+    std::string path = testing::TempDir() + "aca_log_lz.log.lz";
+    std::remove(path.c_str());
+
+    aca_log_lz_config config = ACA_LOG_LZ_CONFIG_INIT;
+    config.path              = path.c_str();
+    config.blockSize         = 16 * 1024;
+    config.flushInterval     = 0.0;
+    ASSERT_EQ(acaLogLzOpen(&config), 0);
+    acaLogSetHandler(acaLogLzHandler);
+
+    // records stay in the block until it fills up or a record at/above flushLevel arrives
+    ACA_LOG_INFO("first");
+    EXPECT_EQ(FileSize(path), 0);
+    ACA_LOG_ERROR("second");
+    EXPECT_GT(FileSize(path), 0);
+
+    std::string expected;
+    for (int i = 0; i < 20000; ++i) {
+        ACA_LOG_INFO("request %d from 10.0.0.%d served in %d us", i, i % 7, 100 + (i % 50));
+    }
+    std::string big(40000, 'z'); // longer than a block - written as a frame of its own
+    ACA_LOG_WARN("%s", big.c_str());
+    acaLogLzClose();
+    acaLogSetHandler(acaLogStandardHandler);
+
+    int         ret  = 0;
+    std::string text = Decode(path, &ret);
+    EXPECT_EQ(ret, 0);
+    EXPECT_LT(text.find("] first\n"), text.find("] second\n"));
+    EXPECT_NE(text.find("] request 0 from 10.0.0.0 served in 100 us\n"), std::string::npos);
+    EXPECT_NE(text.find("] request 19999 from 10.0.0.0 served in 149 us\n"), std::string::npos);
+    EXPECT_NE(text.find("] " + big + "\n"), std::string::npos);
+    EXPECT_EQ(CountLines(text), 20003u);
+
+    // repetitive log text compresses well
+    long packed = FileSize(path);
+    EXPECT_LT(packed * 5, (long)text.size()) << packed << " of " << text.size();
+    std::remove(path.c_str());
+}
+
+TEST(log, lz_resync) {
+    std::string path = testing::TempDir() + "aca_log_lz_sync.log.lz";
+    std::remove(path.c_str());
+
+    aca_log_lz_config config = ACA_LOG_LZ_CONFIG_INIT;
+    config.path              = path.c_str();
+    config.blockSize         = 4096;
+    ASSERT_EQ(acaLogLzOpen(&config), 0);
+    acaLogSetHandler(acaLogLzHandler);
+    for (int i = 0; i < 2000; ++i) {
+        ACA_LOG_INFO("line %05d", i);
+    }
+    acaLogLzClose();
+    acaLogSetHandler(acaLogStandardHandler);
+
+    // damage a byte in the middle of the file - only the frame holding it is lost
+    long  size = FileSize(path);
+    FILE *fp   = fopen(path.c_str(), "r+b");
+    fseek(fp, size / 2, SEEK_SET);
+    int c = fgetc(fp);
+    fseek(fp, size / 2, SEEK_SET);
+    fputc(c ^ 0x5a, fp);
+    fclose(fp);
+    int         ret  = 0;
+    std::string text = Decode(path, &ret);
+    EXPECT_EQ(ret, -1);
+    EXPECT_NE(text.find("] line 00000\n"), std::string::npos);
+    EXPECT_NE(text.find("] line 01999\n"), std::string::npos);
+    EXPECT_LT(CountLines(text), 2000u);
+    EXPECT_GT(CountLines(text), 1900u);
+
+    // tailing - start anywhere, decoding picks up at the next frame
+    FILE *in = fopen(path.c_str(), "rb");
+    fseek(in, size - 100, SEEK_SET);
+    EXPECT_EQ(acaLogLzSync(in), -1); // no frame starts within the last 100 bytes
+    fseek(in, size - 1500, SEEK_SET);
+    long long frame = acaLogLzSync(in);
+    EXPECT_GT(frame, size - 1500);
+    EXPECT_EQ(ftell(in), frame);
+    FILE *out = tmpfile();
+    EXPECT_EQ(acaLogLzDecode(in, out), 0);
+    EXPECT_GT(ftell(out), 0);
+    fclose(out);
+    fclose(in);
+    std::remove(path.c_str());
+}
+
+TEST(log, lz_idle_flush) {
+    std::string path = testing::TempDir() + "aca_log_lz_idle.log.lz";
+    std::remove(path.c_str());
+
+    aca_log_lz_config config = ACA_LOG_LZ_CONFIG_INIT;
+    config.path              = path.c_str();
+    config.flushInterval     = 0.05;
+    ASSERT_EQ(acaLogLzOpen(&config), 0);
+    acaLogSetHandler(acaLogLzHandler);
+    ACA_LOG_INFO("alone in the block");
+    acaLogSetHandler(acaLogStandardHandler);
+
+    // no further record arrives - the flusher writes the block out on its own
+    for (int i = 0; (i < 200) && (FileSize(path) == 0); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    int         ret  = 0;
+    std::string text = Decode(path, &ret);
+    EXPECT_EQ(ret, 0);
+    EXPECT_NE(text.find("] alone in the block\n"), std::string::npos);
+    acaLogLzClose();
+    std::remove(path.c_str());
+}
+
+TEST(log, lz_oversized_frame) {
+    std::string path = testing::TempDir() + "aca_log_lz_oversized.log.lz";
+
+    // a header claiming 1 GiB of raw data is rejected rather than allocated
+    FILE *fp = fopen(path.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    uint32_t header[4] = {0, 0x40000000u, 16, 0};
+    memcpy(&header[0], "\xacLZ1", 4);
+    fwrite(header, 1, sizeof(header), fp);
+    fwrite(std::string(16, 'x').data(), 1, 16, fp);
+    fclose(fp);
+    int ret = 0;
+    EXPECT_EQ(Decode(path, &ret), "");
+    EXPECT_EQ(ret, -1);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,121 @@
+#if !defined(_WIN32)
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static std::string ReadFile(const std::string &path) {
+    std::ifstream     in(path.c_str(), std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static std::string SegmentPath(const std::string &path, int index) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%06d", index);
+    return path + suffix;
+}
+
+static void RemoveSegments(const std::string &path) {
+    for (int i = 0; i < 64; ++i) {
+        std::remove(SegmentPath(path, i).c_str());
+    }
+}
+
+static size_t CountLines(const std::string &str) {
+    size_t count = 0;
+    for (char c : str) {
+        count += (c == '\n');
+    }
+    return count;
+}
+
+TEST(log, mmap_handler_segment) {
+    std::string path = testing::TempDir() + "aca_log_mmap.log";
+    RemoveSegments(path);
+
+    aca_log_mmap_config config = ACA_LOG_MMAP_CONFIG_INIT;
+    config.path                = path.c_str();
+    config.segmentSize         = 64 * 1024;
+    ASSERT_EQ(acaLogMmapOpen(&config), 0);
+    acaLogSetHandler(acaLogMmapHandler);
+
+    // the segment is preallocated - data ends at the first NUL byte
+    ACA_LOG_INFO("first");
+    ACA_LOG_WARN("second %d", 2);
+    std::string contents = ReadFile(SegmentPath(path, 0));
+    EXPECT_EQ(contents.size(), 64u * 1024u);
+    EXPECT_EQ(ReadFile(SegmentPath(path, 1)).size(), 64u * 1024u); // the preallocated spare
+    std::string data = contents.substr(0, contents.find('\0'));
+    EXPECT_EQ(CountLines(data), 2u);
+    EXPECT_NE(data.find("] first\n"), std::string::npos);
+    EXPECT_NE(data.find("] second 2\n"), std::string::npos);
+
+    // a clean close trims the segment to its data and removes the spare
+    acaLogMmapClose();
+    EXPECT_EQ(ReadFile(SegmentPath(path, 0)), data);
+    EXPECT_NE(access(SegmentPath(path, 1).c_str(), F_OK), 0);
+
+    // records after close are dropped, reopening continues with the next segment
+    ACA_LOG_INFO("dropped");
+    ASSERT_EQ(acaLogMmapOpen(&config), 0);
+    ACA_LOG_INFO("third");
+    acaLogMmapClose();
+    EXPECT_EQ(ReadFile(SegmentPath(path, 0)), data);
+    EXPECT_NE(ReadFile(SegmentPath(path, 1)).find("] third\n"), std::string::npos);
+
+    acaLogSetHandler(acaLogStandardHandler);
+    RemoveSegments(path);
+}
+
+TEST(log, mmap_handler_roll) {
+    std::string path = testing::TempDir() + "aca_log_mmap_roll.log";
+    RemoveSegments(path);
+
+    aca_log_mmap_config config = ACA_LOG_MMAP_CONFIG_INIT;
+    config.path                = path.c_str();
+    config.segmentSize         = 16 * 1024;
+    ASSERT_EQ(acaLogMmapOpen(&config), 0);
+
+    // several threads fill multiple segments - every line lands intact in exactly one of them
+    const int                kThreads = 4;
+    const int                kLines   = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t]() {
+            acaLogSetHandler(acaLogMmapHandler);
+            for (int i = 0; i < kLines; ++i) {
+                ACA_LOG_INFO("thread %d line %04d", t, i);
+            }
+            acaLogSetHandler(acaLogStandardHandler);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    acaLogMmapClose();
+
+    size_t segments = 0;
+    size_t lines    = 0;
+    for (int i = 0; i < 64; ++i) {
+        std::string contents = ReadFile(SegmentPath(path, i));
+        if (contents.empty()) {
+            break;
+        }
+        EXPECT_EQ(contents.find('\0'), std::string::npos);
+        EXPECT_EQ(contents.back(), '\n');
+        lines += CountLines(contents);
+        ++segments;
+    }
+    EXPECT_GT(segments, 1u);
+    EXPECT_EQ(lines, (size_t)(kThreads * kLines));
+    RemoveSegments(path);
+}
+#endif // _WIN32
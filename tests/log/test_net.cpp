@@ -0,0 +1,169 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+// every datagram waiting on the receiver
+static std::vector<std::string> Receive(int fd) {
+    std::vector<std::string> datagrams;
+    char                     buffer[65536];
+    ssize_t                  n;
+    while ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) >= 0) {
+        datagrams.push_back(std::string(buffer, (size_t)n));
+    }
+    return datagrams;
+}
+
+static size_t CountLines(const std::vector<std::string> &datagrams) {
+    size_t count = 0;
+    for (const std::string &datagram : datagrams) {
+        for (char c : datagram) {
+            count += (c == '\n');
+        }
+    }
+    return count;
+}
+
+TEST(log, net_handler_batches) {
+    std::string address = "unix:" + testing::TempDir() + "aca_log_net.sock";
+    int         fd      = acaLogNetBind(address.c_str());
+    ASSERT_GE(fd, 0);
+
+    aca_log_net_config config = ACA_LOG_NET_CONFIG_INIT;
+    config.address            = address.c_str();
+    config.datagramSize       = 256;
+    config.batch              = 4;
+    config.flushInterval      = 0.0;
+    ASSERT_EQ(acaLogNetOpen(&config), 0);
+    acaLogSetHandler(acaLogNetHandler);
+
+    // nothing is sent until the batch fills up or a record at/above flushLevel arrives
+    for (int i = 0; i < 10; ++i) {
+        ACA_LOG_INFO("record %d", i);
+    }
+    EXPECT_TRUE(Receive(fd).empty());
+    ACA_LOG_ERROR("flush");
+    std::vector<std::string> datagrams = Receive(fd);
+    EXPECT_EQ(CountLines(datagrams), 11u);
+    EXPECT_GT(datagrams.size(), 1u);
+    EXPECT_LT(datagrams.size(), 11u);
+    for (const std::string &datagram : datagrams) {
+        EXPECT_LE(datagram.size(), 256u);
+        EXPECT_EQ(datagram.back(), '\n'); // lines are never split across datagrams
+    }
+    EXPECT_NE(datagrams[0].find("] record 0\n"), std::string::npos);
+    EXPECT_NE(datagrams.back().find("] flush\n"), std::string::npos);
+
+    // a full batch goes out on its own
+    std::string line(200, 'x');
+    for (int i = 0; i < 5; ++i) {
+        ACA_LOG_INFO("%s", line.c_str());
+    }
+    EXPECT_EQ(Receive(fd).size(), 4u);
+    acaLogNetFlush();
+    EXPECT_EQ(Receive(fd).size(), 1u);
+
+    acaLogNetClose();
+    acaLogSetHandler(acaLogStandardHandler);
+    close(fd);
+    unlink(address.c_str() + 5);
+}
+
+TEST(log, net_handler_idle_flush) {
+    std::string address = "unix:" + testing::TempDir() + "aca_log_net_idle.sock";
+    int         fd      = acaLogNetBind(address.c_str());
+    ASSERT_GE(fd, 0);
+
+    aca_log_net_config config = ACA_LOG_NET_CONFIG_INIT;
+    config.address            = address.c_str();
+    config.flushInterval      = 0.05;
+    ASSERT_EQ(acaLogNetOpen(&config), 0);
+    acaLogSetHandler(acaLogNetHandler);
+    ACA_LOG_WARN("last words");
+    acaLogSetHandler(acaLogStandardHandler);
+
+    // no further record arrives - the flusher sends the partial batch on its own
+    std::vector<std::string> datagrams;
+    for (int i = 0; (i < 200) && datagrams.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        datagrams = Receive(fd);
+    }
+    ASSERT_EQ(datagrams.size(), 1u);
+    EXPECT_NE(datagrams[0].find("] last words\n"), std::string::npos);
+
+    acaLogNetClose();
+    close(fd);
+    unlink(address.c_str() + 5);
+}
+
+TEST(log, net_handler_drops) {
+    std::string address = "unix:" + testing::TempDir() + "aca_log_net_drop.sock";
+    int         fd      = acaLogNetBind(address.c_str());
+    ASSERT_GE(fd, 0);
+
+    aca_log_net_config config = ACA_LOG_NET_CONFIG_INIT;
+    config.address            = address.c_str();
+    config.datagramSize       = 1024;
+    config.flushInterval      = 0.0;
+    ASSERT_EQ(acaLogNetOpen(&config), 0);
+    acaLogSetHandler(acaLogNetHandler);
+
+    // nobody reads - once the receiver's queue is full, sends fail and records are counted
+    size_t      before = acaLogNetDropped();
+    std::string line(100, 'y');
+    for (int i = 0; (i < 100000) && (acaLogNetDropped() == before); ++i) {
+        ACA_LOG_INFO("%s", line.c_str());
+    }
+    acaLogNetFlush();
+    size_t dropped = acaLogNetDropped() - before;
+    EXPECT_GT(dropped, 0u);
+
+    // the next batch reports how many were lost
+    Receive(fd);
+    ACA_LOG_ERROR("after");
+    std::vector<std::string> datagrams = Receive(fd);
+    ASSERT_FALSE(datagrams.empty());
+    EXPECT_NE(datagrams[0].find("] socket full - dropped "), std::string::npos);
+    EXPECT_NE(datagrams.back().find("] after\n"), std::string::npos);
+
+    acaLogNetClose();
+    acaLogSetHandler(acaLogStandardHandler);
+    close(fd);
+    unlink(address.c_str() + 5);
+}
+
+TEST(log, net_handler_udp) {
+    int fd = acaLogNetBind("udp:127.0.0.1:0");
+    ASSERT_GE(fd, 0);
+    struct sockaddr_in bound;
+    socklen_t          boundLen = sizeof(bound);
+    ASSERT_EQ(getsockname(fd, (struct sockaddr *)&bound, &boundLen), 0);
+    std::string address = "udp:127.0.0.1:" + std::to_string(ntohs(bound.sin_port));
+
+    aca_log_net_config config = ACA_LOG_NET_CONFIG_INIT;
+    config.address            = address.c_str();
+    ASSERT_EQ(acaLogNetOpen(&config), 0);
+    acaLogSetHandler(acaLogNetHandler);
+    ACA_LOG_WARN("over udp %d", 1);
+    ACA_LOG_WARN("over udp %d", 2);
+    acaLogNetClose();
+    acaLogSetHandler(acaLogStandardHandler);
+
+    std::vector<std::string> datagrams = Receive(fd);
+    ASSERT_EQ(datagrams.size(), 1u);
+    EXPECT_NE(datagrams[0].find("] over udp 1\n"), std::string::npos);
+    EXPECT_NE(datagrams[0].find("] over udp 2\n"), std::string::npos);
+    close(fd);
+
+    EXPECT_EQ(acaLogNetBind("tcp:127.0.0.1:1"), -1);
+    config.address = "unix:/nonexistent/dir/aca.sock";
+    EXPECT_EQ(acaLogNetOpen(&config), -1);
+}
@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+// drains the ring into a string, one entry per line
+static std::vector<std::string> Drain(size_t *count = NULL) {
+    FILE  *fp = tmpfile();
+    size_t n  = acaLogShmDrain(fp);
+    if (count != NULL) {
+        *count = n;
+    }
+    std::vector<std::string> lines;
+    char                     buffer[1024];
+    rewind(fp);
+    while (fgets(buffer, sizeof(buffer), fp) != NULL) {
+        lines.push_back(buffer);
+    }
+    fclose(fp);
+    return lines;
+}
+
+static std::string CreateRing(const char *name, size_t capacity) {
+    std::string        path   = testing::TempDir() + name;
+    aca_log_shm_config config = ACA_LOG_SHM_CONFIG_INIT;
+    config.path               = path.c_str();
+    config.capacity           = capacity;
+    EXPECT_EQ(acaLogShmCreate(&config), 0);
+    return path;
+}
+
+TEST(log, shm_round_trip) {
+    std::string path = CreateRing("aca_log_shm_round_trip.ring", 16);
+    acaLogSetHandler(acaLogShmHandler);
+    int line = __LINE__ + 1;
+    ACA_LOG_INFO("hello %s", "ring");
+    ACA_LOG_ERROR("code %d", 7);
+    acaLogSetHandler(acaLogStandardHandler);
+
+    size_t                   count = 0;
+    std::vector<std::string> lines = Drain(&count);
+    EXPECT_EQ(count, 2u);
+    std::string pid = "[" + std::to_string(getpid()) + "] ";
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0].find("[aca_log_test] [ INFO] ["), 0u);
+    EXPECT_NE(lines[0].find(" test_shm.cpp:" + std::to_string(line) + "] " + pid + "hello ring\n"),
+              std::string::npos);
+    EXPECT_NE(lines[1].find("[ERROR] ["), std::string::npos);
+    EXPECT_NE(lines[1].find(pid + "code 7\n"), std::string::npos);
+    EXPECT_TRUE(Drain().empty());
+
+    // a second mapping of the same ring sees the same queue
+    ASSERT_EQ(acaLogShmAttach(path.c_str()), 0);
+    acaLogSetHandler(acaLogShmHandler);
+    ACA_LOG_WARN("after attach");
+    acaLogSetHandler(acaLogStandardHandler);
+    lines = Drain();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find(pid + "after attach\n"), std::string::npos);
+
+    // anything that isn't a ring is refused
+    acaLogShmDetach();
+    std::string bogus = testing::TempDir() + "aca_log_shm_bogus.ring";
+    FILE       *fp    = fopen(bogus.c_str(), "w");
+    fputs(std::string(4096, 'x').c_str(), fp);
+    fclose(fp);
+    EXPECT_EQ(acaLogShmAttach(bogus.c_str()), -1);
+    EXPECT_EQ(acaLogShmAttach((testing::TempDir() + "aca_log_shm_missing.ring").c_str()), -1);
+    std::remove(bogus.c_str());
+    std::remove(path.c_str());
+}
+
+TEST(log, shm_full) {
+    std::string path = CreateRing("aca_log_shm_full.ring", 4);
+    acaLogSetHandler(acaLogShmHandler);
+    for (int i = 0; i < 6; ++i) {
+        ACA_LOG_INFO("record %d", i);
+    }
+    acaLogSetHandler(acaLogStandardHandler);
+    EXPECT_EQ(acaLogShmDropped(), 2u);
+
+    std::vector<std::string> lines = Drain();
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_NE(lines[3].find("record 3\n"), std::string::npos);
+    EXPECT_NE(lines[4].find("shm ring full - dropped 2 record(s)\n"), std::string::npos);
+    acaLogShmDetach();
+    std::remove(path.c_str());
+}
+
+TEST(log, shm_processes) {
+    std::string path = CreateRing("aca_log_shm_processes.ring", 256);
+
+    // forked workers inherit the mapping, the collector drains while they write
+    const int        workers = 4;
+    const int        records = 2000;
+    std::vector<int> pids;
+    for (int w = 0; w < workers; ++w) {
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            acaLogSetHandler(acaLogShmHandler);
+            for (int i = 0; i < records; ++i) {
+                ACA_LOG_INFO("worker %d record %d", w, i);
+                if ((i % 64) == 63) {
+                    usleep(200); // let the collector keep up with the small ring
+                }
+            }
+            _exit(0);
+        }
+        pids.push_back(pid);
+    }
+
+    std::vector<std::string> lines;
+    int                      running = workers;
+    while (running > 0) {
+        std::vector<std::string> drained = Drain();
+        lines.insert(lines.end(), drained.begin(), drained.end());
+        int status;
+        while (waitpid(-1, &status, WNOHANG) > 0) {
+            --running;
+        }
+    }
+    std::vector<std::string> drained = Drain();
+    lines.insert(lines.end(), drained.begin(), drained.end());
+
+    // every record arrives once (unless dropped), in order per worker
+    std::map<int, int> next;
+    size_t             received = 0;
+    for (const std::string &line : lines) {
+        int    w   = -1;
+        int    i   = -1;
+        size_t pos = line.find("] worker ");
+        if ((pos != std::string::npos) &&
+            (sscanf(line.c_str() + pos, "] worker %d record %d", &w, &i) == 2)) {
+            EXPECT_GE(i, next[w]);
+            next[w] = i + 1;
+            ++received;
+        }
+    }
+    EXPECT_EQ(next.size(), (size_t)workers);
+    EXPECT_EQ(received + acaLogShmDropped(), (size_t)(workers * records));
+    acaLogShmDetach();
+    std::remove(path.c_str());
+}
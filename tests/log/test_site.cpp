@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static const int kSiteLine = __LINE__ + 3;
+
+static void LogFromSite(int value) {
+    ACA_LOG_INFO("site value %d", value);
+}
+
+static const aca_log_site *FindSite(const char *fmt) {
+    for (const aca_log_site *site = acaLogSites(); site != NULL; site = site->next) {
+        if ((site->fmt != NULL) && (strcmp(site->fmt, fmt) == 0)) {
+            return site;
+        }
+    }
+    return NULL;
+}
+
+TEST(log, site_registry) {
+    acaLogSetHandler(acaLogBasicHandler);
+    testing::internal::CaptureStdout();
+    LogFromSite(1);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ INFO] site value 1\n");
+
+    // the site registered itself on its first call
+    const aca_log_site *site = FindSite("site value %d");
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(site->level, ACA_LOG_INFO);
+    EXPECT_EQ(site->line, kSiteLine);
+    EXPECT_STREQ(site->fileName, "test_site.cpp");
+    EXPECT_EQ(site->fileLine, "test_site.cpp:" + std::to_string(kSiteLine));
+
+    // switch that one statement off and on again
+    EXPECT_EQ(acaLogSiteEnable("test_site.cpp", kSiteLine, 0), 1u);
+    testing::internal::CaptureStdout();
+    LogFromSite(2);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_EQ(acaLogSiteEnable("log/test_site.cpp", kSiteLine, 1), 1u);
+    // only whole path components match
+    EXPECT_EQ(acaLogSiteEnable("est_site.cpp", kSiteLine, 0), 0u);
+    testing::internal::CaptureStdout();
+    LogFromSite(3);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "[ INFO] site value 3\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+TEST(log, site_rule_before_registration) {
+    acaLogSetHandler(acaLogBasicHandler);
+
+    // rules also apply to sites that haven't run yet
+    int line = __LINE__ + 3;
+    EXPECT_EQ(acaLogSiteEnable("test_site.cpp", line, 0), 0u);
+    testing::internal::CaptureStdout();
+    ACA_LOG_WARN("not yet registered");
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    ASSERT_NE(FindSite("not yet registered"), nullptr);
+
+    // line 0 covers the whole file
+    EXPECT_GE(acaLogSiteEnable("test_site.cpp", 0, 1), 2u);
+    testing::internal::CaptureStdout();
+    ACA_LOG_WARN("another site");
+    LogFromSite(4);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(),
+              "[ WARN] another site\n[ INFO] site value 4\n");
+    acaLogSetHandler(acaLogStandardHandler);
+}
+
+// runs in a child process - the filled rule table would stay around for the other tests
+static void FillSiteRules() {
+    size_t ret = 0;
+    for (int line = 1; (ret != (size_t)-1) && (line <= 100000); ++line) {
+        ret = acaLogSiteEnable("no_such_file.c", line, 0); // a file without sites
+    }
+    // a new rule is refused without touching the sites, repeating an existing one still works
+    bool ok = (ret == (size_t)-1) &&
+              (acaLogSiteEnable("test_site.cpp", kSiteLine + 1, 0) == (size_t)-1) &&
+              (acaLogSiteEnable("no_such_file.c", 1, 1) == 0);
+    exit(ok ? 0 : 1);
+}
+
+TEST(log, site_rules_full) {
+    EXPECT_EXIT(FillSiteRules(), testing::ExitedWithCode(0), "");
+}
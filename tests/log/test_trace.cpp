@@ -0,0 +1,208 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aca_log.h"
+#include "gtest/gtest.h"
+
+static std::vector<std::string> ReadLines(const std::string &path) {
+    std::vector<std::string> lines;
+    FILE                    *fp = fopen(path.c_str(), "r");
+    EXPECT_NE(fp, nullptr);
+    char buffer[2048];
+    while ((fp != NULL) && (fgets(buffer, sizeof(buffer), fp) != NULL)) {
+        lines.push_back(buffer);
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    return lines;
+}
+
+// raw JSON value of a key in a single-line event ("" if missing)
+static std::string Field(const std::string &event, const std::string &key) {
+    size_t pos = event.find("\"" + key + "\":");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += key.size() + 3;
+    size_t end = pos;
+    if (event[pos] == '"') {
+        for (end = pos + 1; event[end] != '"'; ++end) {
+            end += (event[end] == '\\');
+        }
+        ++end;
+    } else {
+        end = event.find_first_of(",}", pos);
+    }
+    return event.substr(pos, end - pos);
+}
+
+TEST(log, trace_spans) {
+    std::string path = testing::TempDir() + "aca_log_trace_spans.json";
+    ACA_LOG_SPAN_BEGIN("dropped"); // nothing is recorded while no trace is open
+    ASSERT_EQ(acaLogTraceOpen(path.c_str()), 0);
+    ACA_LOG_SPAN_BEGIN("outer");
+    ACA_LOG_COUNTER("queue depth", 3);
+    {
+        ACA_LOG_SPAN("inner \"quoted\"");
+        ACA_LOG_COUNTER("queue depth", 2.5);
+    }
+    ACA_LOG_SPAN_END("outer");
+    acaLogTraceClose();
+    ACA_LOG_SPAN_END("dropped");
+
+    std::vector<std::string> lines = ReadLines(path);
+    ASSERT_EQ(lines.size(), 9u);
+    EXPECT_EQ(lines.front(), "[\n");
+    EXPECT_EQ(lines.back(), "]\n");
+    const char *expected[][3] = {{"\"outer\"", "\"B\"", ""},
+                                 {"\"queue depth\"", "\"C\"", "3"},
+                                 {"\"inner \\\"quoted\\\"\"", "\"B\"", ""},
+                                 {"\"queue depth\"", "\"C\"", "2.5"},
+                                 {"\"inner \\\"quoted\\\"\"", "\"E\"", ""},
+                                 {"\"outer\"", "\"E\"", ""}};
+    double      lastTs        = 0.0;
+    for (size_t i = 0; i < 6; ++i) {
+        const std::string &event = lines[i + 1];
+        EXPECT_EQ(Field(event, "name"), expected[i][0]) << event;
+        EXPECT_EQ(Field(event, "ph"), expected[i][1]) << event;
+        EXPECT_EQ(Field(event, "value"), expected[i][2]) << event;
+        EXPECT_EQ(Field(event, "tid"), Field(lines[1], "tid"));
+        EXPECT_EQ(event.substr(event.size() - 3), "},\n");
+        double ts = strtod(Field(event, "ts").c_str(), NULL);
+        EXPECT_GE(ts, lastTs);
+        lastTs = ts;
+    }
+    EXPECT_EQ(Field(lines[7], "ph"), "\"M\"");
+    EXPECT_EQ(lines[7].substr(lines[7].size() - 3), "}}\n");
+    std::remove(path.c_str());
+}
+
+TEST(log, trace_threads) {
+    std::string path = testing::TempDir() + "aca_log_trace_threads.json";
+    ASSERT_EQ(acaLogTraceOpen(path.c_str()), 0);
+
+    // staged events of exiting threads are handed to the file, buffers that fill up are flushed
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < 5000; ++i) {
+                ACA_LOG_SPAN("work");
+                ACA_LOG_COUNTER("i", i);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    acaLogTraceClose();
+
+    std::vector<std::string> lines = ReadLines(path);
+    ASSERT_EQ(lines.size(), 4u * 5000u * 3u + 3u);
+    std::map<std::string, int> depth;
+    std::map<std::string, int> counters;
+    for (size_t i = 1; i + 2 < lines.size(); ++i) {
+        std::string tid   = Field(lines[i], "tid");
+        std::string phase = Field(lines[i], "ph");
+        if (phase == "\"B\"") {
+            EXPECT_EQ(depth[tid]++, 0);
+        } else if (phase == "\"E\"") {
+            EXPECT_EQ(--depth[tid], 0);
+        } else {
+            EXPECT_EQ(Field(lines[i], "value"), std::to_string(counters[tid]++));
+        }
+    }
+    EXPECT_EQ(depth.size(), 4u);
+    std::remove(path.c_str());
+}
+
+TEST(log, trace_handler) {
+    std::string path = testing::TempDir() + "aca_log_trace_handler.json";
+    ASSERT_EQ(acaLogTraceOpen(path.c_str()), 0);
+    acaLogSetHandler(acaLogTraceHandler);
+    ACA_LOG_SPAN_BEGIN("request");
+    int line = __LINE__ + 1;
+    ACA_LOG_WARN("retry %d of %s", 2, "upload");
+    ACA_LOG_SPAN_END("request");
+    acaLogSetHandler(acaLogStandardHandler);
+    acaLogTraceClose();
+
+    std::vector<std::string> lines = ReadLines(path);
+    ASSERT_EQ(lines.size(), 6u);
+    EXPECT_EQ(Field(lines[2], "name"), "\"retry 2 of upload\"");
+    EXPECT_EQ(Field(lines[2], "ph"), "\"i\"");
+    EXPECT_EQ(Field(lines[2], "s"), "\"t\"");
+    EXPECT_EQ(Field(lines[2], "level"), "\"WARN\"");
+    EXPECT_EQ(Field(lines[2], "file"), "\"test_trace.cpp\"");
+    EXPECT_EQ(Field(lines[2], "line"), std::to_string(line));
+    std::remove(path.c_str());
+}
+
+TEST(log, trace_reopen) {
+    std::string first  = testing::TempDir() + "aca_log_trace_first.json";
+    std::string second = testing::TempDir() + "aca_log_trace_second.json";
+    ASSERT_EQ(acaLogTraceOpen(first.c_str()), 0);
+    ACA_LOG_COUNTER("before", 1);
+    ASSERT_EQ(acaLogTraceOpen(second.c_str()), 0); // closes the first trace like acaLogTraceClose
+    ACA_LOG_COUNTER("after", 2);
+    acaLogTraceClose();
+
+    std::vector<std::string> lines = ReadLines(first);
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(Field(lines[1], "name"), "\"before\"");
+    EXPECT_EQ(Field(lines[2], "ph"), "\"M\"");
+    EXPECT_EQ(lines[3], "]\n");
+    lines = ReadLines(second);
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(Field(lines[1], "name"), "\"after\"");
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+}
+
+TEST(log, trace_close_flushes_live_threads) {
+    std::string path = testing::TempDir() + "aca_log_trace_live.json";
+    ASSERT_EQ(acaLogTraceOpen(path.c_str()), 0);
+
+    // a thread that is still running keeps its events staged - close must collect them
+    std::atomic<int> state(0);
+    std::thread      worker([&state]() {
+        ACA_LOG_COUNTER("live", 7);
+        state = 1;
+        while (state != 2) {
+            std::this_thread::yield();
+        }
+    });
+    while (state != 1) {
+        std::this_thread::yield();
+    }
+    acaLogTraceClose();
+    state = 2;
+    worker.join();
+
+    std::vector<std::string> lines = ReadLines(path);
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(Field(lines[1], "name"), "\"live\"");
+    EXPECT_EQ(Field(lines[1], "value"), "7");
+    std::remove(path.c_str());
+}
+
+TEST(log, trace_large_counters) {
+    std::string path = testing::TempDir() + "aca_log_trace_large.json";
+    ASSERT_EQ(acaLogTraceOpen(path.c_str()), 0);
+    ACA_LOG_COUNTER("bytes", 5e13);
+    ACA_LOG_COUNTER("bytes", 1e14);
+    ACA_LOG_COUNTER("bytes", -2.5e13);
+    acaLogTraceClose();
+
+    std::vector<std::string> lines = ReadLines(path);
+    ASSERT_EQ(lines.size(), 6u);
+    EXPECT_EQ(Field(lines[1], "value"), "50000000000000");
+    EXPECT_EQ(Field(lines[2], "value"), "100000000000000");
+    EXPECT_EQ(Field(lines[3], "value"), "-25000000000000");
+    std::remove(path.c_str());
+}
@@ -0,0 +1,53 @@
+// shared-memory log collector - creates the ring that acaLogShmHandler writers attach to and drains
+// it to stdout until ctrl+c, then removes the ring file
+#define ACA_LOG_IMPLEMENTATION
+#include "aca_log.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void OnSignal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+int main(int argc, char *argv[]) {
+    if ((argc < 2) || (argc > 3)) {
+        fprintf(stderr, "[Usage]: aca_log_collect <ring path (e.g. /dev/shm/app.ring)> [slots]\n");
+        return 1;
+    }
+
+    aca_log_shm_config config = ACA_LOG_SHM_CONFIG_INIT;
+    config.path               = argv[1];
+    if (argc == 3) {
+        config.capacity = (size_t)strtoul(argv[2], NULL, 0);
+    }
+    if (acaLogShmCreate(&config) != 0) {
+        fprintf(stderr, "ERROR - failed to create [ %s ]\n", argv[1]);
+        return 1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    unsigned long long lines = 0;
+    while (!g_stop) {
+        size_t n = acaLogShmDrain(stdout);
+        if (n == 0) {
+            usleep(1000);
+        }
+        lines += n;
+    }
+    lines += acaLogShmDrain(stdout);
+    fprintf(stderr, "%llu line(s), %lu dropped\n", lines, (unsigned long)acaLogShmDropped());
+    acaLogShmDetach();
+    unlink(argv[1]);
+    return 0;
+}
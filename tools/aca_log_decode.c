@@ -0,0 +1,27 @@
+// renders binary logs written by ACA_LOG_BINARY / acaLogBinary as standard log lines
+#define ACA_LOG_CHOP_FILEPATH
+#define ACA_LOG_DISABLE_STANDARD_HANDLER_LEVEL_COLORS
+#define ACA_LOG_IMPLEMENTATION
+#include "aca_log.h"
+
+#include <stdio.h>
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "[Usage]: aca_log_decode <binary log file>\n");
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "ERROR - failed to open [ %s ]\n", argv[1]);
+        return 1;
+    }
+    int ret = acaLogBinaryDecode(in, stdout);
+    fclose(in);
+    if (ret != 0) {
+        fprintf(stderr, "ERROR - [ %s ] is truncated or not a binary log\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
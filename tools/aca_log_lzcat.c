@@ -0,0 +1,40 @@
+// prints the text of compressed logs written by acaLogLzHandler - an optional byte offset starts at
+// the first intact frame after it (negative counts from the end, e.g. -1048576 tails the last MiB)
+#define ACA_LOG_IMPLEMENTATION
+#include "aca_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]) {
+    if ((argc != 2) && (argc != 3)) {
+        fprintf(stderr, "[Usage]: aca_log_lzcat <compressed log file> [start offset]\n");
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "ERROR - failed to open [ %s ]\n", argv[1]);
+        return 1;
+    }
+    if (argc == 3) {
+        long long offset = strtoll(argv[2], NULL, 0);
+        acaLogIndexSeek(in, 0, SEEK_END);
+        long long size = (long long)acaLogIndexTell(in); // 64-bit, compressed logs outgrow a long
+        if (offset < 0) {
+            offset = (-offset < size) ? size + offset : 0;
+        }
+        acaLogIndexSeek(in, (uint64_t)((offset < size) ? offset : size), SEEK_SET);
+        if ((offset > 0) && (acaLogLzSync(in) < 0)) {
+            fclose(in);
+            return 0; // no frame starts after the offset
+        }
+    }
+    int ret = acaLogLzDecode(in, stdout);
+    fclose(in);
+    if (ret != 0) {
+        fprintf(stderr, "ERROR - [ %s ] has damaged or truncated frames (skipped)\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+// prints the records of a standard format log within a time range at/above a level. <log>.idx is
+// used to skip the blocks that can't match - without one the whole log is scanned. the range is in
+// unix time for an index kept by acaLogStandardFileHandler, else in seconds as in the [%10.4f]
+// field (an index built by --index, or none). --index (re)builds the index of an existing log
+#define ACA_LOG_IMPLEMENTATION
+#include "aca_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int ParseLevel(const char *name, aca_log_level *level) {
+    const char *names[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+    for (int i = 0; i < 6; ++i) {
+        if (strcmp(name, names[i]) == 0) {
+            *level = (aca_log_level)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int BuildIndex(const char *path, const char *indexPath, size_t blockBytes) {
+    FILE *log   = fopen(path, "rb");
+    FILE *index = fopen(indexPath, "wb");
+    int   ret   = -1;
+    if ((log != NULL) && (index != NULL)) {
+        ret = acaLogIndexBuild(log, index, blockBytes);
+    }
+    if (log != NULL) {
+        fclose(log);
+    }
+    if (index != NULL) {
+        fclose(index);
+    }
+    if (ret != 0) {
+        fprintf(stderr, "ERROR - failed to index [ %s ] into [ %s ]\n", path, indexPath);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    aca_log_level level = ACA_LOG_TRACE;
+    char          indexPath[512];
+    if ((argc >= 3) && (argc <= 4) && (strcmp(argv[1], "--index") == 0)) {
+        snprintf(indexPath, sizeof(indexPath), "%s.idx", argv[2]);
+        size_t blockBytes = (argc == 4) ? strtoul(argv[3], NULL, 0) * 1024 : 0;
+        return BuildIndex(argv[2], indexPath, blockBytes);
+    }
+    if ((argc < 4) || (argc > 5) || ((argc == 5) && (ParseLevel(argv[4], &level) != 0))) {
+        fprintf(stderr, "[Usage]: aca_log_query <log file> <from> <to> [TRACE|DEBUG|...|FATAL]\n");
+        fprintf(stderr, "         aca_log_query --index <log file> [block KiB]\n");
+        return 1;
+    }
+
+    FILE *log = fopen(argv[1], "rb");
+    if (log == NULL) {
+        fprintf(stderr, "ERROR - failed to open [ %s ]\n", argv[1]);
+        return 1;
+    }
+    snprintf(indexPath, sizeof(indexPath), "%s.idx", argv[1]);
+    FILE  *index   = fopen(indexPath, "rb");
+    size_t scanned = 0;
+    double from    = strtod(argv[2], NULL);
+    double to      = strtod(argv[3], NULL);
+    long   records = acaLogIndexQuery(log, index, from, to, level, stdout, &scanned);
+    if (records < 0) {
+        fprintf(stderr, "WARN - [ %s ] doesn't match the log, scanning all of it\n", indexPath);
+        records = acaLogIndexQuery(log, NULL, from, to, level, stdout, &scanned);
+    }
+    fseek(log, 0, SEEK_END);
+    fprintf(stderr, "%ld record(s), scanned %zu of %ld bytes\n", records, scanned, ftell(log));
+    if (index != NULL) {
+        fclose(index);
+    }
+    fclose(log);
+    return 0;
+}
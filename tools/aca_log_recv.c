@@ -0,0 +1,55 @@
+// stand-in for a node-local log collector - prints every datagram received on the address (as
+// used by acaLogNetHandler) and a datagram/byte count on exit (ctrl+c)
+#define ACA_LOG_IMPLEMENTATION
+#include "aca_log.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void OnSignal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "[Usage]: aca_log_recv <unix:/path/to.sock | udp:host:port>\n");
+        return 1;
+    }
+
+    int fd = acaLogNetBind(argv[1]);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR - failed to bind [ %s ]\n", argv[1]);
+        return 1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnSignal; // no SA_RESTART - recv returns on ctrl+c
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    static char        buffer[65536];
+    unsigned long long datagrams = 0;
+    unsigned long long bytes     = 0;
+    while (!g_stop) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0) {
+            continue;
+        }
+        fwrite(buffer, 1, (size_t)n, stdout);
+        ++datagrams;
+        bytes += (unsigned long long)n;
+    }
+    fflush(stdout);
+    fprintf(stderr, "%llu datagram(s), %llu byte(s)\n", datagrams, bytes);
+    close(fd);
+    if (strncmp(argv[1], "unix:", 5) == 0) {
+        unlink(argv[1] + 5);
+    }
+    return 0;
+}